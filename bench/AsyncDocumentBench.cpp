@@ -0,0 +1,146 @@
+// Render-thread frame times on a long text page at 1920x1080 while it is scrolled and
+// restyled every 30 frames (a class on the page changes the margins of all 100000
+// paragraphs, forcing a restyle and relayout). The render side of a frame is what stays on
+// the render thread in VulkanEngine: picking up layers, text painting, instance diffs of
+// repainted layers and compositing. Inline, the frame also waits for the document work, as
+// when it ran on the render thread; with DocumentWorker it only takes the latest snapshot.
+// GPU uploads, command recording and present are not in it: VulkanEngine logs the time from
+// applying a snapshot to the present of its frame ("Snapshot apply-to-present time").
+#include "BenchUtils.hpp"
+#include "document/Document.hpp"
+#include "document/DocumentWorker.hpp"
+#include "render/InstanceCache.hpp"
+#include "render/LayerTree.hpp"
+#include "text/TextPainter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static const float WIDTH = 1920.0f, HEIGHT = 1080.0f;
+static const int FRAMES = 300;
+static const int MUTATION_INTERVAL = 30;
+static const float STEP = 12.0f;
+static const std::chrono::microseconds FRAME_BUDGET(8000);
+
+static std::string textHtml(int paragraphs, int wordsPerParagraph) {
+    static const char* words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "layout", "vulkan", "glyph",
+                                  "atlas", "render", "frame", "cache", "text", "box", "style", "node"};
+    std::string html = "<div id=\"page\" class=\"page\">";
+    uint32_t seed = 12345;
+    for (int p = 0; p < paragraphs; ++p) {
+        html += "<p class=\"t" + std::to_string(p % 4) + "\">";
+        for (int w = 0; w < wordsPerParagraph; ++w) {
+            seed = seed * 1664525u + 1013904223u;
+            if (w) html += ' ';
+            html += words[(seed >> 16) % 16];
+        }
+        html += "</p>";
+    }
+    return html + "</div>";
+}
+
+// Что остаётся в потоке отрисовки: глифы и диффы инстансов перерисованных слоёв, размещение квадов
+struct RenderSide {
+    struct LayerCache {
+        InstanceCache instances;
+        std::shared_ptr<const DisplayList> content;
+    };
+    LayerTree compositor;
+    TextPainter painter;
+    std::unordered_map<const StyledNode*, LayerCache> caches;
+    std::vector<CompositeQuad> quads;
+    std::vector<Rect> damage;
+    size_t snapshots = 0;
+
+    void apply(const DocumentSnapshot& snapshot) {
+        snapshots++;
+        compositor.setLayers(snapshot.layers);
+        for (const Layer& layer : snapshot.layers) {
+            if (!layer.content) continue;
+            LayerCache& cache = caches[layer.owner];
+            if (cache.content == layer.content) continue;
+            std::vector<GlyphQuad> glyphs;
+            painter.paint(layer.content->texts, glyphs);
+            cache.instances.update(*layer.content, glyphs);
+            cache.content = layer.content;
+        }
+    }
+    void composite(float scrollY) { compositor.composite({0.0f, scrollY, WIDTH, HEIGHT}, quads, damage); }
+};
+
+struct FrameStats {
+    double mean = 0.0, p50 = 0.0, p99 = 0.0, max = 0.0, stddev = 0.0;
+    size_t missed = 0; // Frames over budget
+};
+
+static FrameStats summarize(std::vector<double> ms) {
+    FrameStats stats;
+    for (double t : ms) stats.mean += t;
+    stats.mean /= ms.size();
+    for (double t : ms) {
+        stats.stddev += (t - stats.mean) * (t - stats.mean);
+        if (t > FRAME_BUDGET.count() / 1000.0) stats.missed++;
+    }
+    stats.stddev = std::sqrt(stats.stddev / ms.size());
+    std::sort(ms.begin(), ms.end());
+    stats.p50 = ms[ms.size() / 2];
+    stats.p99 = ms[std::min(ms.size() - 1, ms.size() * 99 / 100)];
+    stats.max = ms.back();
+    return stats;
+}
+
+static void print(const char* name, const FrameStats& s, size_t snapshots) {
+    std::printf("\n[%s]\n", name);
+    std::printf("%-40s %12.3f ms\n", "frame mean", s.mean);
+    std::printf("%-40s %12.3f ms\n", "frame p50", s.p50);
+    std::printf("%-40s %12.3f ms\n", "frame p99", s.p99);
+    std::printf("%-40s %12.3f ms\n", "frame max", s.max);
+    std::printf("%-40s %12.3f ms\n", "jitter (stddev)", s.stddev);
+    std::printf("%-40s %12zu of %d\n", "frames over 8 ms budget", s.missed, FRAMES);
+    std::printf("%-40s %12zu\n", "snapshots applied", snapshots);
+}
+
+// inline: кадр ждёт, пока документ применит всё отправленное, — как при работе в потоке отрисовки
+static void run(const char* name, const std::string& html, const std::string& css, bool inlineDocument) {
+    DocumentWorker worker(html, css, WIDTH, HEIGHT);
+    worker.waitIdle();
+    RenderSide render;
+    worker.consume();
+    render.apply(worker.snapshot());
+
+    std::vector<double> frameMs;
+    float scrollY = 0.0f;
+    auto nextFrame = bench::Clock::now();
+    for (int f = 0; f < FRAMES; ++f) {
+        auto start = bench::Clock::now();
+        if (f % MUTATION_INTERVAL == MUTATION_INTERVAL - 1) {
+            worker.post([](Document& document) { document.toggleClass(*document.getElementById("page"), "loose"); });
+        }
+        scrollY += STEP;
+        worker.scrollTo(scrollY, 0.0f);
+        if (inlineDocument) worker.waitIdle();
+        worker.checkFailure();
+        if (worker.consume()) render.apply(worker.snapshot());
+        render.composite(scrollY);
+        std::chrono::duration<double, std::milli> elapsed = bench::Clock::now() - start;
+        frameMs.push_back(elapsed.count());
+
+        nextFrame = std::max(nextFrame + FRAME_BUDGET, bench::Clock::now());
+        std::this_thread::sleep_until(nextFrame);
+    }
+    worker.waitIdle();
+    print(name, summarize(frameMs), render.snapshots);
+}
+
+int main() {
+    std::string html = textHtml(100000, 24);
+    std::string css = bench::generateTextCss() + ".loose p { margin-bottom: 12px; }\n";
+    run("document work inline on the render thread", html, css, true);
+    run("document worker thread, snapshot handoff", html, css, false);
+    return 0;
+}
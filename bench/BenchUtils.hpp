@@ -0,0 +1,215 @@
+#pragma once
+
+#include "parser/DomNode.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+// Small helpers shared by the benchmark programs in bench/.
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+// Runs fn `iterations` times and returns the mean wall time per call in milliseconds.
+template <typename Fn>
+double timeMs(Fn&& fn, int iterations = 1) {
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) fn();
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+// A flat page of `rows` rows with `cellsPerRow` cells each; every cell gets an id and
+// one of ten classes so benchmarks can address and restyle individual elements.
+inline std::string generateGridHtml(int rows, int cellsPerRow) {
+    std::string html = "<div class=\"page\">";
+    for (int r = 0; r < rows; ++r) {
+        html += "<div class=\"row\">";
+        for (int c = 0; c < cellsPerRow; ++c) {
+            int n = r * cellsPerRow + c;
+            html += "<div id=\"n" + std::to_string(n) + "\" class=\"cell c" + std::to_string(n % 10) + "\"></div>";
+        }
+        html += "</div>";
+    }
+    html += "</div>";
+    return html;
+}
+
+// Same shape as generateGridHtml, built directly as a DOM to skip parsing on huge inputs.
+inline std::unique_ptr<DomNode> generateGridDom(int rows, int cellsPerRow) {
+    auto page = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+    page->attributes["class"] = "page";
+    for (int r = 0; r < rows; ++r) {
+        auto row = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+        row->attributes["class"] = "row";
+        row->parent = page.get();
+        for (int c = 0; c < cellsPerRow; ++c) {
+            int n = r * cellsPerRow + c;
+            auto cell = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+            cell->attributes["id"] = "n" + std::to_string(n);
+            cell->attributes["class"] = "cell c" + std::to_string(n % 10);
+            cell->parent = row.get();
+            row->children.push_back(std::move(cell));
+        }
+        page->children.push_back(std::move(row));
+    }
+    return page;
+}
+
+inline std::string generateGridCss() {
+    std::string css =
+        ".page { padding: 8px; background: #202020; }\n"
+        ".row { padding: 2px; background: #303030; }\n"
+        ".cell { height: 4px; margin-top: 1px; background: #404040; }\n"
+        ".selected { background: #ff8800; }\n"
+        ".expanded { height: 40px; }\n";
+    for (int i = 0; i < 10; ++i) {
+        css += ".c" + std::to_string(i) + " { margin-bottom: " + std::to_string(i % 3) + "px; }\n";
+    }
+    return css;
+}
+
+// A page of `paragraphs` <p> elements holding pseudo-random sentences over a small
+// vocabulary, so text repeats the way it does on real pages.
+inline std::unique_ptr<DomNode> generateTextDom(int paragraphs, int wordsPerParagraph) {
+    static const char* words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "layout", "vulkan", "glyph",
+                                  "atlas", "render", "frame", "cache", "text", "box", "style", "node"};
+    auto page = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+    page->attributes["class"] = "page";
+    uint32_t seed = 12345;
+    for (int p = 0; p < paragraphs; ++p) {
+        auto paragraph = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "p");
+        paragraph->attributes["class"] = "t" + std::to_string(p % 4);
+        paragraph->parent = page.get();
+        std::string sentence;
+        for (int w = 0; w < wordsPerParagraph; ++w) {
+            seed = seed * 1664525u + 1013904223u;
+            if (w) sentence += ' ';
+            sentence += words[(seed >> 16) % 16];
+        }
+        auto text = std::make_unique<DomNode>(NodeType::TEXT_NODE, sentence);
+        text->parent = paragraph.get();
+        paragraph->children.push_back(std::move(text));
+        page->children.push_back(std::move(paragraph));
+    }
+    return page;
+}
+
+inline std::string generateTextCss() {
+    return ".page { padding: 8px; background: #202020; color: #e0e0e0; }\n"
+           "p { margin-bottom: 4px; }\n"
+           ".t0 { font-size: 12px; }\n"
+           ".t1 { font-size: 14px; }\n"
+           ".t2 { font-size: 16px; }\n"
+           ".t3 { font-size: 20px; color: #ffcc00; }\n";
+}
+
+// Synthetic documents of a given shape for the stage benchmarks. Element i gets class
+// "c<i % ruleCount>", so every generated rule of generateRulesCss(ruleCount) matches.
+
+// `chains` chains of nested divs, `depth` levels each, with text at the bottom.
+inline std::string generateDeepHtml(int chains, int depth, int ruleCount) {
+    std::string html = "<div class=\"page\">";
+    int n = 0;
+    for (int c = 0; c < chains; ++c) {
+        for (int d = 0; d < depth; ++d) html += "<div class=\"c" + std::to_string(n++ % ruleCount) + "\">";
+        html += "deep text";
+        for (int d = 0; d < depth; ++d) html += "</div>";
+    }
+    return html + "</div>";
+}
+
+// One parent with `children` paragraphs of text.
+inline std::string generateWideHtml(int children, int ruleCount) {
+    std::string html = "<div class=\"page\">";
+    for (int i = 0; i < children; ++i) html += "<p class=\"c" + std::to_string(i % ruleCount) + "\">wide text " + std::to_string(i) + "</p>";
+    return html + "</div>";
+}
+
+// A table of `rows` x `cols` cells, each with an id and a short text.
+inline std::string generateTableHtml(int rows, int cols, int ruleCount) {
+    std::string html = "<div class=\"page\"><table>";
+    int n = 0;
+    for (int r = 0; r < rows; ++r) {
+        html += "<tr class=\"c" + std::to_string(n++ % ruleCount) + "\">";
+        for (int c = 0; c < cols; ++c) {
+            html += "<td id=\"r" + std::to_string(r) + "c" + std::to_string(c) + "\" class=\"c" + std::to_string(n++ % ruleCount) + "\">" +
+                    std::to_string(r * cols + c) + "</td>";
+        }
+        html += "</tr>";
+    }
+    return html + "</table></div>";
+}
+
+// `nodes` flat divs with `classesPerNode` classes each, so matching dominates styling.
+inline std::string generateClassHeavyHtml(int nodes, int classesPerNode, int ruleCount) {
+    std::string html = "<div class=\"page\">";
+    for (int i = 0; i < nodes; ++i) {
+        html += "<div class=\"";
+        for (int k = 0; k < classesPerNode; ++k) {
+            if (k) html += ' ';
+            html += "c" + std::to_string((i * 7 + k * 131) % ruleCount);
+        }
+        html += "\">x</div>";
+    }
+    return html + "</div>";
+}
+
+// `ruleCount` class rules .c0 .. .c<ruleCount - 1> with a mix of box, color and text properties.
+inline std::string generateRulesCss(int ruleCount) {
+    std::string css = ".page { padding: 8px; background: #202020; color: #e0e0e0; }\n";
+    for (int i = 0; i < ruleCount; ++i) {
+        css += ".c" + std::to_string(i) + " { margin-bottom: " + std::to_string(i % 4) + "px; padding: " + std::to_string(i % 3) +
+               "px; background: #" + (i % 2 ? "303030" : "404040") + "; font-size: " + std::to_string(12 + i % 8) + "px; }\n";
+    }
+    return css;
+}
+
+// Current resident set size in MiB (Linux /proc), or 0 if unavailable.
+inline double residentMemoryMB() {
+    FILE* status = std::fopen("/proc/self/status", "r");
+    if (!status) return 0.0;
+    char line[256];
+    long kb = 0;
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, "VmRSS:", 6) == 0) {
+            std::sscanf(line + 6, "%ld", &kb);
+            break;
+        }
+    }
+    std::fclose(status);
+    return kb / 1024.0;
+}
+
+// Peak resident set size in MiB since start or the last resetPeakMemory() (Linux /proc).
+inline double peakMemoryMB() {
+    FILE* status = std::fopen("/proc/self/status", "r");
+    if (!status) return 0.0;
+    char line[256];
+    long kb = 0;
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, "VmHWM:", 6) == 0) {
+            std::sscanf(line + 6, "%ld", &kb);
+            break;
+        }
+    }
+    std::fclose(status);
+    return kb / 1024.0;
+}
+
+// Restarts peakMemoryMB() from the current resident set size.
+inline void resetPeakMemory() {
+    FILE* clearRefs = std::fopen("/proc/self/clear_refs", "w");
+    if (!clearRefs) return;
+    std::fputs("5", clearRefs);
+    std::fclose(clearRefs);
+}
+
+inline void report(const char* name, double ms) {
+    std::printf("%-40s %12.3f ms\n", name, ms);
+}
+
+} // namespace bench
@@ -0,0 +1,141 @@
+// CPU cost of a scroll frame over a long text page at 1920x1080 whose content sits in one
+// large compositor layer: the per-frame path (relayout, display list, overdraw pass, glyphs,
+// instance diff) against the compositor (placement of the layer image; content is only
+// repainted when the visible part leaves the raster window). Also a transform animation.
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "layout/DisplayListOptimizer.hpp"
+#include "render/InstanceCache.hpp"
+#include "render/LayerTree.hpp"
+#include "text/TextPainter.hpp"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const float WIDTH = 1920.0f, HEIGHT = 1080.0f;
+static const int FRAMES = 600;
+static const float STEP = 40.0f;
+
+struct ScrollTotals {
+    double ms = 0.0;
+    size_t bytes = 0, repaints = 0;
+};
+
+static void print(const char* name, const ScrollTotals& t) {
+    std::printf("%-40s %12.3f ms\n", name, t.ms / FRAMES);
+    std::printf("%-40s %12.1f KB\n", "  uploaded per frame", t.bytes / 1024.0 / FRAMES);
+    std::printf("%-40s %12.1f %%\n", "  frames that repaint", 100.0 * t.repaints / FRAMES);
+}
+
+int main() {
+    auto dom = bench::generateTextDom(20000, 24);
+    // Страница целиком — один большой слой
+    Stylesheet stylesheet = CssParser(bench::generateTextCss() + ".page { will-change: transform; }\n").parse();
+    auto styleRoot = StyleApplier::applyStyles(*dom, stylesheet);
+
+    auto makeEngine = [&](LayoutEngine& engine) {
+        engine.setViewport(WIDTH, HEIGHT);
+        engine.setLazyLayout(true, std::max(1000.0f, HEIGHT));
+        engine.build(*styleRoot);
+        engine.relayout();
+    };
+    auto viewportAt = [](int frame) { return Rect{0.0f, frame * STEP, WIDTH, HEIGHT}; };
+
+    // Прежний путь: каждый кадр прокрутки заново строит и сравнивает всё видимое
+    ScrollTotals direct;
+    {
+        LayoutEngine engine;
+        makeEngine(engine);
+        TextPainter painter;
+        InstanceCache cache;
+        direct.ms = bench::timeMs([&] {
+            for (int f = 0; f < FRAMES; ++f) {
+                Rect viewport = viewportAt(f);
+                engine.setScrollOffset(viewport.y);
+                engine.relayout();
+                DisplayList list = buildDisplayList(engine.tree(), viewport);
+                optimizeDisplayList(list, viewport);
+                std::vector<GlyphQuad> glyphs;
+                painter.paint(list.texts, glyphs);
+                direct.bytes += cache.update(list, glyphs).bytesUploaded();
+                direct.repaints++;
+            }
+        });
+    }
+
+    // Композитор: кадр — проверка окна растра и размещение квадов; перерисовка только при выходе из окна
+    ScrollTotals composited;
+    LayoutEngine engine;
+    makeEngine(engine);
+    TextPainter painter;
+    LayerTree layers;
+    std::unordered_map<const StyledNode*, InstanceCache> caches;
+    std::vector<CompositeQuad> quads;
+    std::vector<Rect> damage;
+    auto repaint = [&](const Rect& viewport, bool contentChanged) {
+        engine.setScrollOffset(viewport.y);
+        const LayoutStats& stats = engine.relayout();
+        layers.update(engine.tree(), viewport);
+        layers.paint(engine.tree(), viewport, contentChanged || stats.boxesLaidOut > 0);
+        size_t bytes = 0;
+        for (const Layer& layer : layers.layers()) {
+            if (!layer.repainted) continue;
+            std::vector<GlyphQuad> glyphs;
+            painter.paint(layer.content->texts, glyphs);
+            bytes += caches[layer.owner].update(*layer.content, glyphs).bytesUploaded();
+        }
+        return bytes;
+    };
+    repaint(viewportAt(0), true);
+    layers.composite(viewportAt(0), quads, damage);
+    std::printf("%zu layers, page layer %.0fx%.0f px, raster window %.0fx%.0f px\n\n", layers.layers().size(),
+                layers.layers().back().bounds.width, layers.layers().back().bounds.height,
+                layers.layers().back().raster.width, layers.layers().back().raster.height);
+
+    composited.ms = bench::timeMs([&] {
+        for (int f = 0; f < FRAMES; ++f) {
+            Rect viewport = viewportAt(f);
+            if (layers.needsRaster(viewport)) {
+                composited.bytes += repaint(viewport, false);
+                composited.repaints++;
+            }
+            layers.composite(viewport, quads, damage);
+        }
+    });
+
+    print("scroll frame, per-frame display list", direct);
+    print("scroll frame, compositor", composited);
+    std::printf("%-40s %12.1fx\n", "speedup", direct.ms / composited.ms);
+
+    // Анимация сдвига слоя: меняются только свойства слоя, содержимое и растр остаются
+    StyledNode& page = *styleRoot;
+    Rect still = viewportAt(0);
+    int frame = 0;
+    double animateMs = bench::timeMs([&] {
+        page.specifiedValues["transform"] = "translate(" + std::to_string(frame++ % 200) + "px, 0px)";
+        layers.updateProperties();
+        if (layers.needsRaster(still)) repaint(still, false);
+        layers.composite(still, quads, damage);
+    }, FRAMES);
+    bench::report("transform animation frame", animateMs);
+
+    // Вложенный слой: сдвиг и прозрачность накапливаются от слоя страницы
+    page.specifiedValues["transform"] = "translate(100px, 0px)";
+    page.specifiedValues["opacity"] = "0.5";
+    StyledNode& paragraph = *page.children.front();
+    paragraph.specifiedValues["transform"] = "translate(10px, 20px)";
+    paragraph.specifiedValues["opacity"] = "0.5";
+    repaint(still, true);
+    layers.composite(still, quads, damage);
+    const Layer& nested = layers.layers().back();
+    bool composed = nested.owner == &paragraph && nested.composed.translateX == 110.0f &&
+                    nested.composed.translateY == 20.0f && quads.back().opacity == 0.25f &&
+                    quads.back().screen.x == nested.raster.x + 110.0f;
+    std::printf("%-40s %12s\n", "nested layer placement", composed ? "composed" : "MISMATCH");
+    return 0;
+}
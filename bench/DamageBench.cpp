@@ -0,0 +1,109 @@
+// Pixels shaded per frame on a full-screen dashboard when only a blinking cursor or a
+// ticking clock changes, with damage tracking against a triple-buffered swapchain.
+#include "BenchUtils.hpp"
+#include "document/Document.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "layout/DisplayListOptimizer.hpp"
+#include "render/InstanceCache.hpp"
+#include "render/DamageTracker.hpp"
+#include "text/TextPainter.hpp"
+
+#include <cstdio>
+#include <string>
+
+static const uint32_t WIDTH = 1920, HEIGHT = 1080;
+static const size_t SWAPCHAIN_IMAGES = 3;
+static const int FRAMES = 120;
+
+static std::string dashboardHtml() {
+    std::string html = "<div class=\"page\">";
+    html += "<div class=\"panel\"><p class=\"title\">Clock</p><p id=\"clock\">12:00:00</p></div>";
+    html += "<div class=\"panel\"><p class=\"title\">Search</p><div class=\"input\"><div id=\"cursor\" class=\"cursor\"></div></div></div>";
+    for (int i = 0; i < 40; ++i) {
+        html += "<div class=\"panel\"><p class=\"title\">Metric " + std::to_string(i) + "</p><p>value " +
+                std::to_string(i * 37 % 1000) + " requests per second over the last minute</p></div>";
+    }
+    html += "</div>";
+    return html;
+}
+
+static const char* DASHBOARD_CSS =
+    ".page { padding: 16px; background: #1d2021; color: #ebdbb2; }\n"
+    ".panel { padding: 8px; margin-bottom: 8px; background: #282828; }\n"
+    ".title { font-size: 8px; color: #a89984; }\n"
+    "p { font-size: 16px; }\n"
+    ".input { padding: 4px; background: #3c3836; }\n"
+    ".cursor { width: 2px; height: 16px; background: #fbf1c7; }\n"
+    ".off { background: #3c3836; }\n";
+
+int main() {
+    Document document(dashboardHtml(), DASHBOARD_CSS);
+    LayoutEngine engine;
+    engine.setViewport(WIDTH, HEIGHT);
+    engine.build(document.styleRoot());
+    engine.relayout();
+
+    TextPainter painter;
+    InstanceCache cache;
+    DamageTracker damage;
+    damage.reset(WIDTH, HEIGHT, SWAPCHAIN_IMAGES);
+    const Rect screen = {0.0f, 0.0f, static_cast<float>(WIDTH), static_cast<float>(HEIGHT)};
+
+    // Кадр как в движке: стили, компоновка, список отображения, дифф экземпляров, повреждения
+    uint64_t frameIndex = 0;
+    auto frame = [&](uint64_t& framePixels, uint64_t& shadedPixels) {
+        StyleUpdate update = document.updateStyles();
+        for (StyledNode* node : update.paintDirty) engine.styleChanged(*node);
+        for (StyledNode* node : update.childrenChanged) engine.rebuildChildren(*node);
+        for (StyledNode* node : update.textChanged) engine.textChanged(*node);
+        for (StyledNode* node : update.layoutDirty) engine.styleChanged(*node);
+        engine.relayout();
+        DisplayList list = buildDisplayList(engine.tree(), screen);
+        optimizeDisplayList(list, screen);
+        std::vector<GlyphQuad> glyphs;
+        painter.paint(list.texts, glyphs);
+        cache.update(list, glyphs);
+        for (const Rect& rect : cache.damage()) damage.add(rect);
+        damage.endFrame();
+        bool full;
+        auto rects = damage.takeImageDamage(frameIndex++ % SWAPCHAIN_IMAGES, full);
+        framePixels += DamageTracker::area(damage.frameDamage());
+        shadedPixels += DamageTracker::area(rects);
+    };
+
+    // Первые кадры рисуют каждое изображение цепочки целиком
+    for (size_t i = 0; i < SWAPCHAIN_IMAGES; ++i) {
+        uint64_t framePixels = 0, shadedPixels = 0;
+        frame(framePixels, shadedPixels);
+    }
+
+    DomNode& cursor = *document.getElementById("cursor");
+    DomNode& clock = *document.getElementById("clock")->children[0];
+    auto run = [&](const char* name, bool blink, bool tick) {
+        uint64_t framePixels = 0, shadedPixels = 0;
+        double ms = bench::timeMs([&] {
+            for (int f = 0; f < FRAMES; ++f) {
+                if (blink) document.toggleClass(cursor, "off");
+                if (tick) {
+                    int seconds = static_cast<int>(frameIndex % 60);
+                    document.setText(clock, std::string("12:00:") + (seconds < 10 ? "0" : "") + std::to_string(seconds));
+                }
+                frame(framePixels, shadedPixels);
+            }
+        }) / FRAMES;
+        double fullPixels = static_cast<double>(WIDTH) * HEIGHT;
+        std::printf("\n[%s]\n", name);
+        std::printf("%-40s %12.0f px  (%.3f%% of screen)\n", "damage per frame", framePixels / static_cast<double>(FRAMES),
+                    100.0 * framePixels / FRAMES / fullPixels);
+        std::printf("%-40s %12.0f px  (%.3f%% of screen)\n", "pixels shaded per frame", shadedPixels / static_cast<double>(FRAMES),
+                    100.0 * shadedPixels / FRAMES / fullPixels);
+        std::printf("%-40s %12.0f px\n", "full redraw", fullPixels);
+        bench::report("CPU frame (style to damage)", ms);
+    };
+
+    run("blinking cursor", true, false);
+    run("ticking clock", false, true);
+    run("cursor and clock", true, true);
+    return 0;
+}
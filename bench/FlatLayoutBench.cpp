@@ -0,0 +1,40 @@
+// Layout and display-list build over the flat layout tree on a ~1M-box document.
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+
+#include <cstdio>
+
+int main() {
+    const int rows = 10000, cellsPerRow = 100;
+    auto dom = bench::generateGridDom(rows, cellsPerRow);
+    Stylesheet stylesheet = CssParser(bench::generateGridCss()).parse();
+    auto styleRoot = StyleApplier::applyStyles(*dom, stylesheet);
+
+    LayoutEngine engine;
+    double buildMs = bench::timeMs([&] { engine.build(*styleRoot); });
+    double layoutMs = bench::timeMs([&] { engine.relayout(); });
+    size_t boxes = engine.tree().size();
+
+    // Смена ширины окна заставляет перекомпоновать все боксы с автоматической шириной
+    float width = 800.0f;
+    double relayoutMs = bench::timeMs([&] {
+        width += 1.0f;
+        engine.setViewport(width, 600.0f);
+        engine.relayout();
+    }, 5);
+
+    size_t commands = 0;
+    double displayListMs = bench::timeMs([&] { commands = buildDisplayList(engine.tree()).size(); }, 5);
+
+    std::printf("boxes: %zu, display commands: %zu\n", boxes, commands);
+    bench::report("build flat tree", buildMs);
+    bench::report("initial layout", layoutMs);
+    bench::report("full relayout (resize)", relayoutMs);
+    bench::report("buildDisplayList", displayListMs);
+    std::printf("%-40s %12.1f ns/box\n", "layout", relayoutMs * 1e6 / boxes);
+    std::printf("%-40s %12.1f ns/box\n", "display list", displayListMs * 1e6 / boxes);
+    return 0;
+}
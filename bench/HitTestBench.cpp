@@ -0,0 +1,120 @@
+// Hit-test and region-query latency over a ~1M-box document with the spatial index, versus a
+// linear scan of the display list, plus the cost of building and updating the index.
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "layout/SpatialIndex.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static bool contains(const Rect& rect, float x, float y) {
+    return x >= rect.x && x < rect.x + rect.width && y >= rect.y && y < rect.y + rect.height;
+}
+
+// Эталон: верхний бокс под точкой — последний нарисованный
+static DisplayKey linearHitTest(const DisplayList& list, float x, float y) {
+    for (size_t i = list.rects.size(); i-- > 0;) {
+        if (contains(list.rects[i].rect, x, y)) return list.rects[i].key;
+    }
+    return {};
+}
+
+int main() {
+    const int rows = 10000, cellsPerRow = 100;
+    auto dom = bench::generateGridDom(rows, cellsPerRow);
+    Stylesheet stylesheet = CssParser(bench::generateGridCss()).parse();
+    auto styleRoot = StyleApplier::applyStyles(*dom, stylesheet);
+    LayoutEngine engine;
+    engine.build(*styleRoot);
+    engine.relayout();
+    DisplayList list = buildDisplayList(engine.tree());
+    const Rect page = list.rects[0].rect;
+
+    SpatialIndex index;
+    double buildMs = bench::timeMs([&] { index.update(list); });
+    double unchangedMs = bench::timeMs([&] { index.update(list); }, 3);
+
+    // 1% боксов сдвигается на несколько пикселей, как при анимации
+    uint32_t seed = 42;
+    auto next = [&] { return seed = seed * 1664525u + 1013904223u; };
+    const size_t moved = list.rects.size() / 100;
+    double movedMs = 0.0;
+    const int frames = 10;
+    for (int f = 0; f < frames; ++f) {
+        for (size_t i = 0; i < moved; ++i) list.rects[next() % list.rects.size()].rect.x += (f % 2) ? -3.0f : 3.0f;
+        movedMs += bench::timeMs([&] { index.update(list); });
+    }
+    movedMs /= frames;
+
+    std::vector<float> points;
+    const int queries = 1000000;
+    for (int i = 0; i < queries; ++i) {
+        points.push_back(page.x + (next() >> 8) % static_cast<uint32_t>(page.width));
+        points.push_back(page.y + (next() >> 4) % static_cast<uint32_t>(page.height));
+    }
+    std::vector<DisplayKey> hits;
+    size_t totalHits = 0;
+    double hitMs = bench::timeMs([&] {
+        for (int i = 0; i < queries; ++i) {
+            index.hitTest(points[2 * i], points[2 * i + 1], hits);
+            totalHits += hits.size();
+        }
+    });
+
+    // Указатель движется плавно: соседние запросы попадают в те же ячейки
+    std::vector<float> path;
+    float px = page.x + page.width / 2, py = page.y + page.height / 2;
+    for (int i = 0; i < queries; ++i) {
+        px = std::min(page.x + page.width - 1, std::max(page.x, px + static_cast<float>(next() >> 29) - 3.5f));
+        py = std::min(page.y + page.height - 1, std::max(page.y, py + static_cast<float>(next() >> 29) - 3.5f));
+        path.push_back(px);
+        path.push_back(py);
+    }
+    double pathMs = bench::timeMs([&] {
+        for (int i = 0; i < queries; ++i) {
+            index.hitTest(path[2 * i], path[2 * i + 1], hits);
+            totalHits += hits.size();
+        }
+    });
+
+    const int linearQueries = 200;
+    size_t mismatches = 0;
+    size_t linearHits = 0;
+    double linearMs = bench::timeMs([&] {
+        for (int i = 0; i < linearQueries; ++i) linearHits += linearHitTest(list, points[2 * i], points[2 * i + 1]).node != nullptr;
+    });
+    for (int i = 0; i < linearQueries; ++i) {
+        index.hitTest(points[2 * i], points[2 * i + 1], hits);
+        DisplayKey expected = linearHitTest(list, points[2 * i], points[2 * i + 1]);
+        if (hits.empty() ? expected.node != nullptr : !(hits[0] == expected)) mismatches++;
+    }
+
+    // Запрос области размером с экран
+    const int regionQueries = 1000;
+    std::vector<DisplayKey> region;
+    size_t regionBoxes = 0;
+    double regionMs = bench::timeMs([&] {
+        for (int i = 0; i < regionQueries; ++i) {
+            index.query({page.x, points[2 * i + 1], 1280.0f, 720.0f}, region);
+            regionBoxes += region.size();
+        }
+    });
+
+    std::printf("%-40s %12zu boxes, %zu cells, %zu oversized\n", "index", index.size(), index.cellCount(), index.oversizedCount());
+    bench::report("build index", buildMs);
+    bench::report("update, nothing changed", unchangedMs);
+    bench::report("update, 1% of boxes moved", movedMs);
+    std::printf("%-40s %12.1f ns/query  (%.1f boxes under the point)\n", "hit test (grid)", hitMs * 1e6 / queries,
+                static_cast<double>(totalHits) / queries / 2);
+    std::printf("%-40s %12.1f ns/query\n", "hit test (grid), pointer path", pathMs * 1e6 / queries);
+    std::printf("%-40s %12.1f ns/query  (%zu of %d hit)\n", "hit test (linear scan)", linearMs * 1e6 / linearQueries,
+                linearHits, linearQueries);
+    std::printf("%-40s %12zu of %d\n", "topmost hit mismatches", mismatches, linearQueries);
+    std::printf("%-40s %12.1f us/query  (%zu boxes per query)\n", "1280x720 region query", regionMs * 1e3 / regionQueries,
+                regionBoxes / regionQueries);
+    return 0;
+}
@@ -0,0 +1,58 @@
+// CPU cost of the performance overlay (render/PerfHud.hpp) per frame: adding the frame's
+// timings and building the rectangles of the graph and text, as VulkanEngine does before it
+// copies them into the overlay's vertex buffer and draws them in one instanced call. Frames
+// that rebuild the text (every TEXT_INTERVAL frames) make up the p99. Also reports the rects
+// and bytes uploaded per frame.
+#include "BenchUtils.hpp"
+#include "render/PerfHud.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static const int FRAMES = 100000;
+
+int main() {
+    PerfHud hud;
+    std::vector<HudRect> upload; // Stands in for the mapped vertex buffer
+    uint32_t seed = 12345;
+    size_t rects = 0, maxRects = 0;
+    auto frame = [&](int f) {
+        seed = seed * 1664525u + 1013904223u;
+        HudFrame timings;
+        timings.frameMs = 14.0f + (seed >> 16) % 800 / 100.0f; // Some frames over budget
+        timings.gpuMs = 3.0f + (seed >> 8) % 100 / 100.0f;
+        timings.applyMs = 0.2f;
+        timings.waitMs = 8.0f;
+        timings.recordMs = 0.6f;
+        timings.submitMs = 0.3f;
+        timings.styleMs = 1.5f;
+        timings.layoutMs = 2.5f;
+        timings.paintMs = 0.8f;
+        timings.drawCalls = 40 + f % 7;
+        timings.instances = 250000;
+        timings.gpuMemoryBytes = 180ull << 20;
+        hud.addFrame(timings);
+        const std::vector<HudRect>& built = hud.build();
+        upload.resize(built.size());
+        std::memcpy(upload.data(), built.data(), built.size() * sizeof(HudRect));
+        rects = built.size();
+        maxRects = std::max(maxRects, rects);
+    };
+
+    for (int f = 0; f < 1000; ++f) frame(f); // Прогрев: история графа заполнена
+    std::vector<double> samplesUs(FRAMES);
+    double totalUs = 0.0;
+    for (int f = 0; f < FRAMES; ++f) {
+        samplesUs[f] = bench::timeMs([&] { frame(f); }) * 1000.0;
+        totalUs += samplesUs[f];
+    }
+    std::sort(samplesUs.begin(), samplesUs.end());
+
+    std::printf("%-40s %12.2f us\n", "overlay per frame, average", totalUs / FRAMES);
+    std::printf("%-40s %12.2f us\n", "overlay per frame, p99", samplesUs[FRAMES * 99 / 100]);
+    std::printf("%-40s %12zu\n", "rects per frame (max)", maxRects);
+    std::printf("%-40s %12zu bytes\n", "upload per frame (max)", maxRects * sizeof(HudRect));
+    return 0;
+}
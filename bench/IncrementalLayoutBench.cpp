@@ -0,0 +1,75 @@
+// Compares full layout against incremental relayout after a local change and a resize.
+#include "BenchUtils.hpp"
+#include "document/Document.hpp"
+#include "layout/LayoutEngine.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+static void printStats(const char* name, double ms, const LayoutStats& stats) {
+    std::printf("%-40s %12.3f ms  laid out: %8zu  reused subtrees: %8zu\n",
+                name, ms, stats.boxesLaidOut, stats.subtreesReused);
+}
+
+int main() {
+    const int rows = 1000, cellsPerRow = 100;
+    std::string html = bench::generateGridHtml(rows, cellsPerRow);
+    // Every other row has a fixed width, so its subtree does not depend on the viewport
+    std::string css = bench::generateGridCss() + ".fixed { width: 300px; }\n";
+    Document document(html, css);
+    DomNode& page = document.root();
+    for (size_t i = 0; i < page.children.size(); i += 2) document.toggleClass(*page.children[i], "fixed");
+    document.updateStyles();
+
+    LayoutEngine engine;
+    engine.build(document.styleRoot());
+    double fullMs = bench::timeMs([&] { engine.relayout(); });
+    printStats("initial layout", fullMs, engine.lastStats());
+
+    DomNode* target = document.getElementById("n50000");
+    double localMs = bench::timeMs([&] {
+        document.toggleClass(*target, "expanded");
+        StyleUpdate update = document.updateStyles();
+        for (StyledNode* node : update.layoutDirty) engine.styleChanged(*node);
+        engine.relayout();
+    });
+    printStats("relayout after one class toggle", localMs, engine.lastStats());
+
+    double cleanMs = bench::timeMs([&] { engine.relayout(); });
+    printStats("relayout with nothing dirty", cleanMs, engine.lastStats());
+
+    engine.setViewport(1024.0f, 768.0f);
+    double resizeMs = bench::timeMs([&] { engine.relayout(); });
+    printStats("relayout after resize (half fixed)", resizeMs, engine.lastStats());
+
+    // Вставка в начало документа: индекс переписывается только в пределах строки,
+    // а сдвинутые боксы находятся через журнал сдвигов
+    DomNode& firstRow = *page.children.front();
+    auto apply = [&] {
+        StyleUpdate update = document.updateStyles();
+        for (StyledNode* node : update.childrenChanged) engine.rebuildChildren(*node);
+        for (StyledNode* node : update.layoutDirty) engine.styleChanged(*node);
+        engine.relayout();
+    };
+    double insertMs = bench::timeMs([&] {
+        auto cell = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+        cell->attributes["class"] = "cell";
+        document.insertChild(firstRow, std::move(cell), 0);
+        apply();
+    }, 300);
+    printStats("relayout after inserting a top cell", insertMs, engine.lastStats());
+
+    // Сдвинутый индекс должен указывать на тот же бокс, что и в свежем дереве
+    document.toggleClass(*document.getElementById("n99999"), "expanded");
+    apply();
+    LayoutEngine fresh;
+    fresh.setViewport(1024.0f, 768.0f);
+    fresh.build(document.styleRoot());
+    fresh.relayout();
+    bool identical = fresh.tree().size() == engine.tree().size() &&
+                     std::memcmp(fresh.tree().geometry.data(), engine.tree().geometry.data(),
+                                 fresh.tree().size() * sizeof(Rect)) == 0;
+    std::printf("%-40s %12s\n", "after 300 inserts vs fresh build", identical ? "identical" : "MISMATCH");
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Bytes uploaded per frame when 1% of the boxes in a 100k-box scene animate, with the
+// keyed display-list diff against a persistent instance buffer versus a full re-upload.
+#include "BenchUtils.hpp"
+#include "document/Document.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "render/InstanceCache.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static const int ROWS = 1000, CELLS_PER_ROW = 100, FRAMES = 30;
+
+struct FrameTotals {
+    size_t frames = 0, bytes = 0, fullBytes = 0, inserted = 0, removed = 0, changed = 0, moved = 0, compactions = 0;
+    double diffMs = 0.0;
+
+    void add(const InstanceUpdateStats& stats, double ms) {
+        frames++;
+        bytes += stats.bytesUploaded();
+        fullBytes += stats.fullUploadBytes;
+        inserted += stats.inserted;
+        removed += stats.removed;
+        changed += stats.changed;
+        moved += stats.moved;
+        compactions += stats.compacted ? 1 : 0;
+        diffMs += ms;
+    }
+};
+
+static void print(const char* name, const FrameTotals& t, const InstanceCache& cache) {
+    std::printf("\n[%s]\n", name);
+    std::printf("%-40s %8zu ins %8zu rem %8zu chg %8zu moved %4zu compactions\n", "per run",
+                t.inserted, t.removed, t.changed, t.moved, t.compactions);
+    std::printf("%-40s %12.1f KB\n", "uploaded per frame (diff)", t.bytes / 1024.0 / t.frames);
+    std::printf("%-40s %12.1f KB\n", "uploaded per frame (full rebuild)", t.fullBytes / 1024.0 / t.frames);
+    std::printf("%-40s %12.2f %%\n", "share of full upload", 100.0 * t.bytes / t.fullBytes);
+    std::printf("%-40s %12.3f ms\n", "diff per frame", t.diffMs / t.frames);
+    std::printf("%-40s %12zu live, %zu holes\n", "instance slots", cache.liveCount(), cache.holeCount());
+}
+
+int main() {
+    Document document(bench::generateGridHtml(ROWS, CELLS_PER_ROW), bench::generateGridCss());
+    LayoutEngine engine;
+    engine.build(document.styleRoot());
+    engine.relayout();
+
+    InstanceCache cache;
+    std::vector<GlyphQuad> noGlyphs;
+    InstanceUpdateStats first;
+    double firstMs = bench::timeMs([&] { first = cache.update(buildDisplayList(engine.tree()), noGlyphs); });
+    std::printf("%-40s %12zu instances, %.1f KB in %.3f ms\n", "first frame", first.inserted,
+                first.bytesUploaded() / 1024.0, firstMs);
+
+    // Применяет изменения документа и снимает кадр: компоновка, список отображения, дифф
+    auto frame = [&](FrameTotals& totals) {
+        StyleUpdate update = document.updateStyles();
+        for (StyledNode* node : update.paintDirty) engine.styleChanged(*node);
+        for (StyledNode* node : update.childrenChanged) engine.rebuildChildren(*node);
+        for (StyledNode* node : update.layoutDirty) engine.styleChanged(*node);
+        engine.relayout();
+        DisplayList list = buildDisplayList(engine.tree());
+        InstanceUpdateStats stats;
+        double ms = bench::timeMs([&] { stats = cache.update(list, noGlyphs); });
+        totals.add(stats, ms);
+    };
+
+    const int animated = ROWS * CELLS_PER_ROW / 100;
+    uint32_t seed = 42;
+    auto randomCell = [&]() -> DomNode& {
+        seed = seed * 1664525u + 1013904223u;
+        DomNode& row = *document.root().children[(seed >> 8) % ROWS];
+        return *row.children[(seed >> 20) % row.children.size()];
+    };
+
+    // 1. Смена цвета: меняются только сами анимированные боксы
+    FrameTotals recolor;
+    for (int f = 0; f < FRAMES; ++f) {
+        for (int i = 0; i < animated; ++i) document.toggleClass(randomCell(), "selected");
+        frame(recolor);
+    }
+    print("1% of boxes change color", recolor, cache);
+
+    // 2. Смена высоты: сдвигаются и все следующие братья и строки
+    FrameTotals resize;
+    for (int f = 0; f < FRAMES; ++f) {
+        for (int i = 0; i < animated; ++i) document.toggleClass(randomCell(), "expanded");
+        frame(resize);
+    }
+    print("1% of boxes change height", resize, cache);
+
+    // 3. Структурные правки: 1% ячеек удаляется и столько же вставляется в другие строки
+    FrameTotals churn;
+    std::vector<std::unique_ptr<DomNode>> removed;
+    for (int f = 0; f < FRAMES; ++f) {
+        for (int i = 0; i < animated; ++i) {
+            DomNode& cell = randomCell();
+            DomNode& row = *cell.parent;
+            if (row.children.size() > 1) removed.push_back(document.removeChild(row, cell));
+            seed = seed * 1664525u + 1013904223u;
+            DomNode& target = *document.root().children[(seed >> 8) % ROWS];
+            auto fresh = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+            fresh->attributes["class"] = "cell c" + std::to_string(i % 10);
+            document.insertChild(target, std::move(fresh), (seed >> 20) % (target.children.size() + 1));
+        }
+        frame(churn);
+    }
+    print("1% of boxes removed and inserted", churn, cache);
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Fragment cost of deeply layered pages at 1920x1080: how many fragments the GPU shades
+// when every rect is blended back to front, after the display-list optimization pass, and
+// with the two-pass renderer (opaque rects front to back with depth writes, then
+// translucent rects blended and depth-tested). A per-pixel depth buffer on the CPU follows
+// the draw list InstanceCache builds for the GPU; both paths must give the same image.
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "layout/DisplayListOptimizer.hpp"
+#include "render/InstanceCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static const int WIDTH = 1920, HEIGHT = 1080;
+
+struct Pixel {
+    float r = 0.0f, g = 0.0f, b = 0.0f;
+};
+
+struct FragmentStats {
+    size_t shaded = 0;   // Fragments that ran the fragment shader
+    size_t rejected = 0; // Fragments discarded by the depth test before shading
+};
+
+template <typename Fn>
+static void forEachPixel(const GpuInstance& instance, float scrollY, Fn&& fn) {
+    int x0 = std::max(0, static_cast<int>(instance.rect[0]));
+    int y0 = std::max(0, static_cast<int>(instance.rect[1] - scrollY));
+    int x1 = std::min(WIDTH, static_cast<int>(instance.rect[0] + instance.rect[2]));
+    int y1 = std::min(HEIGHT, static_cast<int>(instance.rect[1] - scrollY + instance.rect[3]));
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) fn(y * WIDTH + x);
+    }
+}
+
+static void blend(Pixel& pixel, const GpuInstance& instance) {
+    float a = instance.color[3];
+    pixel.r = instance.color[0] * a + pixel.r * (1.0f - a);
+    pixel.g = instance.color[1] * a + pixel.g * (1.0f - a);
+    pixel.b = instance.color[2] * a + pixel.b * (1.0f - a);
+}
+
+// Прежний путь: всё в порядке отрисовки со смешиванием, каждый фрагмент закрашивается
+static FragmentStats paintBackToFront(const InstanceCache& cache, float scrollY, std::vector<Pixel>& image) {
+    FragmentStats stats;
+    std::vector<DrawEntry> painted = cache.draws();
+    std::sort(painted.begin(), painted.end(), [](const DrawEntry& a, const DrawEntry& b) { return a.paint < b.paint; });
+    for (const DrawEntry& draw : painted) {
+        const GpuInstance& instance = cache.slots()[draw.slot];
+        forEachPixel(instance, scrollY, [&](int i) {
+            blend(image[i], instance);
+            stats.shaded++;
+        });
+    }
+    return stats;
+}
+
+// Два прохода по списку отрисовки, как на GPU: глубина — номер в порядке отрисовки (позже — ближе)
+static FragmentStats paintWithDepth(const InstanceCache& cache, float scrollY, std::vector<Pixel>& image) {
+    FragmentStats stats;
+    std::vector<int64_t> depth(image.size(), -1);
+    const std::vector<DrawEntry>& draws = cache.draws();
+    for (size_t d = 0; d < draws.size(); ++d) {
+        const GpuInstance& instance = cache.slots()[draws[d].slot];
+        bool opaque = d < cache.opaqueCount();
+        forEachPixel(instance, scrollY, [&](int i) {
+            if (draws[d].paint <= depth[i]) {
+                stats.rejected++;
+                return;
+            }
+            stats.shaded++;
+            if (opaque) {
+                image[i] = {instance.color[0], instance.color[1], instance.color[2]};
+                depth[i] = draws[d].paint;
+            } else {
+                blend(image[i], instance);
+            }
+        });
+    }
+    return stats;
+}
+
+static bool sameImage(const std::vector<Pixel>& a, const std::vector<Pixel>& b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].r != b[i].r || a[i].g != b[i].g || a[i].b != b[i].b) return false;
+    }
+    return true;
+}
+
+static void run(const char* name, const DomNode& dom, const std::string& css) {
+    Stylesheet stylesheet = CssParser(css).parse();
+    auto styleRoot = StyleApplier::applyStyles(dom, stylesheet);
+    LayoutEngine engine;
+    engine.setViewport(WIDTH, HEIGHT);
+    engine.build(*styleRoot);
+    engine.relayout();
+
+    const float scrollY = 0.0f;
+    Rect viewport = {0.0f, scrollY, static_cast<float>(WIDTH), static_cast<float>(HEIGHT)};
+    DisplayList original = buildDisplayList(engine.tree(), viewport);
+    DisplayList optimized = original;
+    OverdrawStats overdraw = optimizeDisplayList(optimized, viewport);
+
+    InstanceCache raw, cache;
+    raw.update(original, {});
+    double splitMs = bench::timeMs([&] { cache.update(optimized, {}); }, 20);
+    size_t translucent = cache.draws().size() - cache.opaqueCount();
+
+    std::vector<Pixel> rawImage(WIDTH * HEIGHT), blendedImage(WIDTH * HEIGHT), depthImage(WIDTH * HEIGHT);
+    FragmentStats rawStats = paintBackToFront(raw, scrollY, rawImage);
+    FragmentStats blended = paintBackToFront(cache, scrollY, blendedImage);
+    FragmentStats depthTested = paintWithDepth(cache, scrollY, depthImage);
+    const double pixels = static_cast<double>(WIDTH) * HEIGHT;
+
+    std::printf("\n[%s]\n", name);
+    std::printf("%-40s %8zu -> %zu (%zu opaque, %zu translucent)\n", "rects", overdraw.commandsBefore,
+                overdraw.commandsAfter, cache.opaqueCount(), translucent);
+    std::printf("%-40s %8.2fx\n", "fragments/pixel, all blended", rawStats.shaded / pixels);
+    std::printf("%-40s %8.2fx\n", "  after optimization pass", blended.shaded / pixels);
+    std::printf("%-40s %8.2fx (%.1f%% rejected early)\n", "  + opaque front-to-back, depth test", depthTested.shaded / pixels,
+                100.0 * depthTested.rejected / std::max<size_t>(1, depthTested.shaded + depthTested.rejected));
+    std::printf("%-40s %8.1fx\n", "fragment shading saved vs blended", static_cast<double>(rawStats.shaded) / std::max<size_t>(1, depthTested.shaded));
+    bench::report("draw list build (diff + split)", splitMs);
+    std::printf("%-40s %12s\n", "image identical", sameImage(rawImage, depthImage) && sameImage(blendedImage, depthImage) ? "yes" : "NO");
+}
+
+// Стопки вложенных карточек с отступами: каждый уровень виден только рамкой, поэтому
+// оптимизатор не может выбросить родителя целиком, а тест глубины отсекает его середину
+static std::unique_ptr<DomNode> nestedCards(int cards, int depth) {
+    auto page = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+    page->attributes["class"] = "page";
+    for (int i = 0; i < cards; ++i) {
+        DomNode* parent = page.get();
+        for (int level = 0; level < depth; ++level) {
+            auto child = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+            child->attributes["class"] = level == depth - 1 ? "leaf" : "l" + std::to_string(level % 4);
+            child->parent = parent;
+            DomNode* next = child.get();
+            parent->children.push_back(std::move(child));
+            parent = next;
+        }
+    }
+    return page;
+}
+
+int main() {
+    auto cards = nestedCards(4, 24);
+    run("nested opaque cards", *cards,
+        ".page { background: #101010; }\n"
+        ".l0 { padding: 4px; background: #202020; }\n"
+        ".l1 { padding: 4px; background: #2a2a2a; }\n"
+        ".l2 { padding: 4px; background: #343434; }\n"
+        ".l3 { padding: 4px; background: #3e3e3e; }\n"
+        ".leaf { height: 60px; background: #505050; }\n");
+    run("nested cards, every 4th translucent", *cards,
+        ".page { background: #101010; }\n"
+        ".l0 { padding: 4px; background: #202020; }\n"
+        ".l1 { padding: 4px; background: #2a2a2a; }\n"
+        ".l2 { padding: 4px; background: #343434; }\n"
+        ".l3 { padding: 4px; background: #ffffff20; }\n"
+        ".leaf { height: 60px; background: rgba(80, 120, 200, 0.5); }\n");
+    return 0;
+}
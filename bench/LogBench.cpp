@@ -0,0 +1,106 @@
+// Logging on a log-heavy scene build and teardown: 100000 objects that each log when created
+// and destroyed, as GPU resources do, and a page with 20000 unclosed tags, where the parser
+// warns once per tag. The synchronous logger it replaced (localtime formatting, std::cout and
+// std::endl per line) against the asynchronous one, with stdout sent to /dev/null. For the
+// asynchronous logger the time at the call sites and the time until everything is written;
+// for the parse, its time with warnings on and filtered out at runtime.
+#include "BenchUtils.hpp"
+#include "document/Document.hpp"
+#include "utils/Logger.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+
+static const int OBJECTS = 100000;
+
+// Прежний Log::log: форматирование времени, std::cout и std::endl на каждую строку
+static void legacyLog(const std::string& level, const std::string& message, const std::string& color) {
+    auto now = std::chrono::system_clock::now();
+    auto time = std::chrono::system_clock::to_time_t(now);
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::cout << color << "[" << level << "] " << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S") << ": " << message << "\033[0m"
+              << std::endl;
+}
+
+static std::string malformedHtml(int tags) {
+    std::string html = "<div class=\"page\">";
+    for (int i = 0; i < tags; ++i) html += "<p>text<span>unclosed";
+    return html + "</div>";
+}
+
+// Вывод логов уходит в /dev/null, результаты — в настоящий stdout
+struct Silence {
+    int saved;
+    Silence() {
+        std::fflush(stdout);
+        std::cout.flush();
+        saved = dup(1);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, 1);
+        close(null);
+    }
+    ~Silence() {
+        std::fflush(stdout);
+        std::cout.flush();
+        dup2(saved, 1);
+        close(saved);
+    }
+};
+
+int main() {
+    std::string html = malformedHtml(20000);
+    double legacyObjects, legacyWarnings, asyncUnique, asyncUniqueTotal, asyncSite, asyncSiteTotal, parseLogged, parseFiltered;
+    {
+        Silence silence;
+        legacyObjects = bench::timeMs([] {
+            for (int i = 0; i < OBJECTS; ++i) legacyLog("INFO", "Texture " + std::to_string(i) + " created.", "\033[32m");
+            for (int i = 0; i < OBJECTS; ++i) legacyLog("INFO", "Texture " + std::to_string(i) + " destroyed.", "\033[32m");
+        });
+        // Столько же предупреждений, сколько даёт разбор ниже, прежним путём
+        legacyWarnings = bench::timeMs([&] {
+            for (int i = 0; i < 2 * 20000; ++i) legacyLog("WARN", "Parser warning: Unclosed tag 'span'", "\033[33m");
+        });
+
+        // Разные тексты: ограничение повторов не срабатывает, меряется сама запись
+        asyncUnique = bench::timeMs([] {
+            for (int i = 0; i < OBJECTS; ++i) Log::info("Texture " + std::to_string(i) + " created.");
+            for (int i = 0; i < OBJECTS; ++i) Log::info("Texture " + std::to_string(i) + " destroyed.");
+        });
+        asyncUniqueTotal = asyncUnique + bench::timeMs([] { Log::flush(); });
+
+        // Одно место вызова, как у ресурсов GPU: сверх лимита в секунду повторы отбрасываются
+        asyncSite = bench::timeMs([] {
+            for (int i = 0; i < OBJECTS; ++i) Log::infof("Texture %d created.", i);
+            for (int i = 0; i < OBJECTS; ++i) Log::infof("Texture %d destroyed.", i);
+        });
+        asyncSiteTotal = asyncSite + bench::timeMs([] { Log::flush(); });
+
+        // Первый разбор прогревает аллокатор; дальше — поровну с логом и без
+        { Document warmup(html, ""); }
+        Log::flush();
+        Log::setLevel(LogLevel::ERROR);
+        parseFiltered = bench::timeMs([&] { Document document(html, ""); }, 3);
+        Log::setLevel(LogLevel::INFO);
+        parseLogged = bench::timeMs([&] {
+            Document document(html, "");
+            Log::flush();
+        }, 3);
+    }
+    std::printf("%-44s %12.3f ms\n", "sync: 200000 object lines", legacyObjects);
+    std::printf("%-44s %12.3f ms\n", "async, distinct text: call sites", asyncUnique);
+    std::printf("%-44s %12.3f ms\n", "async, distinct text: until written", asyncUniqueTotal);
+    std::printf("%-44s %12.3f ms\n", "async, one call site: call sites", asyncSite);
+    std::printf("%-44s %12.3f ms\n", "async, one call site: until written", asyncSiteTotal);
+    std::printf("%-44s %12.3f ms\n", "sync: 40000 parser warnings, logging only", legacyWarnings);
+    std::printf("%-44s %12.3f ms\n", "async: parse, 40000 warnings logged", parseLogged);
+    std::printf("%-44s %12.3f ms\n", "async: parse, warnings filtered out", parseFiltered);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Overdraw of typical pages before and after the display-list optimization pass, with a
+// CPU fill of the surviving rects standing in for a software rasterizer (lavapipe).
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "layout/DisplayListOptimizer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static const int WIDTH = 800, HEIGHT = 600;
+
+// Заливка прямоугольников в RGBA-буфер, как это сделал бы программный растеризатор
+static void fill(std::vector<uint32_t>& pixels, const DisplayList& list, float scrollY) {
+    for (const auto& command : list.rects) {
+        int x0 = std::max(0, static_cast<int>(command.rect.x));
+        int y0 = std::max(0, static_cast<int>(command.rect.y - scrollY));
+        int x1 = std::min(WIDTH, static_cast<int>(command.rect.x + command.rect.width));
+        int y1 = std::min(HEIGHT, static_cast<int>(command.rect.y - scrollY + command.rect.height));
+        uint32_t color = command.color.r | command.color.g << 8 | command.color.b << 16 | 0xFF000000u;
+        for (int y = y0; y < y1; ++y) std::fill(&pixels[y * WIDTH + x0], &pixels[y * WIDTH + std::max(x0, x1)], color);
+    }
+}
+
+static void run(const char* name, const DomNode& dom, const std::string& css) {
+    Stylesheet stylesheet = CssParser(css).parse();
+    auto styleRoot = StyleApplier::applyStyles(dom, stylesheet);
+    LayoutEngine engine;
+    engine.setViewport(WIDTH, HEIGHT);
+    engine.build(*styleRoot);
+    engine.relayout();
+
+    const float scrollY = 300.0f;
+    Rect viewport = {0.0f, scrollY, static_cast<float>(WIDTH), static_cast<float>(HEIGHT)};
+    DisplayList original = buildDisplayList(engine.tree(), viewport);
+    DisplayList optimized = original;
+    OverdrawStats stats;
+    double passMs = bench::timeMs([&] {
+        optimized = original;
+        stats = optimizeDisplayList(optimized, viewport);
+    }, 50);
+
+    std::vector<uint32_t> pixels(WIDTH * HEIGHT);
+    double fillBeforeMs = bench::timeMs([&] { fill(pixels, original, scrollY); }, 50);
+    std::vector<uint32_t> reference = pixels;
+    double fillAfterMs = bench::timeMs([&] { fill(pixels, optimized, scrollY); }, 50);
+
+    std::printf("\n[%s]\n", name);
+    std::printf("%-40s %8zu -> %zu (%zu invisible, %zu occluded, %zu clipped, %zu merged)\n", "rects",
+                stats.commandsBefore, stats.commandsAfter, stats.invisibleDropped, stats.occludedDropped,
+                stats.clipped, stats.merged);
+    std::printf("%-40s %8.2fx -> %.2fx\n", "overdraw factor", stats.overdrawBefore(), stats.overdrawAfter());
+    bench::report("optimization pass", passMs);
+    bench::report("CPU fill before", fillBeforeMs);
+    bench::report("CPU fill after", fillAfterMs);
+    std::printf("%-40s %12s\n", "image identical", pixels == reference ? "yes" : "NO");
+}
+
+int main() {
+    // Сетка: страница, строки и ячейки — у каждого свой фон
+    auto grid = bench::generateGridDom(200, 20);
+    run("grid page", *grid, bench::generateGridCss());
+
+    // Вложенные карточки без отступов: каждый контейнер целиком закрыт ребёнком
+    auto page = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+    page->attributes["class"] = "page";
+    for (int i = 0; i < 100; ++i) {
+        DomNode* parent = page.get();
+        for (int depth = 0; depth < 8; ++depth) {
+            auto child = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "div");
+            child->attributes["class"] = depth == 7 ? "leaf" : "panel";
+            child->parent = parent;
+            DomNode* next = child.get();
+            parent->children.push_back(std::move(child));
+            parent = next;
+        }
+    }
+    run("nested panels", *page,
+        ".page { background: #101010; }\n"
+        ".panel { background: #202020; }\n"
+        ".leaf { height: 30px; background: #303030; }\n");
+    return 0;
+}
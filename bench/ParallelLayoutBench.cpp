@@ -0,0 +1,87 @@
+// Scaling of parallel block layout on a wide document (10k sections x 100 boxes).
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+int main() {
+    const int sections = 10000, boxesPerSection = 100;
+    auto dom = bench::generateGridDom(sections, boxesPerSection);
+    Stylesheet stylesheet = CssParser(bench::generateGridCss()).parse();
+    auto styleRoot = StyleApplier::applyStyles(*dom, stylesheet);
+
+    LayoutEngine reference;
+    reference.build(*styleRoot);
+    reference.relayout();
+
+    size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("boxes: %zu, hardware threads: %zu\n", reference.tree().size(), hardwareThreads);
+
+    double singleMs = 0.0;
+    for (size_t threads = 1; threads <= std::max<size_t>(hardwareThreads, 4); threads *= 2) {
+        // Вызывающий поток тоже выполняет задачи, поэтому воркеров на один меньше
+        std::unique_ptr<ThreadPool> pool = threads > 1 ? std::make_unique<ThreadPool>(threads - 1) : nullptr;
+        LayoutEngine engine;
+        engine.setThreadPool(pool.get());
+        engine.build(*styleRoot);
+
+        float width = 800.0f;
+        double ms = bench::timeMs([&] {
+            width = width == 800.0f ? 801.0f : 800.0f; // Форсируем полную перекомпоновку
+            engine.setViewport(width, 600.0f);
+            engine.relayout();
+        }, 10);
+        engine.setViewport(800.0f, 600.0f);
+        engine.relayout();
+
+        bool deterministic = std::memcmp(engine.tree().geometry.data(), reference.tree().geometry.data(),
+                                         reference.tree().geometry.size() * sizeof(Rect)) == 0;
+        if (threads == 1) singleMs = ms;
+        std::printf("threads %2zu: %9.3f ms  speedup %5.2fx  %s\n", threads, ms, singleMs / ms,
+                    deterministic ? "identical" : "MISMATCH");
+    }
+
+    // Ленивый режим: вне окна поддеревья откладываются до раздачи задач. Оценки высот
+    // у задач свои, поэтому сверяем только поддеревья до первого отложенного.
+    LayoutEngine lazyReference;
+    lazyReference.setLazyLayout(true);
+    lazyReference.build(*styleRoot);
+    lazyReference.relayout();
+    const LayoutTree& lazyTree = lazyReference.tree();
+    BoxIndex firstDeferred = 0;
+    while (firstDeferred < lazyTree.size() && !(lazyTree.flags[firstDeferred] & LAYOUT_ESTIMATED)) firstDeferred++;
+
+    for (size_t threads = 1; threads <= std::max<size_t>(hardwareThreads, 4); threads *= 2) {
+        std::unique_ptr<ThreadPool> pool = threads > 1 ? std::make_unique<ThreadPool>(threads - 1) : nullptr;
+        LayoutEngine engine;
+        engine.setThreadPool(pool.get());
+        engine.setLazyLayout(true);
+        engine.build(*styleRoot);
+
+        float width = 800.0f;
+        LayoutStats stats;
+        double ms = bench::timeMs([&] {
+            width = width == 800.0f ? 801.0f : 800.0f;
+            engine.setViewport(width, 600.0f);
+            stats = engine.relayout();
+        }, 10);
+        engine.setViewport(800.0f, 600.0f);
+        engine.relayout();
+
+        bool inWindowIdentical = true;
+        for (BoxIndex k = 1; k < firstDeferred; ++k) {
+            if (lazyTree.subtreeEnd[k] > firstDeferred) continue; // Предки отложенных: высота из оценок
+            inWindowIdentical = inWindowIdentical && std::memcmp(&engine.tree().geometry[k], &lazyTree.geometry[k], sizeof(Rect)) == 0;
+        }
+        if (threads == 1) singleMs = ms;
+        std::printf("lazy threads %2zu: %9.3f ms  speedup %5.2fx  laid out %zu, estimated %zu  %s\n", threads, ms,
+                    singleMs / ms, stats.boxesLaidOut, stats.boxesEstimated, inWindowIdentical ? "identical" : "MISMATCH");
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// Reflowing a ~1 MB text document at successive widths: words are measured once and
+// only re-broken into lines afterwards.
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+
+#include <cstdio>
+
+static size_t textBytes(const DomNode& node) {
+    size_t bytes = node.type == NodeType::TEXT_NODE ? node.value.size() : 0;
+    for (const auto& child : node.children) bytes += textBytes(*child);
+    return bytes;
+}
+
+int main() {
+    const int paragraphs = 2000, wordsPerParagraph = 90;
+    auto dom = bench::generateTextDom(paragraphs, wordsPerParagraph);
+    Stylesheet stylesheet = CssParser(bench::generateTextCss()).parse();
+    auto styleRoot = StyleApplier::applyStyles(*dom, stylesheet);
+
+    LayoutEngine engine;
+    engine.setViewport(800.0f, 600.0f);
+    engine.build(*styleRoot);
+    double coldMs = bench::timeMs([&] { engine.relayout(); });
+    size_t measured = engine.lastStats().textsMeasured;
+
+    // Ширина меняется каждый кадр, как при перетаскивании края окна
+    const int steps = 40;
+    size_t remeasured = 0;
+    double reflowMs = bench::timeMs([&] {
+        static int step = 0;
+        engine.setViewport(800.0f - 10.0f * (step++ % steps), 600.0f);
+        remeasured += engine.relayout().textsMeasured;
+    }, steps);
+
+    // Для сравнения: та же смена ширины со сбросом всех замеров (дерево строится заново)
+    double rebuildMs = bench::timeMs([&] {
+        static int step = 0;
+        engine.setViewport(800.0f - 10.0f * (step++ % steps), 600.0f);
+        engine.build(*styleRoot);
+        engine.relayout();
+    }, 10);
+
+    std::printf("%.2f MB of text in %d paragraphs, document height %.0f px\n",
+                textBytes(*dom) / (1024.0 * 1024.0), paragraphs, engine.documentHeight());
+    bench::report("first layout (measure + break)", coldMs);
+    bench::report("reflow at new width (cached words)", reflowMs);
+    bench::report("rebuild + layout at new width", rebuildMs);
+    std::printf("%-40s %12zu\n", "texts measured on first layout", measured);
+    std::printf("%-40s %12zu\n", "texts re-measured during reflows", remeasured);
+    return 0;
+}
@@ -0,0 +1,298 @@
+// The document pipeline stage by stage on synthetic pages of four shapes: deep nesting, one
+// wide parent, a table and flat nodes with many classes each, all styled by N class rules.
+// Each stage (tokenize, parse html, parse css, style, layout, display list) runs on its own
+// and the whole pipeline end to end after one untimed warm-up pass of the shape; per stage the
+// median time of at least MIN_RUNS runs and MIN_TOTAL_MS of running, ns per DOM node, MB/s of
+// source text, heap allocations and bytes, and peak RSS.
+//
+//   StageBench [--rules N] [--scale F] [--json FILE] [--baseline FILE] [--tolerance F] [--fail-tolerance F]
+//
+// --json writes the results, one object per line; --baseline compares against such a file.
+// Allocation counts are deterministic: allocating more than before fails the check (exit 1).
+// Time is noisy: a stage slower per node by more than --tolerance (default 0.25) is only a
+// warning, and fails only beyond --fail-tolerance (default 1.0, twice the baseline) after
+// RETRIES more measurements. `make bench-check` runs it against bench/baseline.json.
+#include "BenchUtils.hpp"
+#include "layout/DisplayList.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/HtmlParser.hpp"
+#include "parser/HtmlTokenizer.hpp"
+#include "parser/StyleApplier.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+static const float WIDTH = 1920.0f, HEIGHT = 1080.0f;
+static const int MIN_RUNS = 11, MAX_RUNS = 1001;
+static const double MIN_TOTAL_MS = 200.0;
+static const int RETRIES = 2;
+
+// Счётчики аллокаций: глобальные operator new/delete этой программы
+static std::atomic<uint64_t> g_allocations{0}, g_allocatedBytes{0};
+
+static void* countedAlloc(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+struct Shape {
+    const char* name;
+    std::string html;
+    std::string css;
+};
+
+struct Result {
+    std::string shape, stage;
+    size_t nodes = 0, bytes = 0;
+    double ms = 0.0, nsPerNode = 0.0, mbPerSec = 0.0, peakRssMB = 0.0;
+    uint64_t allocations = 0, allocatedBytes = 0;
+};
+
+struct Pipeline {
+    std::vector<Token> tokens;
+    std::unique_ptr<DomNode> dom;
+    Stylesheet stylesheet;
+    std::unique_ptr<StyledNode> styled;
+    std::unique_ptr<LayoutEngine> layout;
+    DisplayList list;
+};
+
+static size_t countNodes(const DomNode& node) {
+    size_t count = 1;
+    for (const auto& child : node.children) count += countNodes(*child);
+    return count;
+}
+
+static std::unique_ptr<LayoutEngine> runLayout(const StyledNode& styled) {
+    auto engine = std::make_unique<LayoutEngine>();
+    engine->setViewport(WIDTH, HEIGHT);
+    engine->build(styled);
+    engine->relayout();
+    return engine;
+}
+
+// Медиана: короткие стадии повторяются, пока не наберут MIN_TOTAL_MS, а единичные выбросы
+// планировщика в обе стороны на неё не влияют. Результат прогона разрушается вне замера
+template <typename Fn>
+static Result measure(const Shape& shape, const char* stage, size_t nodes, size_t bytes, Fn&& fn) {
+    Result result;
+    result.shape = shape.name;
+    result.stage = stage;
+    result.nodes = nodes;
+    result.bytes = bytes;
+    std::vector<double> times;
+    double total = 0.0;
+    bench::resetPeakMemory();
+    for (int run = 0; run < MAX_RUNS && (run < MIN_RUNS || total < MIN_TOTAL_MS); ++run) {
+        uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+        uint64_t allocatedBytes = g_allocatedBytes.load(std::memory_order_relaxed);
+        auto start = bench::Clock::now();
+        auto output = fn();
+        std::chrono::duration<double, std::milli> elapsed = bench::Clock::now() - start;
+        times.push_back(elapsed.count());
+        total += elapsed.count();
+        result.allocations = g_allocations.load(std::memory_order_relaxed) - allocations;
+        result.allocatedBytes = g_allocatedBytes.load(std::memory_order_relaxed) - allocatedBytes;
+    }
+    result.peakRssMB = bench::peakMemoryMB();
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    result.ms = times[times.size() / 2];
+    result.nsPerNode = result.ms * 1e6 / nodes;
+    result.mbPerSec = bytes / (1024.0 * 1024.0) / (result.ms / 1000.0);
+    return result;
+}
+
+// `only` restricts the run to one stage, for re-measuring it
+static void runShape(const Shape& shape, std::vector<Result>& results, const std::string& only = "") {
+    // Входы стадий готовятся один раз; каждая стадия меряется отдельно от предыдущих
+    std::vector<Token> tokens = HtmlTokenizer(shape.html).tokenize();
+    std::unique_ptr<DomNode> dom = HtmlParser(tokens).parse();
+    Stylesheet stylesheet = CssParser(shape.css).parse();
+    std::unique_ptr<StyledNode> styled = StyleApplier::applyStyles(*dom, stylesheet);
+    std::unique_ptr<LayoutEngine> layout = runLayout(*styled);
+
+    size_t nodes = countNodes(*dom);
+    size_t html = shape.html.size(), css = shape.css.size(), all = html + css;
+    // Прогрев: первый проход фигуры платит за холодные кэши и рост кучи
+    {
+        auto warmTokens = HtmlTokenizer(shape.html).tokenize();
+        auto warmDom = HtmlParser(warmTokens).parse();
+        auto warmStyled = StyleApplier::applyStyles(*warmDom, stylesheet);
+        buildDisplayList(runLayout(*warmStyled)->tree());
+    }
+
+    auto stage = [&](const char* name, size_t bytes, auto&& fn) {
+        if (only.empty() || only == name) results.push_back(measure(shape, name, nodes, bytes, fn));
+    };
+    stage("tokenize", html, [&] { return HtmlTokenizer(shape.html).tokenize(); });
+    stage("parse html", html, [&] { return HtmlParser(tokens).parse(); });
+    stage("parse css", css, [&] { return CssParser(shape.css).parse(); });
+    stage("style", all, [&] { return StyleApplier::applyStyles(*dom, stylesheet); });
+    stage("layout", all, [&] { return runLayout(*styled); });
+    stage("display list", all, [&] { return buildDisplayList(layout->tree()); });
+    stage("end to end", all, [&] {
+        auto pipeline = std::make_unique<Pipeline>();
+        pipeline->tokens = HtmlTokenizer(shape.html).tokenize();
+        pipeline->dom = HtmlParser(pipeline->tokens).parse();
+        pipeline->stylesheet = CssParser(shape.css).parse();
+        pipeline->styled = StyleApplier::applyStyles(*pipeline->dom, pipeline->stylesheet);
+        pipeline->layout = runLayout(*pipeline->styled);
+        pipeline->list = buildDisplayList(pipeline->layout->tree());
+        return pipeline;
+    });
+}
+
+static void writeJson(const std::vector<Result>& results, const char* path) {
+    FILE* file = std::fopen(path, "w");
+    if (!file) {
+        std::fprintf(stderr, "Cannot write %s\n", path);
+        std::exit(2);
+    }
+    std::fprintf(file, "[\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(file,
+                     "  {\"shape\": \"%s\", \"stage\": \"%s\", \"nodes\": %zu, \"bytes\": %zu, \"ms\": %.4f, \"nsPerNode\": %.2f, "
+                     "\"mbPerSec\": %.2f, \"allocations\": %llu, \"allocatedBytes\": %llu, \"peakRssMB\": %.1f}%s\n",
+                     r.shape.c_str(), r.stage.c_str(), r.nodes, r.bytes, r.ms, r.nsPerNode, r.mbPerSec,
+                     static_cast<unsigned long long>(r.allocations), static_cast<unsigned long long>(r.allocatedBytes), r.peakRssMB,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "]\n");
+    std::fclose(file);
+}
+
+// Хватает разбора собственного формата writeJson: один объект на строку
+static bool field(const std::string& line, const char* key, std::string& value) {
+    std::string pattern = std::string("\"") + key + "\": ";
+    size_t at = line.find(pattern);
+    if (at == std::string::npos) return false;
+    at += pattern.size();
+    if (line[at] == '"') {
+        size_t end = line.find('"', at + 1);
+        value = line.substr(at + 1, end - at - 1);
+    } else {
+        value = line.substr(at, line.find_first_of(",}", at) - at);
+    }
+    return true;
+}
+
+static std::vector<Result> readJson(const char* path) {
+    std::vector<Result> results;
+    FILE* file = std::fopen(path, "r");
+    if (!file) {
+        std::fprintf(stderr, "Cannot read baseline %s\n", path);
+        std::exit(2);
+    }
+    char buffer[1024];
+    while (std::fgets(buffer, sizeof(buffer), file)) {
+        std::string line = buffer, value;
+        Result r;
+        if (!field(line, "shape", r.shape) || !field(line, "stage", r.stage)) continue;
+        if (field(line, "nsPerNode", value)) r.nsPerNode = std::atof(value.c_str());
+        if (field(line, "allocations", value)) r.allocations = std::strtoull(value.c_str(), nullptr, 10);
+        results.push_back(r);
+    }
+    std::fclose(file);
+    return results;
+}
+
+// Число аллокаций детерминировано и сравнивается почти строго; время шумит, поэтому за
+// допуском — только предупреждение, а провал — лишь за широкой границей
+static int compare(std::vector<Result>& results, const std::vector<Result>& baseline, const std::vector<Shape>& shapes, double tolerance,
+                   double failTolerance) {
+    int regressions = 0, warnings = 0;
+    std::printf("\n%-12s %-14s %12s %12s %8s %14s %14s\n", "shape", "stage", "base ns/node", "ns/node", "change", "base allocs", "allocs");
+    for (Result& r : results) {
+        auto base = std::find_if(baseline.begin(), baseline.end(), [&](const Result& b) { return b.shape == r.shape && b.stage == r.stage; });
+        if (base == baseline.end()) {
+            std::printf("%-12s %-14s %12s\n", r.shape.c_str(), r.stage.c_str(), "new");
+            continue;
+        }
+        const Shape& shape = *std::find_if(shapes.begin(), shapes.end(), [&](const Shape& s) { return r.shape == s.name; });
+        for (int retry = 0; retry < RETRIES && r.nsPerNode > base->nsPerNode * (1.0 + failTolerance); ++retry) {
+            std::vector<Result> again;
+            runShape(shape, again, r.stage);
+            if (again[0].nsPerNode < r.nsPerNode) r = again[0];
+        }
+        double change = (r.nsPerNode / base->nsPerNode - 1.0) * 100.0;
+        bool tooSlow = r.nsPerNode > base->nsPerNode * (1.0 + failTolerance);
+        bool slower = !tooSlow && r.nsPerNode > base->nsPerNode * (1.0 + tolerance);
+        bool moreAllocations = r.allocations > base->allocations + base->allocations / 100;
+        std::printf("%-12s %-14s %12.2f %12.2f %+7.1f%% %14llu %14llu%s%s\n", r.shape.c_str(), r.stage.c_str(), base->nsPerNode, r.nsPerNode,
+                    change, static_cast<unsigned long long>(base->allocations), static_cast<unsigned long long>(r.allocations),
+                    tooSlow ? "  TOO SLOW" : slower ? "  slower (warning)" : "", moreAllocations ? "  MORE ALLOCATIONS" : "");
+        regressions += (tooSlow || moreAllocations) ? 1 : 0;
+        warnings += slower ? 1 : 0;
+    }
+    std::printf("\n%d regression(s) (more allocations or over %.0f%% slower), %d timing warning(s) (over %.0f%% slower)\n",
+                regressions, failTolerance * 100.0, warnings, tolerance * 100.0);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    int rules = 200;
+    double scale = 1.0, tolerance = 0.25, failTolerance = 1.0;
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return 2;
+        }
+        if (arg == "--rules") rules = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--scale") scale = std::max(0.01, std::atof(argv[++i]));
+        else if (arg == "--json") jsonPath = argv[++i];
+        else if (arg == "--baseline") baselinePath = argv[++i];
+        else if (arg == "--tolerance") tolerance = std::atof(argv[++i]);
+        else if (arg == "--fail-tolerance") failTolerance = std::atof(argv[++i]);
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    auto scaled = [&](int n) { return std::max(1, static_cast<int>(n * scale)); };
+
+    std::string css = bench::generateRulesCss(rules);
+    std::vector<Shape> shapes = {
+        {"deep", bench::generateDeepHtml(scaled(100), 40, rules), css},
+        {"wide", bench::generateWideHtml(scaled(4000), rules), css},
+        {"table", bench::generateTableHtml(scaled(160), 25, rules), css},
+        {"class-heavy", bench::generateClassHeavyHtml(scaled(2000), 8, rules), css},
+    };
+
+    std::vector<Result> results;
+    std::printf("%-12s %-14s %9s %10s %10s %10s %12s %12s %10s\n", "shape", "stage", "nodes", "ms", "ns/node", "MB/s", "allocs", "alloc MB", "peak MB");
+    for (const Shape& shape : shapes) {
+        size_t first = results.size();
+        runShape(shape, results);
+        for (size_t i = first; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::printf("%-12s %-14s %9zu %10.3f %10.2f %10.1f %12llu %12.2f %10.1f\n", r.shape.c_str(), r.stage.c_str(), r.nodes, r.ms,
+                        r.nsPerNode, r.mbPerSec, static_cast<unsigned long long>(r.allocations), r.allocatedBytes / (1024.0 * 1024.0),
+                        r.peakRssMB);
+        }
+    }
+
+    int regressions = baselinePath ? compare(results, readJson(baselinePath), shapes, tolerance, failTolerance) : 0;
+    if (jsonPath) writeJson(results, jsonPath);
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+// Measures a single class toggle against full work, like for like: the restyle of a toggle
+// against a full style pass over the same tree, and a toggle carried through incremental
+// relayout and the display list of the viewport against a full rebuild of the document.
+#include "BenchUtils.hpp"
+#include "document/Document.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "parser/StyleApplier.hpp"
+
+#include <cstdio>
+#include <memory>
+
+static const float WIDTH = 1920.0f, HEIGHT = 1080.0f;
+
+int main() {
+    const int rows = 1000, cellsPerRow = 100; // ~100k DOM nodes
+    std::string html = bench::generateGridHtml(rows, cellsPerRow);
+    std::string css = bench::generateGridCss();
+    const Rect viewport{0.0f, 0.0f, WIDTH, HEIGHT};
+
+    std::unique_ptr<Document> document;
+    double fullMs = bench::timeMs([&] {
+        document = std::make_unique<Document>(html, css);
+        LayoutTree layoutTree = LayoutEngine::buildLayoutTree(document->styleRoot());
+        DisplayList list = buildDisplayList(layoutTree, viewport);
+    });
+    double fullStyleMs = bench::timeMs([&] {
+        std::unique_ptr<StyledNode> styled = StyleApplier::applyStyles(document->root(), document->stylesheet());
+    });
+
+    DomNode* target = document->getElementById("n50000");
+    const int iterations = 1000;
+    size_t restyled = 0;
+    auto restyleMs = [&](const char* className) {
+        return bench::timeMs([&] {
+            document->toggleClass(*target, className);
+            StyleUpdate update = document->updateStyles();
+            restyled += update.restyledNodes;
+        }, iterations);
+    };
+    LayoutEngine engine;
+    engine.setViewport(WIDTH, HEIGHT);
+    // Тот же переключатель до конца конвейера: перекомпоновка затронутых боксов и список отображения окна
+    auto pipelineMs = [&](const char* className) {
+        return bench::timeMs([&] {
+            document->toggleClass(*target, className);
+            StyleUpdate update = document->updateStyles();
+            restyled += update.restyledNodes;
+            for (StyledNode* node : update.paintDirty) engine.styleChanged(*node);
+            for (StyledNode* node : update.childrenChanged) engine.rebuildChildren(*node);
+            for (StyledNode* node : update.layoutDirty) engine.styleChanged(*node);
+            engine.relayout();
+            DisplayList list = buildDisplayList(engine.tree(), viewport);
+        }, iterations);
+    };
+
+    double paintRestyleMs = restyleMs("selected");
+    double layoutRestyleMs = restyleMs("expanded");
+    double unrelatedRestyleMs = restyleMs("not-in-stylesheet");
+    // Чётное число переключений возвращает классы на место: дерево боксов строится по исходным стилям
+    engine.build(document->styleRoot());
+    engine.relayout();
+    double paintPipelineMs = pipelineMs("selected");
+    double layoutPipelineMs = pipelineMs("expanded");
+
+    std::printf("nodes: %d, restyled per toggle: %.2f\n", rows * cellsPerRow + rows + 1,
+                static_cast<double>(restyled) / (5 * iterations));
+    bench::report("full style pass (applyStyles)", fullStyleMs);
+    bench::report("toggle paint class, restyle", paintRestyleMs);
+    bench::report("toggle layout class, restyle", layoutRestyleMs);
+    bench::report("toggle unreferenced class, restyle", unrelatedRestyleMs);
+    std::printf("speedup, restyle vs full style pass: %.0fx\n", fullStyleMs / paintRestyleMs);
+
+    bench::report("full rebuild (parse+style+layout+paint)", fullMs);
+    bench::report("toggle paint class, to display list", paintPipelineMs);
+    bench::report("toggle layout class, to display list", layoutPipelineMs);
+    std::printf("speedup, toggle to display list vs full rebuild: %.0fx\n", fullMs / layoutPipelineMs);
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Text-heavy frames: shaping, glyph atlas lookups and display-list generation per frame.
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "text/TextPainter.hpp"
+
+#include <cstdio>
+
+int main() {
+    const int paragraphs = 20000, wordsPerParagraph = 8;
+    const float viewportWidth = 800.0f, viewportHeight = 600.0f;
+
+    auto dom = bench::generateTextDom(paragraphs, wordsPerParagraph);
+    Stylesheet stylesheet = CssParser(bench::generateTextCss()).parse();
+    auto styleRoot = StyleApplier::applyStyles(*dom, stylesheet);
+
+    LayoutEngine engine;
+    engine.setViewport(viewportWidth, viewportHeight);
+    engine.setLazyLayout(true);
+    engine.build(*styleRoot);
+    engine.relayout();
+
+    TextPainter painter;
+    std::vector<GlyphQuad> quads;
+    size_t texts = 0;
+    auto frame = [&](float scrollY) {
+        engine.setScrollOffset(scrollY);
+        engine.relayout();
+        DisplayList list = buildDisplayList(engine.tree(), Rect{0.0f, scrollY, viewportWidth, viewportHeight});
+        quads.clear();
+        painter.paint(list.texts, quads);
+        painter.atlas().clearDirty();
+        texts = list.texts.size();
+    };
+
+    // Холодный кадр: все строки формируются, все глифы растеризуются
+    double coldMs = bench::timeMs([&] { frame(0.0f); });
+    size_t coldMisses = painter.atlas().stats().misses;
+    painter.resetStats();
+
+    // Тот же экран повторно: всё берётся из кэшей
+    double warmMs = bench::timeMs([&] { frame(0.0f); }, 200);
+    double warmAtlasHitRate = painter.atlas().stats().hitRate();
+    double warmRunHitRate = painter.shaper().stats().hitRate();
+    painter.resetStats();
+
+    // Прокрутка: новые строки формируются, но глифы почти всегда уже в атласе
+    const int scrollFrames = 600;
+    double scrollMs = bench::timeMs([&] {
+        for (int f = 0; f < scrollFrames; ++f) frame(f * 40.0f);
+    }) / scrollFrames;
+
+    std::printf("%d paragraphs, %zu text runs and %zu glyphs on screen\n", paragraphs, texts, quads.size());
+    bench::report("cold text frame", coldMs);
+    bench::report("warm text frame", warmMs);
+    bench::report("scroll text frame (mean)", scrollMs);
+    std::printf("%-40s %12zu\n", "glyphs rasterized on first frame", coldMisses);
+    std::printf("%-40s %11.1f%% atlas, %5.1f%% runs\n", "warm frame hit rate", warmAtlasHitRate * 100, warmRunHitRate * 100);
+    std::printf("%-40s %11.1f%% atlas, %5.1f%% runs\n", "scroll hit rate",
+                painter.atlas().stats().hitRate() * 100, painter.shaper().stats().hitRate() * 100);
+    std::printf("%-40s %12zu\n", "atlas evictions while scrolling", painter.atlas().stats().evictions);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Tiled software rasterization of a long text page at 1920x1080: cold frames per thread
+// count (every tile drawn), scrolling with the tile cache, and a single word recolored.
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "layout/DisplayListOptimizer.hpp"
+#include "render/TileRasterizer.hpp"
+#include "text/TextPainter.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+static const uint32_t WIDTH = 1920, HEIGHT = 1080;
+static const Color CLEAR_COLOR = {26, 26, 26, 255};
+
+struct Frame {
+    DisplayList list;
+    std::vector<GlyphQuad> glyphs;
+};
+
+int main() {
+    auto dom = bench::generateTextDom(20000, 24);
+    Stylesheet stylesheet = CssParser(bench::generateTextCss()).parse();
+    auto styleRoot = StyleApplier::applyStyles(*dom, stylesheet);
+    LayoutEngine engine;
+    engine.setViewport(static_cast<float>(WIDTH), static_cast<float>(HEIGHT));
+    engine.setLazyLayout(true);
+    engine.build(*styleRoot);
+    engine.relayout();
+
+    TextPainter painter;
+    SoftwareRasterizer rasterizer;
+    Framebuffer framebuffer;
+    framebuffer.resize(WIDTH, HEIGHT);
+
+    // Команды кадра готовятся заранее — измеряется только растеризация
+    auto prepare = [&](float scrollY) {
+        engine.setScrollOffset(scrollY);
+        engine.relayout();
+        Rect viewport = {0.0f, scrollY, static_cast<float>(WIDTH), static_cast<float>(HEIGHT)};
+        Rect tiles = TileRasterizer::tileBounds(viewport);
+        Frame frame;
+        frame.list = buildDisplayList(engine.tree(), tiles);
+        optimizeDisplayList(frame.list, tiles);
+        painter.paint(frame.list.texts, frame.glyphs);
+        return frame;
+    };
+    const Rect screen = {0.0f, 0.0f, static_cast<float>(WIDTH), static_cast<float>(HEIGHT)};
+    Frame first = prepare(0.0f);
+    std::printf("%s spans, %u hardware threads, %zu rects and %zu glyphs on the first screen\n\n",
+                simdLevelName(rasterizer.simdLevel()), std::thread::hardware_concurrency(), first.list.rects.size(),
+                first.glyphs.size());
+
+    // Холодные кадры: кэш сбрасывается, все тайлы рисуются заново
+    unsigned maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    double singleMs = 0.0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        // parallelFor работает и в вызывающем потоке, поэтому рабочих на один меньше
+        std::unique_ptr<ThreadPool> pool = threads > 1 ? std::make_unique<ThreadPool>(threads - 1) : nullptr;
+        TileRasterizer tiles(rasterizer, pool.get());
+        double ms = bench::timeMs([&] {
+            tiles.clear();
+            tiles.draw(framebuffer, screen, first.list, first.glyphs, painter.atlas(), CLEAR_COLOR);
+        }, 30);
+        if (threads == 1) singleMs = ms;
+        std::printf("%-40s %9.3f ms  x%.2f\n", ("cold frame, " + std::to_string(threads) + " threads").c_str(), ms,
+                    singleMs / ms);
+    }
+
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    TileRasterizer tiles(rasterizer, std::thread::hardware_concurrency() > 1 ? &pool : nullptr);
+
+    // Прокрутка по 40px: новые тайлы появляются только у нижнего края
+    const int scrollFrames = 300;
+    std::vector<Frame> frames;
+    for (int f = 0; f < scrollFrames; ++f) frames.push_back(prepare(f * 40.0f));
+    size_t visible = 0, reused = 0;
+    double scrollMs = bench::timeMs([&] {
+        for (int f = 0; f < scrollFrames; ++f) {
+            Rect viewport = {0.0f, f * 40.0f, static_cast<float>(WIDTH), static_cast<float>(HEIGHT)};
+            const TileStats& stats = tiles.draw(framebuffer, viewport, frames[f].list, frames[f].glyphs, painter.atlas(),
+                                                CLEAR_COLOR);
+            visible += stats.visible;
+            reused += stats.reused;
+        }
+    }) / scrollFrames;
+    bench::report("scroll frame, 40px steps (mean)", scrollMs);
+    std::printf("%-40s %11.1f%%\n", "scroll tile hit rate", 100.0 * reused / visible);
+
+    // Статичный экран, у одного слова меняется цвет: перерисовываются только его тайлы
+    Frame changed = first;
+    for (size_t i = 0; i < 5 && i < changed.glyphs.size(); ++i) changed.glyphs[i].color = {255, 136, 0, 255};
+    tiles.draw(framebuffer, screen, first.list, first.glyphs, painter.atlas(), CLEAR_COLOR);
+    bool odd = false;
+    double changeMs = bench::timeMs([&] {
+        odd = !odd;
+        const Frame& frame = odd ? changed : first;
+        tiles.draw(framebuffer, screen, frame.list, frame.glyphs, painter.atlas(), CLEAR_COLOR);
+    }, 200);
+    bench::report("one word recolored", changeMs);
+    std::printf("%-40s %9zu of %zu\n", "tiles redrawn", tiles.stats().rendered, tiles.stats().visible);
+    return 0;
+}
@@ -0,0 +1,78 @@
+// Cost of the trace zones (utils/Trace.hpp): a single zone with recording off and on, and the
+// document pipeline on a text page of 20000 paragraphs with recording off and on. Each frame
+// restyles a paragraph and scrolls, then waits for the document thread, the way a frame of
+// the Vulkan backend would pick up its snapshot. Best of several alternating runs. The
+// measured difference is close to run-to-run noise, so the overhead is also estimated from
+// the zones recorded per frame and the cost of one zone.
+#include "BenchUtils.hpp"
+#include "document/Document.hpp"
+#include "document/DocumentWorker.hpp"
+#include "utils/Trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+static const float WIDTH = 1920.0f, HEIGHT = 1080.0f;
+static const int FRAMES = 200;
+static const int RUNS = 8;
+
+static double pipelineMs(DocumentWorker& worker, float& scrollY) {
+    return bench::timeMs([&] {
+        for (int f = 0; f < FRAMES; ++f) {
+            std::string id = "p" + std::to_string((f * 7) % 200);
+            worker.post([id](Document& document) { document.toggleClass(*document.getElementById(id), "t1"); });
+            scrollY += 12.0f;
+            worker.scrollTo(scrollY, 0.0f);
+            worker.waitIdle();
+            worker.consume();
+        }
+    });
+}
+
+int main() {
+#ifndef VKUI_TRACE
+    std::printf("Built with TRACE=0: zones are compiled out.\n");
+#endif
+    const int zones = 10000000;
+    double offNs = bench::timeMs([] { TRACE_ZONE("empty"); }, zones) * 1e6;
+    Trace::start();
+    double onNs = bench::timeMs([] { TRACE_ZONE("empty"); }, zones) * 1e6;
+    Trace::stop();
+    std::printf("%-40s %12.1f ns\n", "zone, recording off", offNs);
+    std::printf("%-40s %12.1f ns\n", "zone, recording on", onNs);
+
+    std::string html = "<div class=\"page\">";
+    for (int p = 0; p < 20000; ++p) {
+        html += "<p id=\"p" + std::to_string(p) + "\" class=\"t" + std::to_string(p % 4) + "\">lorem ipsum dolor sit amet layout vulkan glyph atlas render frame cache</p>";
+    }
+    html += "</div>";
+    DocumentWorker worker(html, bench::generateTextCss(), WIDTH, HEIGHT);
+    worker.waitIdle();
+    worker.consume();
+
+    float scrollY = 0.0f;
+    double best[2] = {1e30, 1e30};
+    uint64_t zonesBefore = Trace::recordedZones();
+    for (int run = 0; run < RUNS; ++run) {
+        // Порядок чередуется: второй прогон пары не должен систематически быть в другом положении
+        for (int i = 0; i < 2; ++i) {
+            int traced = (run + i) % 2;
+            if (traced) Trace::start();
+            best[traced] = std::min(best[traced], pipelineMs(worker, scrollY));
+            Trace::stop();
+        }
+    }
+    double zonesPerFrame = static_cast<double>(Trace::recordedZones() - zonesBefore) / (RUNS * FRAMES);
+    double estimatedMs = zonesPerFrame * FRAMES * onNs / 1e6;
+    std::printf("%-40s %12.3f ms\n", "200 frames, recording off", best[0]);
+    std::printf("%-40s %12.3f ms\n", "200 frames, recording on", best[1]);
+    std::printf("%-40s %12.2f %%\n", "tracing overhead, measured", (best[1] / best[0] - 1.0) * 100.0);
+    std::printf("%-40s %12.1f\n", "zones per frame", zonesPerFrame);
+    std::printf("%-40s %12.3f %%\n", "tracing overhead, zones x zone cost", estimatedMs / best[0] * 100.0);
+
+    const char* path = "/tmp/vkui_trace_bench.json";
+    double writeMs = bench::timeMs([&] { Trace::write(path); });
+    std::printf("%-40s %12.3f ms  (%s)\n", "write trace JSON", writeMs, path);
+    return 0;
+}
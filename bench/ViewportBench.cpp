@@ -0,0 +1,72 @@
+// Lazy layout, viewport culling and scrolling on a document with millions of boxes.
+#include "BenchUtils.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+int main() {
+    const int rows = 20000, cellsPerRow = 100; // ~2M boxes
+    const float viewportWidth = 800.0f, viewportHeight = 600.0f;
+
+    double baseMB = bench::residentMemoryMB();
+    auto dom = bench::generateGridDom(rows, cellsPerRow);
+    double domMB = bench::residentMemoryMB();
+    Stylesheet stylesheet = CssParser(bench::generateGridCss()).parse();
+    auto styleRoot = StyleApplier::applyStyles(*dom, stylesheet);
+    double styleMB = bench::residentMemoryMB();
+
+    LayoutEngine eager;
+    eager.build(*styleRoot);
+    double layoutMB = bench::residentMemoryMB();
+    double eagerLayoutMs = bench::timeMs([&] { eager.relayout(); });
+    size_t eagerCommands = 0;
+    double eagerPaintMs = bench::timeMs([&] { eagerCommands = buildDisplayList(eager.tree()).size(); });
+
+    LayoutEngine lazy;
+    lazy.setViewport(viewportWidth, viewportHeight);
+    lazy.setLazyLayout(true);
+    lazy.build(*styleRoot);
+    double lazyLayoutMs = bench::timeMs([&] { lazy.relayout(); });
+    size_t laidOut = lazy.lastStats().boxesLaidOut, estimated = lazy.lastStats().boxesEstimated;
+    size_t lazyCommands = 0;
+    double lazyPaintMs = bench::timeMs([&] {
+        lazyCommands = buildDisplayList(lazy.tree(), Rect{0.0f, 0.0f, viewportWidth, viewportHeight}).size();
+    });
+
+    // Прокрутка колесом: каждый кадр — ленивая докомпоновка и отсечённый список отрисовки
+    const int frames = 2000;
+    float scrollY = 0.0f, worstMs = 0.0f;
+    double scrollMs = 0.0;
+    for (int f = 0; f < frames; ++f) {
+        double ms = bench::timeMs([&] {
+            scrollY += 40.0f;
+            lazy.setScrollOffset(scrollY);
+            lazy.relayout();
+            scrollY += lazy.lastStats().scrollAnchorShift;
+            buildDisplayList(lazy.tree(), Rect{0.0f, scrollY, viewportWidth, viewportHeight});
+        });
+        scrollMs += ms;
+        worstMs = std::max(worstMs, static_cast<float>(ms));
+    }
+
+    double jumpMs = bench::timeMs([&] {
+        scrollY = lazy.documentHeight() / 2;
+        lazy.setScrollOffset(scrollY);
+        lazy.relayout();
+        buildDisplayList(lazy.tree(), Rect{0.0f, scrollY, viewportWidth, viewportHeight});
+    });
+
+    std::printf("boxes: %zu\n", eager.tree().size());
+    std::printf("RSS: DOM %.0f MiB, styled tree %.0f MiB, layout tree %.0f MiB\n",
+                domMB - baseMB, styleMB - domMB, layoutMB - styleMB);
+    std::printf("%-40s %12.3f ms (%zu commands)\n", "eager layout + full display list", eagerLayoutMs + eagerPaintMs, eagerCommands);
+    std::printf("%-40s %12.3f ms (%zu laid out, %zu estimated, %zu commands)\n", "lazy layout + culled display list",
+                lazyLayoutMs + lazyPaintMs, laidOut, estimated, lazyCommands);
+    std::printf("%-40s %12.3f ms avg, %.3f ms worst\n", "scroll frame (40px)", scrollMs / frames, worstMs);
+    bench::report("jump to middle of document", jumpMs);
+    return 0;
+}
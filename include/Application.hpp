@@ -6,11 +6,12 @@
 #include <memory>
 
 // Forward declaration
-class VulkanEngine;
+class RenderEngine;
 
 class Application {
 public:
-    Application(int width, int height, std::string title, std::string html, std::string css); // <-- Изменили
+    Application(int width, int height, std::string title, std::string html, std::string css,
+                std::unique_ptr<RenderEngine> engine);
     ~Application();
 
     // Make it non-copyable
@@ -21,9 +22,16 @@ public:
 
 private:
     void setupWindow();
+    void setupInput();
     void mainLoop();
     void teardown();
 
+    static void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+    static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    static void cursorPosCallback(GLFWwindow* window, double x, double y);
+    static void cursorEnterCallback(GLFWwindow* window, int entered);
+    static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+
     const int m_width;
     const int m_height;
     std::string m_title;
@@ -31,5 +39,5 @@ private:
     std::string m_cssContent;  // <-- Добавили
 
     GLFWwindow* m_window;
-    std::unique_ptr<VulkanEngine> m_vulkanEngine;
+    std::unique_ptr<RenderEngine> m_engine;
 };
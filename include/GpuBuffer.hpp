@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+
+// A host-visible, coherent buffer that stays mapped for its whole lifetime, so partial
+// updates are plain memcpys into the mapping. Grows by reallocation; the caller must make
+// sure the GPU no longer reads the buffer when it grows or is written.
+class GpuBuffer {
+public:
+    GpuBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkBufferUsageFlags usage, VkDeviceSize capacity);
+    ~GpuBuffer();
+
+    GpuBuffer(const GpuBuffer&) = delete;
+    GpuBuffer& operator=(const GpuBuffer&) = delete;
+
+    // Ensures room for `size` bytes; returns true if the buffer was reallocated, in which
+    // case its contents are lost and descriptors pointing at it must be rewritten.
+    bool reserve(VkDeviceSize size);
+    void write(VkDeviceSize offset, const void* data, size_t size);
+
+    VkBuffer handle() const { return m_buffer; }
+    VkDeviceSize capacity() const { return m_capacity; }
+    VkBufferUsageFlags usage() const { return m_usage; }
+
+private:
+    void allocate(VkDeviceSize capacity);
+    void release();
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+    VkPhysicalDevice m_physicalDevice;
+    VkDevice m_device;
+    VkBufferUsageFlags m_usage;
+    VkDeviceSize m_capacity = 0;
+
+    VkBuffer m_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_memory = VK_NULL_HANDLE;
+    VkDeviceSize m_memorySize = 0;
+    void* m_mapped = nullptr;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+// Offscreen color image of a compositor layer: drawn through its framebuffer by the layer
+// render passes, then sampled when the frame is composited. Contents persist between frames
+// and are left in SHADER_READ_ONLY_OPTIMAL after every pass. The depth attachment only
+// lives within a pass (cleared on load, never stored), so it is transient and, where the
+// device supports it, lazily allocated.
+class LayerSurface {
+public:
+    LayerSurface(VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, VkFormat format,
+                 VkFormat depthFormat, uint32_t width, uint32_t height);
+    ~LayerSurface();
+
+    LayerSurface(const LayerSurface&) = delete;
+    LayerSurface& operator=(const LayerSurface&) = delete;
+
+    VkFramebuffer framebuffer() const { return m_framebuffer; }
+    VkImageView imageView() const { return m_imageView; }
+    VkSampler sampler() const { return m_sampler; }
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+
+private:
+    void createImage();
+    void createImageView();
+    void createDepthImage();
+    void createSampler();
+    void createFramebuffer(VkRenderPass renderPass);
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+    VkPhysicalDevice m_physicalDevice;
+    VkDevice m_device;
+    VkFormat m_format;
+    VkFormat m_depthFormat;
+    uint32_t m_width, m_height;
+
+    VkImage m_image = VK_NULL_HANDLE;
+    VkDeviceMemory m_imageMemory = VK_NULL_HANDLE;
+    VkImageView m_imageView = VK_NULL_HANDLE;
+    VkImage m_depthImage = VK_NULL_HANDLE;
+    VkDeviceMemory m_depthMemory = VK_NULL_HANDLE;
+    VkDeviceSize m_memorySize = 0; // Color and depth
+    VkImageView m_depthView = VK_NULL_HANDLE;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+};
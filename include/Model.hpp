@@ -1,33 +0,0 @@
-#pragma once
-
-#include <vulkan/vulkan.h>
-#include <vector>
-
-class Model {
-public:
-    struct Vertex {
-        float position[2];
-        float color[3];
-
-        static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
-        static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
-    };
-
-    Model(VkPhysicalDevice physicalDevice, VkDevice device, const std::vector<Vertex>& vertices);
-    ~Model();
-
-    Model(const Model&) = delete;
-    Model& operator=(const Model&) =delete;
-
-    void bind(VkCommandBuffer commandBuffer);
-    void draw(VkCommandBuffer commandBuffer);
-
-private:
-    void createVertexBuffer(VkPhysicalDevice physicalDevice, const std::vector<Vertex>& vertices);
-    uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
-
-    VkDevice m_device;
-    VkBuffer m_vertexBuffer;
-    VkDeviceMemory m_vertexBufferMemory;
-    uint32_t m_vertexCount;
-};
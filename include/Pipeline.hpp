@@ -6,12 +6,15 @@
 
 // Configuration struct to build a pipeline
 struct PipelineConfigInfo {
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
     VkPipelineViewportStateCreateInfo viewportInfo;
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
     VkPipelineRasterizationStateCreateInfo rasterizationInfo;
     VkPipelineMultisampleStateCreateInfo multisampleInfo;
     VkPipelineColorBlendAttachmentState colorBlendAttachment;
     VkPipelineColorBlendStateCreateInfo colorBlendInfo;
+    VkPipelineDepthStencilStateCreateInfo depthStencilInfo{}; // Left zeroed for render passes without depth
     VkPipelineDynamicStateCreateInfo dynamicStateInfo;
     VkPipelineLayout pipelineLayout = nullptr;
     VkRenderPass renderPass = nullptr;
@@ -42,4 +45,22 @@ private:
 
     VkDevice m_device;
     VkPipeline m_graphicsPipeline;
+
+    friend class ComputePipeline;
+};
+
+// Single compute shader with its layout supplied by the caller.
+class ComputePipeline {
+public:
+    ComputePipeline(VkDevice device, const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+    ~ComputePipeline();
+
+    ComputePipeline(const ComputePipeline&) = delete;
+    ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+    void bind(VkCommandBuffer commandBuffer);
+
+private:
+    VkDevice m_device;
+    VkPipeline m_computePipeline;
 };
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+struct GLFWwindow;
+class Document;
+
+using DocumentTask = std::function<void(Document&)>;
+
+// What the application drives each frame; implemented by the Vulkan and the software
+// backends, so the backend can be chosen at startup.
+class RenderEngine {
+public:
+    virtual ~RenderEngine() = default;
+
+    virtual void init(GLFWwindow* window, const std::string& htmlContent, const std::string& cssContent) = 0;
+    virtual void drawFrame() = 0;
+    // Called before input is polled for the next frame; a backend pacing frames for latency
+    // blocks here until the previous frame is done.
+    virtual void paceFrame() {}
+    // When an input event reached the application, for backends measuring input latency.
+    virtual void inputReceived(std::chrono::steady_clock::time_point /*time*/) {}
+    // Shows or hides the performance overlay of backends that have one.
+    virtual void toggleHud() {}
+    // Blocks until the backend no longer uses the resources of submitted frames.
+    virtual void waitIdle() = 0;
+
+    // The document may live on a thread of its own: it is reached only through tasks, which
+    // run on that thread before the next frame that shows their effect.
+    virtual void postTask(DocumentTask task) = 0;
+    // Pointer input in window coordinates, delivered to the document as DOM events.
+    virtual void pointerMoved(float x, float y) = 0;
+    virtual void pointerButton(int button, bool pressed) = 0;
+    virtual void pointerLeft() = 0;
+
+    // Vertical scrolling of the page, in pixels; clamped to the document height.
+    virtual void scrollBy(float dy) = 0;
+    virtual void scrollTo(float y) = 0;
+};
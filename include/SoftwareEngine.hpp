@@ -0,0 +1,69 @@
+#pragma once
+
+#include "RenderEngine.hpp"
+#include "render/SoftwareRasterizer.hpp"
+#include "render/TileRasterizer.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+class LayoutEngine;
+class PointerDispatcher;
+class SpatialIndex;
+class ThreadPool;
+class X11Blitter;
+
+// CPU render backend: the same document, layout and display list as VulkanEngine, drawn by
+// SoftwareRasterizer into a framebuffer in system memory, tile by tile on the thread pool.
+// With a window the frame is blitted through X11; without one it renders offscreen only.
+class SoftwareEngine : public RenderEngine {
+public:
+    explicit SoftwareEngine(SimdLevel simdLevel = detectSimdLevel());
+    ~SoftwareEngine();
+
+    SoftwareEngine(const SoftwareEngine&) = delete;
+    SoftwareEngine& operator=(const SoftwareEngine&) = delete;
+
+    void init(GLFWwindow* window, const std::string& htmlContent, const std::string& cssContent) override;
+    // Renders into a width x height framebuffer with no window attached.
+    void initOffscreen(uint32_t width, uint32_t height, const std::string& htmlContent, const std::string& cssContent);
+    void drawFrame() override;
+    void waitIdle() override {}
+
+    // Документ живёт в потоке отрисовки: задачи и ввод применяются сразу
+    void postTask(DocumentTask task) override;
+    void pointerMoved(float x, float y) override;
+    void pointerButton(int button, bool pressed) override;
+    void pointerLeft() override;
+    const Framebuffer& framebuffer() const { return m_framebuffer; }
+    const TileStats& tileStats() const { return m_tiles->stats(); }
+
+    void scrollBy(float dy) override;
+    void scrollTo(float y) override;
+
+private:
+    void build(uint32_t width, uint32_t height, const std::string& htmlContent, const std::string& cssContent);
+    bool update();
+    void render();
+
+    SoftwareRasterizer m_rasterizer;
+    Framebuffer m_framebuffer;
+
+    std::unique_ptr<Document> m_document;
+    std::unique_ptr<ThreadPool> m_threadPool;
+    std::unique_ptr<LayoutEngine> m_layoutEngine;
+    std::unique_ptr<TextPainter> m_textPainter;
+    std::unique_ptr<SpatialIndex> m_spatialIndex;
+    std::unique_ptr<PointerDispatcher> m_pointer;
+    std::unique_ptr<TileRasterizer> m_tiles;
+    float m_scrollY = 0.0f;
+    bool m_scrollChanged = false;
+    bool m_firstFrame = true;
+
+    // Кадр копируется в окно через X11; без окна — только внеэкранный буфер
+    std::unique_ptr<X11Blitter> m_blitter;
+
+    // Без vsync кадры ограничиваются частотой обновления вручную
+    std::chrono::steady_clock::time_point m_nextFrame;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+// A sampled 2D image with its own memory, view and sampler. Contents are uploaded row
+// ranges at a time, either through a temporary staging buffer or recorded into a frame.
+class Texture {
+public:
+    Texture(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t width, uint32_t height, VkFormat format);
+    ~Texture();
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    // Copies rows [firstRow, firstRow + rowCount) of a tightly packed width-wide image.
+    // Blocks until the copy is done, so the caller must not have the texture in flight.
+    void upload(VkCommandPool commandPool, VkQueue queue, const uint8_t* pixels, uint32_t firstRow, uint32_t rowCount);
+    // Records the copy of rows [firstRow, firstRow + rowCount) from `staging` at `offset`, with
+    // the layout transitions around it. Frames recorded before it may still sample the texture.
+    void recordUpload(VkCommandBuffer commandBuffer, VkBuffer staging, VkDeviceSize offset, uint32_t firstRow, uint32_t rowCount);
+    VkDeviceSize rowSize() const { return static_cast<VkDeviceSize>(m_width) * m_bytesPerPixel; }
+
+    VkImageView imageView() const { return m_imageView; }
+    VkSampler sampler() const { return m_sampler; }
+
+private:
+    void createImage();
+    void createImageView();
+    void createSampler();
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+    VkPhysicalDevice m_physicalDevice;
+    VkDevice m_device;
+    uint32_t m_width, m_height;
+    VkFormat m_format;
+    uint32_t m_bytesPerPixel;
+    VkImageLayout m_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage m_image = VK_NULL_HANDLE;
+    VkDeviceMemory m_imageMemory = VK_NULL_HANDLE;
+    VkDeviceSize m_memorySize = 0;
+    VkImageView m_imageView = VK_NULL_HANDLE;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+};
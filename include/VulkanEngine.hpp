@@ -2,13 +2,28 @@
 
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
+#include "RenderEngine.hpp"
+#include "render/DamageTracker.hpp"
+#include "render/LayerTree.hpp"
+#include "render/PerfHud.hpp"
+#include "utils/LatencyProbe.hpp"
 #include <optional>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 #include <string>
 
 class Pipeline; 
-class Model;
+class ComputePipeline;
+class GpuBuffer;
+class InstanceCache;
+class LayerSurface;
+class Texture;
+class TextPainter;
+class DocumentWorker;
+class ThreadPool;
+struct DocumentSnapshot;
+struct InstanceUpdateStats;
 
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
@@ -16,25 +31,148 @@ struct QueueFamilyIndices {
     bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
 };
 
-class VulkanEngine {
+// How frames are queued for presentation. Fewer frames in flight and MAILBOX or IMMEDIATE
+// favour input latency (touch kiosks); more frames and FIFO favour throughput.
+struct PresentConfig {
+    uint32_t framesInFlight = 2;                 // Frames the CPU may record ahead of the GPU, 1..4
+    std::optional<VkPresentModeKHR> presentMode; // Default: MAILBOX when supported, else FIFO
+    uint32_t swapchainImages = 0;                // 0: one more than the surface minimum
+    bool paceFrames = false;                     // Wait for the previous frame before input is polled
+    bool latencyProbe = false;                   // Log input-to-present latency
+    bool hud = false;                            // Start with the performance overlay shown
+    bool gpuCulling = false;                     // Cull layer draws in cull.comp and draw indirectly; off: direct draws
+};
+
+class VulkanEngine : public RenderEngine {
 public:
-    VulkanEngine();
+    explicit VulkanEngine(const PresentConfig& config = PresentConfig());
     ~VulkanEngine();
 
     VulkanEngine(const VulkanEngine&) = delete;
     VulkanEngine& operator=(const VulkanEngine&) = delete;
 
-    void init(GLFWwindow* window, const std::string& htmlContent, const std::string& cssContent);
-    void drawFrame();
+    void init(GLFWwindow* window, const std::string& htmlContent, const std::string& cssContent) override;
+    void drawFrame() override;
+    void paceFrame() override;
+    void inputReceived(std::chrono::steady_clock::time_point time) override;
+    void toggleHud() override;
+    void waitIdle() override { vkDeviceWaitIdle(m_device); }
     VkDevice getDevice() const { return m_device; }
+    void postTask(DocumentTask task) override;
+    void pointerMoved(float x, float y) override;
+    void pointerButton(int button, bool pressed) override;
+    void pointerLeft() override;
+
+    void scrollBy(float dy) override;
+    void scrollTo(float y) override;
+    float scrollOffset() const { return m_scrollY; }
 
 private:
-    void buildRenderObjects(const std::string& htmlContent, const std::string& cssContent); // <-- Изменили
+    // GPU side of a compositor layer: persistent instance buffers of its content, the image
+    // it is rasterized into, and the descriptor sets to draw into and to sample that image.
+    struct GpuLayer {
+        std::unique_ptr<InstanceCache> instances;
+        std::unique_ptr<GpuBuffer> instanceBuffer; // GpuInstance per slot, read by the vertex shader
+        std::unique_ptr<GpuBuffer> drawBuffer;     // DrawEntry per drawn quad: opaque ones, then translucent
+        // With GPU culling only
+        std::unique_ptr<GpuBuffer> visibleBuffer;  // Draw entries that survived culling, read as vertex input
+        std::unique_ptr<GpuBuffer> indirectBuffer; // VkDrawIndirectCommand per draw segment: opaque, then translucent
+        std::unique_ptr<LayerSurface> surface;
+        VkDescriptorSet contentSet = VK_NULL_HANDLE;   // Glyph atlas + instance buffer
+        VkDescriptorSet compositeSet = VK_NULL_HANDLE; // The layer image
+        VkDescriptorSet cullSet = VK_NULL_HANDLE;      // Instances, draw list, survivors, indirect commands; GPU culling only
+        uint32_t drawCount = 0;
+        uint32_t opaqueCount = 0;
+        DamageTracker damage; // Texels of the image that are out of date
+        // Snapshot content the buffers hold and the raster it was painted for
+        std::shared_ptr<const DisplayList> content;
+        Rect raster;
+    };
+
+    // Host writes of one frame in flight. Dirty instance ranges and glyph atlas rows are written
+    // into its staging buffer and copied on the GPU before its layer passes, so buffers earlier
+    // frames may still read are never written by the CPU. Resources released while frames were
+    // in flight are kept until the fence of this slot has signalled again.
+    struct FrameUploads {
+        struct Copy {
+            VkBuffer source, destination;
+            VkDeviceSize sourceOffset, destinationOffset, size;
+        };
+        struct AtlasRows {
+            VkBuffer source;
+            VkDeviceSize offset;
+            uint32_t firstRow, rowCount;
+        };
+        std::unique_ptr<GpuBuffer> staging;
+        VkDeviceSize stagingUsed = 0;
+        std::vector<Copy> copies;
+        std::vector<AtlasRows> atlasRows;
+        std::vector<std::unique_ptr<GpuBuffer>> retiredBuffers;
+        std::vector<std::unique_ptr<LayerSurface>> retiredSurfaces;
+        std::vector<VkDescriptorSet> retiredSets;
+    };
+
+    // Secondary command buffers one thread records for one frame in flight. The pool is reset
+    // as a whole once the frame's fence has signalled; its buffers are then reused.
+    struct RecordContext {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers;
+        size_t used = 0;
+    };
+    // Part of a layer's draw list drawn by one indirect command; large layers have many.
+    struct DrawSegment {
+        uint32_t first, count;
+        uint32_t command; // Index in the layer's indirect buffer
+        bool translucent;
+    };
+    // Render pass of a layer image that is out of date. Its damage rects are split into groups
+    // and its draw list into segments; every group and segment is a chunk recorded in parallel.
+    // Chunks execute in order: a group's clear, its opaque segments, then its translucent ones.
+    struct LayerPass {
+        const Layer* layer;
+        GpuLayer* gpu;
+        std::vector<ScreenRect> damage;
+        std::vector<DrawSegment> segments;
+        bool fullRedraw;
+        VkClearValue clearColor;
+        size_t firstChunk = 0, chunkCount = 0;
+    };
+    struct RecordChunk {
+        size_t pass;
+        size_t firstRect, rectCount;
+        size_t segment; // In pass.segments; the first of a rect group also clears it
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    };
+
+    void applySnapshot(const DocumentSnapshot& snapshot);
+    Rect visibleRect() const;
+    void paintLayers(InstanceUpdateStats& diff, size_t& repainted);
+    GpuLayer& gpuLayer(const Layer& layer);
+    void releaseGpuLayers();
+    void compositeLayers();
+    size_t writeInstances(GpuLayer& layer);
+    bool grow(std::unique_ptr<GpuBuffer>& buffer, VkDeviceSize size);
+    void renewSet(VkDescriptorSet& set, VkDescriptorSetLayout layout);
+    VkDeviceSize stage(const void* data, size_t size, VkBuffer& source);
+    void stageCopy(GpuBuffer& destination, VkDeviceSize offset, const void* data, size_t size);
+    void recordUploads(VkCommandBuffer commandBuffer);
+    void flushUploads();
+    void releaseRetired(FrameUploads& frame);
+    static std::vector<DrawSegment> drawSegments(const GpuLayer& layer);
+    void recordLayers(VkCommandBuffer commandBuffer);
+    void recordCulling(VkCommandBuffer commandBuffer, const std::vector<LayerPass>& passes);
+    void recordChunk(const LayerPass& pass, const RecordChunk& chunk, VkCommandBuffer commandBuffer);
+    VkCommandBuffer secondaryBuffer(RecordContext& context);
+    void createRecordContexts();
+    void createUploads();
     void createFramebuffers();
     void createCommandPool();
     void createCommandBuffers();
     void createSyncObjects();
-    void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+    void logLatency(const char* label, const LatencyProbe& probe, const char* samples);
+    float readGpuTime();
+    void recordHud(VkCommandBuffer commandBuffer);
+    void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<ScreenRect>& damage, bool fullRedraw);
     
     void createInstance();
     void createSurface(GLFWwindow* window);
@@ -43,8 +181,19 @@ private:
     void createSwapchain(GLFWwindow* window);
     void createImageViews();
     void createRenderPass();
+    void createLayerRenderPasses();
+    VkFormat findDepthFormat();
+    void createDescriptorSetLayout();
     void createPipelineLayout();
     void createPipeline();
+    void createCompositePipeline();
+    void createCullPipeline();
+    void createHudPipeline();
+    void createQueryPool();
+    void createGlyphAtlas();
+    void createDescriptorPool();
+    void writeContentDescriptor(GpuLayer& layer);
+    void writeCullDescriptor(GpuLayer& layer);
 
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
     bool isDeviceSuitable(VkPhysicalDevice device);
@@ -63,17 +212,77 @@ private:
     VkFormat m_swapchainImageFormat;
     VkExtent2D m_swapchainExtent;
     
-    VkRenderPass m_renderPass;
+    VkRenderPass m_renderPass;                      // Clears the image: first use of an image or a full redraw
+    VkRenderPass m_loadRenderPass = VK_NULL_HANDLE; // Keeps the previous contents; only damaged regions are redrawn
+    VkRenderPass m_layerClearPass = VK_NULL_HANDLE; // Same pair for layer images, left ready for sampling
+    VkRenderPass m_layerLoadPass = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
     VkPipelineLayout m_pipelineLayout;
-    std::unique_ptr<Pipeline> m_pipeline;
-    std::vector<std::unique_ptr<Model>> m_renderObjects;
+    VkFormat m_depthFormat = VK_FORMAT_UNDEFINED;  // Depth attachment of layer images
+    // Layer content from the instance buffer: opaque rects front to back with depth writes,
+    // then translucent rects and glyphs blended back to front over them
+    std::unique_ptr<Pipeline> m_opaquePipeline;
+    std::unique_ptr<Pipeline> m_translucentPipeline;
+    VkDescriptorSetLayout m_compositeSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_compositeLayout = VK_NULL_HANDLE;
+    std::unique_ptr<Pipeline> m_compositePipeline;  // Textured layer quads into the swapchain image
+    // Отсечение списков отрисовки по перерисовываемой области на GPU; рисуется косвенно. Только с --gpu-cull
+    VkDescriptorSetLayout m_cullSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_cullLayout = VK_NULL_HANDLE;
+    std::unique_ptr<ComputePipeline> m_cullPipeline;
+    VkPipelineLayout m_hudLayout = VK_NULL_HANDLE;
+    std::unique_ptr<Pipeline> m_hudPipeline;        // Solid overlay rects, one instance each
+
+    // Слои рисуются в свои изображения; кадр собирается из их квадов
+    std::unique_ptr<LayerTree> m_layers;
+    std::unordered_map<const StyledNode*, GpuLayer> m_gpuLayers; // By layer owner
+    std::vector<CompositeQuad> m_quads;
+    size_t m_lastUploadBytes = 0;
+    std::vector<FrameUploads> m_uploads; // [frame in flight]
+
+    std::unique_ptr<TextPainter> m_textPainter;
+    std::unique_ptr<Texture> m_glyphTexture;
+    VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+
+    // Документ, компоновка и списки отображения живут в своём потоке; кадр берёт готовый снимок
+    std::unique_ptr<DocumentWorker> m_worker;
+    uint64_t m_snapshotVersion = 0;
+    float m_scrollY = 0.0f;
+    float m_scrollAnchor = 0.0f;   // Scroll anchoring shifts of the applied snapshots
+    float m_documentHeight = 0.0f; // Of the applied snapshot
+    bool m_scrollChanged = false;
+
+    DamageTracker m_damage;
+    bool m_incrementalPresent = false; // VK_KHR_incremental_present enabled
+    bool m_logRepaint = false;
 
     VkCommandPool m_commandPool;
     std::vector<VkCommandBuffer> m_commandBuffers;
+    // Запись слоёв раздаётся потокам; у каждого потока свой пул команд на каждый кадр в полёте
+    std::unique_ptr<ThreadPool> m_recordPool;
+    std::vector<std::vector<RecordContext>> m_recordContexts; // [frame in flight][ThreadPool::threadIndex()]
+    size_t m_lastChunks = 0;
+    double m_lastRecordMs = 0.0;
+    uint32_t m_lastDrawCalls = 0;
+
+    // Оверлей производительности: прямоугольники пишутся в свой буфер кадра в полёте
+    PerfHud m_hud;
+    bool m_hudVisible = false;
+    bool m_hudHidden = false; // Just hidden: the page under it is redrawn once more
+    std::vector<std::unique_ptr<GpuBuffer>> m_hudBuffers; // HudRect per instance, [frame in flight]
+    uint32_t m_hudCount = 0;                              // Rects written for the current frame
+    // Две метки времени на кадр в полёте вокруг его командного буфера
+    VkQueryPool m_queryPool = VK_NULL_HANDLE;
+    float m_timestampPeriod = 0.0f; // Nanoseconds per tick
+    uint64_t m_timestampMask = 0;
+    std::vector<bool> m_queriesWritten; // [frame in flight]
+    std::chrono::steady_clock::time_point m_lastFrameStart;
 
     std::vector<VkSemaphore> m_imageAvailableSemaphores;
     std::vector<VkSemaphore> m_renderFinishedSemaphores;
     std::vector<VkFence> m_inFlightFences;
     uint32_t m_currentFrame = 0;
-    const int MAX_FRAMES_IN_FLIGHT = 2;
+    PresentConfig m_config;
+    LatencyProbe m_latency;
+    LatencyProbe m_applyLatency; // From applying a snapshot on the render thread to the present of its frame
 };
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct GLFWwindow;
+
+// Copies RGBA8 frames into the X11 window behind a GLFW window with XPutImage. Kept apart
+// from the rest of the engine: Xlib headers define names (Font, Window) that clash with ours.
+class X11Blitter {
+public:
+    explicit X11Blitter(GLFWwindow* window);
+    ~X11Blitter();
+
+    X11Blitter(const X11Blitter&) = delete;
+    X11Blitter& operator=(const X11Blitter&) = delete;
+
+    // `pixels` hold red in the lowest byte, as in Framebuffer.
+    void present(const std::vector<uint32_t>& pixels, uint32_t width, uint32_t height);
+
+private:
+    void* m_display = nullptr;
+    unsigned long m_window = 0;
+    void* m_gc = nullptr;
+    void* m_visual = nullptr;
+    int m_depth = 24;
+    bool m_swapRedBlue = true;          // Окно хранит пиксели как 0xXXRRGGBB
+    std::vector<uint32_t> m_pixels;     // Кадр в порядке байт окна
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "document/Event.hpp"
+#include "parser/DomNode.hpp"
+#include "parser/StyledNode.hpp"
+#include "parser/CssStructs.hpp"
+#include "parser/InvalidationSet.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// What the downstream stages (layout, paint) have to redo after a style update.
+struct StyleUpdate {
+    std::vector<StyledNode*> layoutDirty;     // Geometry of these nodes may have changed
+    std::vector<StyledNode*> paintDirty;      // Only colors of these nodes changed
+    std::vector<StyledNode*> childrenChanged; // These nodes gained or lost children
+    std::vector<StyledNode*> compositeDirty;  // Only transform or opacity of these nodes changed
+    std::vector<StyledNode*> textChanged;     // Text nodes whose content changed in place
+    size_t restyledNodes = 0;
+
+    bool needsLayout() const { return !layoutDirty.empty() || !childrenChanged.empty() || !textChanged.empty(); }
+    bool needsPaint() const { return needsLayout() || !paintDirty.empty(); }
+    bool needsComposite() const { return !compositeDirty.empty(); }
+};
+
+// Owns the DOM, the stylesheet and the styled tree, and keeps them in sync when the DOM
+// is mutated. Mutations only record invalidations; updateStyles() applies them.
+class Document {
+public:
+    Document(const std::string& htmlContent, const std::string& cssContent);
+
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    DomNode& root() { return *m_domRoot; }
+    const StyledNode& styleRoot() const { return *m_styleRoot; }
+    const Stylesheet& stylesheet() const { return m_stylesheet; }
+    StyledNode* styledNodeFor(const DomNode& node) const;
+    DomNode* getElementById(const std::string& id) const;
+
+    // --- Mutation API ---
+    void setAttribute(DomNode& node, const std::string& name, const std::string& value);
+    void removeAttribute(DomNode& node, const std::string& name);
+    void toggleClass(DomNode& node, const std::string& className);
+    DomNode& insertChild(DomNode& parent, std::unique_ptr<DomNode> child, size_t index);
+    DomNode& appendChild(DomNode& parent, std::unique_ptr<DomNode> child);
+    std::unique_ptr<DomNode> removeChild(DomNode& parent, DomNode& child);
+    void setText(DomNode& textNode, const std::string& text);
+
+    // --- Events ---
+    // Listeners belong to the node; removing the node from the document drops them.
+    void addEventListener(DomNode& node, EventType type, EventListener listener);
+    // Runs the listeners of the target and then of each ancestor, until propagation is
+    // stopped. Listeners may mutate the document but must not destroy nodes on the path.
+    void dispatchEvent(Event& event);
+
+    bool hasPendingChanges() const { return !m_pendingRestyle.empty() || m_pending.needsPaint() || m_pending.needsComposite(); }
+
+    // Recomputes styles of every invalidated node and returns the accumulated dirtiness.
+    StyleUpdate updateStyles();
+
+private:
+    void invalidateAttribute(DomNode& node, const std::string& name,
+                             const std::string& oldValue, const std::string& newValue);
+    void scheduleRestyle(StyledNode& node);
+    void registerSubtree(StyledNode& node);
+    void unregisterSubtree(const StyledNode& node);
+
+    std::unique_ptr<DomNode> m_domRoot;
+    Stylesheet m_stylesheet;
+    InvalidationSet m_invalidationSet;
+    std::unique_ptr<StyledNode> m_styleRoot;
+
+    std::unordered_map<const DomNode*, StyledNode*> m_styledNodes;
+    std::unordered_map<const DomNode*, std::vector<std::pair<EventType, EventListener>>> m_listeners;
+    std::vector<StyledNode*> m_pendingRestyle;
+    StyleUpdate m_pending;
+
+    // Styled subtrees removed from the document are kept alive until the update after the
+    // one that reported them, so caches keyed by StyledNode* never see a recycled address.
+    std::vector<std::unique_ptr<StyledNode>> m_detachedStyles;
+    std::vector<std::unique_ptr<StyledNode>> m_retiredStyles;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "RenderEngine.hpp"
+#include "render/LayerTree.hpp"
+#include "utils/TripleBuffer.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Document;
+class LayoutEngine;
+class PointerDispatcher;
+class SpatialIndex;
+class ThreadPool;
+
+// One complete version of the page as the render thread draws it. Layer contents are
+// immutable and shared with earlier snapshots while unchanged, so publishing a snapshot
+// copies the layer list only.
+struct DocumentSnapshot {
+    uint64_t version = 0;        // 0 until the document is parsed and laid out
+    float scrollY = 0.0f;        // Scroll offset the layers were painted for
+    float scrollAnchor = 0.0f;   // Sum of all scroll anchoring shifts so far
+    float documentHeight = 0.0f;
+    std::vector<Layer> layers;
+    // Update that produced this snapshot, for the performance overlay; negative while unknown
+    float styleMs = -1.0f, layoutMs = -1.0f, paintMs = -1.0f;
+};
+
+// Owns the document and everything derived from it on the CPU (parsing, style, layout,
+// layers and their display lists, hit testing) on a thread of its own. Other threads feed
+// it mutations and input through a queue; the render thread picks up the latest complete
+// snapshot from a lock-free triple buffer and never waits for the worker.
+class DocumentWorker {
+public:
+    // Starts the thread; parsing and the first layout already run on it.
+    DocumentWorker(std::string htmlContent, std::string cssContent, float width, float height);
+    ~DocumentWorker();
+
+    DocumentWorker(const DocumentWorker&) = delete;
+    DocumentWorker& operator=(const DocumentWorker&) = delete;
+
+    // Runs the task with the document on the worker thread, before its next snapshot.
+    void post(DocumentTask task);
+    // Scroll offset the render thread shows, with the anchoring total it has applied so far.
+    void scrollTo(float y, float scrollAnchor);
+    // Pointer input in window coordinates, turned into DOM events on the worker thread.
+    void pointerMoved(float x, float y);
+    void pointerButton(int button, bool pressed);
+    void pointerLeft();
+
+    // Render thread only: true if a newer snapshot replaced snapshot().
+    bool consume() { return m_snapshots.consume(); }
+    const DocumentSnapshot& snapshot() const { return m_snapshots.front(); }
+
+    // Rethrows on the calling thread if the worker thread stopped with an error.
+    void checkFailure();
+    // Blocks until every command posted so far is applied and published.
+    void waitIdle();
+
+private:
+    struct Command {
+        enum class Kind { TASK, SCROLL, POINTER_MOVE, POINTER_BUTTON, POINTER_LEAVE };
+        Kind kind;
+        DocumentTask task;
+        float x = 0.0f, y = 0.0f;
+        float scrollAnchor = 0.0f;
+        int button = 0;
+        bool pressed = false;
+    };
+
+    void push(Command command);
+    void run(const std::string& htmlContent, const std::string& cssContent);
+    void build(const std::string& htmlContent, const std::string& cssContent);
+    void apply(Command& command);
+    void update();
+    void publish();
+    Rect viewport() const;
+
+    const float m_width, m_height;
+
+    // Принадлежит потоку документа
+    std::unique_ptr<Document> m_document;
+    std::unique_ptr<ThreadPool> m_threadPool;
+    std::unique_ptr<LayoutEngine> m_layoutEngine;
+    std::unique_ptr<LayerTree> m_layers;
+    std::unique_ptr<SpatialIndex> m_spatialIndex;
+    std::unique_ptr<PointerDispatcher> m_pointer;
+    float m_scrollY = 0.0f, m_scrollAnchor = 0.0f;
+    bool m_scrollChanged = false;
+    uint64_t m_version = 0;
+    float m_styleMs = -1.0f, m_layoutMs = -1.0f, m_paintMs = -1.0f; // Of the last update
+
+    TripleBuffer<DocumentSnapshot> m_snapshots;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;     // Commands arrived or the worker must stop
+    std::condition_variable m_idleCondition; // The queue drained
+    std::vector<Command> m_commands;
+    bool m_busy = true;                      // Building, or applying a batch of commands
+    bool m_stopping = false;
+    std::string m_failure;
+    std::atomic<bool> m_failed{false};
+    std::thread m_thread;
+};
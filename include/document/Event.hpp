@@ -0,0 +1,28 @@
+#pragma once
+
+#include "parser/DomNode.hpp"
+#include <functional>
+
+enum class EventType {
+    MOUSE_MOVE,
+    MOUSE_OVER, // The pointer entered the target (or one of its descendants became the target)
+    MOUSE_OUT,  // The pointer left the target
+    MOUSE_DOWN,
+    MOUSE_UP,
+    CLICK       // Button pressed and released over the same element
+};
+
+// A pointer event. It is delivered to the target first and then bubbles up through its
+// ancestors, like DOM events do.
+struct Event {
+    EventType type;
+    DomNode* target = nullptr;        // Innermost element under the pointer
+    DomNode* currentTarget = nullptr; // Element whose listeners are running
+    float x = 0.0f, y = 0.0f;         // Document coordinates
+    int button = 0;
+    bool propagationStopped = false;
+
+    void stopPropagation() { propagationStopped = true; }
+};
+
+using EventListener = std::function<void(Event&)>;
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "document/Event.hpp"
+#include "layout/DisplayList.hpp"
+#include <vector>
+
+class Document;
+class LayerTree;
+class SpatialIndex;
+
+// Turns pointer input in window coordinates into DOM events (over/out, move, down/up,
+// click). Hit tests run against the spatial index of the last drawn frame; the hovered and
+// pressed elements are remembered between events. The index holds untransformed document
+// rects, so with compositor layers the point is moved into each layer's own coordinates.
+class PointerDispatcher {
+public:
+    PointerDispatcher(Document& document, const SpatialIndex& index) : m_document(document), m_index(index) {}
+
+    // Scroll offset the index was built with: document y = window y + offset.
+    void setScrollOffset(float y) { m_scrollY = y; }
+    // Layers whose translation is undone before querying the index (nullptr = none).
+    void setLayers(const LayerTree* layers) { m_layers = layers; }
+
+    void moved(float x, float y);
+    void button(int button, bool pressed);
+    void left();
+    // Re-targets hover after the content under a stationary pointer changed.
+    void refresh();
+
+    // Innermost element under a window-coordinate point, or nullptr.
+    DomNode* elementAt(float x, float y);
+
+private:
+    // First live element among the hits painted into `layer` (any layer when no layer tree).
+    DomNode* firstHit(size_t layer) const;
+    void dispatch(EventType type, DomNode* target, int button = 0);
+
+    Document& m_document;
+    const SpatialIndex& m_index;
+    const LayerTree* m_layers = nullptr;
+    std::vector<DisplayKey> m_hits;
+    DomNode* m_hovered = nullptr;
+    DomNode* m_pressed = nullptr;
+    float m_x = 0.0f, m_y = 0.0f, m_scrollY = 0.0f;
+    bool m_inside = false;
+};
@@ -1,14 +1,51 @@
 #pragma once
 
-#include "LayoutBox.hpp"
+#include "LayoutTree.hpp"
 #include "../utils/Color.hpp" 
+#include <cstdint>
+#include <functional>
+#include <string>
 #include <vector>
 
+// Stable identity of a command across frames: the box's styled node plus the part of the
+// box it paints (the line number for text).
+struct DisplayKey {
+    const StyledNode* node = nullptr;
+    uint32_t part = 0;
+
+    bool operator==(const DisplayKey& other) const { return node == other.node && part == other.part; }
+};
+
+struct DisplayKeyHash {
+    size_t operator()(const DisplayKey& key) const {
+        size_t h = std::hash<const void*>()(key.node);
+        return h ^ ((static_cast<size_t>(key.part) * 0x9E3779B97F4A7C15ull) + (h << 6) + (h >> 2));
+    }
+};
+
 struct SolidRectCommand {
     Rect rect;
     Color color;
+    DisplayKey key;
 };
 
-using DisplayList = std::vector<SolidRectCommand>;
+// One line of text; rect is the line box in document coordinates.
+struct TextCommand {
+    Rect rect;
+    Color color;
+    float fontSize;
+    std::string text;
+    DisplayKey key;
+};
+
+// Text is painted after all rectangles: block backgrounds never overlap text of other boxes.
+struct DisplayList {
+    std::vector<SolidRectCommand> rects;
+    std::vector<TextCommand> texts;
+
+    size_t size() const { return rects.size() + texts.size(); }
+};
 
-DisplayList buildDisplayList(const LayoutBox& layoutRoot);
+DisplayList buildDisplayList(const LayoutTree& layoutTree);
+// Only emits boxes intersecting `clip` (document coordinates), skipping whole subtrees when possible.
+DisplayList buildDisplayList(const LayoutTree& layoutTree, const Rect& clip);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "DisplayList.hpp"
+#include <cstddef>
+
+// What the optimization pass removed, and how many pixels the rectangles fill before
+// and after it. Overdraw factor = filled pixels / area of the target rectangle.
+struct OverdrawStats {
+    size_t commandsBefore = 0, commandsAfter = 0;
+    size_t invisibleDropped = 0; // Transparent or empty rects
+    size_t occludedDropped = 0;  // Fully hidden under later opaque rects
+    size_t clipped = 0;          // Partially hidden rects trimmed to their visible part
+    size_t merged = 0;           // Rects folded into an adjacent same-color neighbour
+    double pixelsBefore = 0.0, pixelsAfter = 0.0, targetPixels = 0.0;
+
+    double overdrawBefore() const { return targetPixels > 0 ? pixelsBefore / targetPixels : 0.0; }
+    double overdrawAfter() const { return targetPixels > 0 ? pixelsAfter / targetPixels : 0.0; }
+};
+
+// Removes fill work that cannot change the image inside `target` (document coordinates):
+// rects are clipped to the target, invisible ones dropped, rects hidden under later opaque
+// rects culled or trimmed with a tile coverage grid, and consecutive same-color rects that
+// share an edge merged. Paint order of the remaining commands is preserved.
+OverdrawStats optimizeDisplayList(DisplayList& list, const Rect& target);
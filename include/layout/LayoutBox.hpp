@@ -1,27 +1,43 @@
 #pragma once
 
-#include "parser/StyledNode.hpp"
-#include <vector>
-#include <memory>
+#include <cstdint>
 
 // A simple structure for a rectangle
 struct Rect {
-    float x, y, width, height;
+    float x = 0.0f, y = 0.0f, width = 0.0f, height = 0.0f;
 };
 
 // Represents the display type of a box (block or inline)
-enum class DisplayType {
+enum class DisplayType : uint8_t {
     BLOCK,
     INLINE,
     NONE
 };
 
-class LayoutBox {
-public:
-    LayoutBox(const StyledNode& node) : styledNode(node) {}
+// Box-model values resolved once from a node's specified values, so layout never
+// touches the property map. Zero width/height means "auto".
+struct BoxModel {
+    float width = 0.0f, height = 0.0f;
+    float marginTop = 0.0f, marginBottom = 0.0f, marginLeft = 0.0f;
+    float padding = 0.0f;
+    DisplayType display = DisplayType::BLOCK;
 
-    const StyledNode& styledNode;
-    Rect dimensions;
-    DisplayType displayType = DisplayType::BLOCK; // Default to block
-    std::vector<std::unique_ptr<LayoutBox>> children;
+    bool operator==(const BoxModel& o) const {
+        return width == o.width && height == o.height && marginTop == o.marginTop &&
+               marginBottom == o.marginBottom && marginLeft == o.marginLeft && padding == o.padding &&
+               display == o.display;
+    }
+    bool operator!=(const BoxModel& o) const { return !(*this == o); }
+};
+
+// Incremental layout state bits
+enum LayoutFlags : uint8_t {
+    LAYOUT_CLEAN = 0,
+    LAYOUT_NEEDS_LAYOUT = 1 << 0,       // Own style or child list changed
+    LAYOUT_CHILD_NEEDS_LAYOUT = 1 << 1, // Some descendant needs layout
+    LAYOUT_IS_ELEMENT = 1 << 2,         // Element box; other boxes are single-line text runs
+    LAYOUT_ESTIMATED = 1 << 3,          // Off-screen box holding an estimated height; subtree not laid out
+    // Geometry facts the display list relies on to skip subtrees; set by the box's own layout
+    LAYOUT_UNORDERED_CHILDREN = 1 << 4, // Some child starts (or its content reaches) above an earlier sibling
+    LAYOUT_OVERFLOWS = 1 << 5           // Some descendant reaches outside the box's rect
 };
@@ -1,16 +1,93 @@
 #pragma once
 
 #include "parser/StyledNode.hpp"
-#include "LayoutBox.hpp"
+#include "LayoutTree.hpp"
 #include <memory>
+#include <unordered_map>
 
+class ThreadPool;
+
+// Per-pass counters of the incremental layout.
+struct LayoutStats {
+    size_t boxesLaidOut = 0;         // Boxes whose geometry was recomputed
+    size_t subtreesReused = 0;       // Clean subtrees skipped thanks to the width cache
+    size_t boxesEstimated = 0;       // Off-screen subtrees given an estimated height (lazy mode)
+    size_t textsMeasured = 0;        // Text boxes whose words had to be measured (not just re-broken)
+    float scrollAnchorShift = 0.0f;  // Height change of content fully above the viewport
+    // Lazy mode: height and box count of what was laid out in this pass, feeding the estimate
+    double measuredHeight = 0.0;
+    size_t measuredBoxes = 0;
+};
+
+// Owns a persistent, flat layout tree. After the initial build, only boxes marked dirty
+// (and the ancestors that must re-stack their children) are laid out again.
 class LayoutEngine {
 public:
-    static std::unique_ptr<LayoutBox> buildLayoutTree(const StyledNode& styledRoot);
+    // One-shot helper: builds and lays out a fresh tree for an 800x600 viewport.
+    static LayoutTree buildLayoutTree(const StyledNode& styledRoot);
+
+    void build(const StyledNode& styledRoot);
+    void setViewport(float width, float height);
+    // Large block subtrees are laid out concurrently on this pool (nullptr = single-threaded).
+    void setThreadPool(ThreadPool* pool) { m_threadPool = pool; }
+
+    // Lazy mode lays out in detail only boxes intersecting the viewport plus a prefetch
+    // margin; dirty off-screen subtrees keep an estimated height until they scroll in.
+    // With a thread pool, off-screen children are deferred before the in-window ones fan out.
+    void setLazyLayout(bool enabled, float prefetchMargin = 1000.0f);
+    void setScrollOffset(float scrollY) { m_scrollY = scrollY; }
+    float documentHeight() const;
+
+    // Invalidation entry points, keyed by the styled node that changed.
+    void styleChanged(const StyledNode& node); // Re-resolves values, relayouts only if geometry inputs changed
+    void markNeedsLayout(const StyledNode& node);
+    void rebuildChildren(const StyledNode& node);
+    void textChanged(const StyledNode& node); // Re-measures the words of a text box in place
+
+    const LayoutStats& relayout();
+    const LayoutStats& lastStats() const { return m_stats; }
+    const LayoutTree& tree() const { return m_tree; }
 
 private:
-    void layout(LayoutBox& box, const Rect& containingBlock);
-    
-    // Member variables for the layout process
-    Rect m_containingBlock;
+    BoxIndex indexOf(const StyledNode& node) const;
+    void reindex(BoxIndex begin, BoxIndex end);
+    void markNeedsLayout(BoxIndex box);
+    void layout(BoxIndex box, float containingWidth, float originY, LayoutStats& stats, bool allowParallel);
+    bool isClean(BoxIndex box, float containingWidth) const;
+    bool inWindow(float top, float height) const;
+    bool deferOffscreen(BoxIndex box, float containingWidth, float top, LayoutStats& stats);
+    float estimateHeight(BoxIndex box, const LayoutStats& stats) const;
+    // Block child laid out (or deferred) ahead of the sequential stacking pass
+    struct ParallelChild {
+        float oldHeight;    // Height before this pass, for the scroll anchor
+        float nestedShift;  // Scroll anchor shift accumulated inside the child's subtree
+        bool deferred;      // Left to the stacking pass: off-screen by the provisional top
+    };
+    void layoutChildrenParallel(BoxIndex box, float contentWidth, float contentTop, LayoutStats& stats,
+                                std::vector<ParallelChild>& children);
+    float layoutInlineRun(BoxIndex first, BoxIndex end, float originX, float originY, float width, LayoutStats& stats);
+
+    LayoutTree m_tree;
+    // Box of each styled node as of some edit; later edits are applied on lookup, so a splice
+    // re-indexes only its own range instead of every box after it
+    struct IndexEntry {
+        BoxIndex box;
+        uint32_t edits; // m_shifts.size() when the entry was written
+    };
+    struct IndexShift {
+        BoxIndex from; // Boxes at or after this index ...
+        int64_t delta; // ... moved by this much
+    };
+    std::unordered_map<const StyledNode*, IndexEntry> m_indices;
+    std::vector<IndexShift> m_shifts;
+    Rect m_viewport = {0.0f, 0.0f, 800.0f, 600.0f};
+    LayoutStats m_stats;
+    ThreadPool* m_threadPool = nullptr;
+
+    bool m_lazy = false;
+    float m_prefetchMargin = 1000.0f;
+    float m_scrollY = 0.0f;
+    // Running average used to estimate heights of never-laid-out subtrees (earlier passes)
+    double m_measuredHeight = 0.0;
+    size_t m_measuredBoxes = 0;
 };
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "LayoutBox.hpp"
+#include "parser/StyledNode.hpp"
+#include "utils/Color.hpp"
+#include "text/TextMetrics.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using BoxIndex = uint32_t;
+constexpr BoxIndex NO_BOX = UINT32_MAX;
+
+constexpr float DEFAULT_FONT_SIZE = 16.0f;
+
+float parse_px(const std::string& value, float fallback);
+float get_px_value(const PropertyMap& values, const std::string& name, float fallback);
+BoxModel resolveBoxModel(const PropertyMap& values);
+
+// One line fragment of a text box: words [firstWord, endWord), rect relative to the box.
+struct TextLine {
+    uint32_t firstWord, endWord;
+    Rect rect;
+};
+
+// Line-broken content of a text box. Metrics survive relayout; lines are rebuilt from them.
+struct InlineText {
+    TextMetrics metrics;
+    std::vector<TextLine> lines;
+};
+
+// Layout tree stored as preorder-indexed parallel arrays (structure of arrays).
+// The subtree of box i occupies [i, subtreeEnd[i]); its first child is i + 1 and the
+// sibling after child c is subtreeEnd[c]. Geometry is relative to the parent box, so
+// a clean subtree stays valid when an ancestor or an earlier sibling moves.
+struct LayoutTree {
+    std::vector<const StyledNode*> styledNodes;
+    std::vector<BoxIndex> parents;
+    std::vector<BoxIndex> subtreeEnd;
+    std::vector<BoxModel> boxModels;
+    std::vector<Color> backgrounds;
+    std::vector<Color> foregrounds; // Inherited `color`, used by text
+    std::vector<float> fontSizes;   // Inherited `font-size` in pixels
+    std::vector<Rect> geometry;
+    std::vector<uint8_t> flags;
+    std::vector<float> cachedContainingWidth; // Cache key: containing-block width of the last layout
+    std::vector<std::unique_ptr<InlineText>> texts; // Text boxes only, null for elements
+
+    size_t size() const { return styledNodes.size(); }
+    bool isElement(BoxIndex i) const { return flags[i] & LAYOUT_IS_ELEMENT; }
+    bool isInline(BoxIndex i) const { return boxModels[i].display == DisplayType::INLINE; }
+    void clear();
+    void reserve(size_t count);
+
+    // Appends the box subtree generated by a styled subtree (whitespace text is skipped).
+    void appendStyledSubtree(const StyledNode& styledNode, BoxIndex parent);
+    // Appends boxes [begin, end) of another tree, keeping their layout cache.
+    void appendRange(const LayoutTree& source, BoxIndex begin, BoxIndex end, BoxIndex parent);
+    // Replaces the descendants of `box` with `fragment`, a forest with local indices whose
+    // top-level boxes have parent NO_BOX. Boxes after the splice point shift accordingly.
+    // The fragment is consumed.
+    void replaceDescendants(BoxIndex box, LayoutTree&& fragment);
+
+    // Re-resolves box-model, paint and inherited text values; returns true if anything
+    // affecting geometry (box model or font size) changed. Inherited values are taken from
+    // the parent box, which must already be resolved.
+    bool resolveStyle(BoxIndex i);
+
+    static bool generatesBox(const StyledNode& node);
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "DisplayList.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct SpatialIndexStats {
+    size_t inserted = 0, removed = 0, moved = 0, unchanged = 0;
+    bool rebuilt = false; // The grid was resized and refilled from scratch
+};
+
+// Uniform grid over the boxes of a display list (document coordinates) for hit testing and
+// region queries. Each cell lists the boxes overlapping it; boxes spanning too many cells
+// live in a separate list checked by every query. Updates are keyed by DisplayKey, so a
+// frame that moves a few boxes only touches the cells of those boxes.
+class SpatialIndex {
+public:
+    static constexpr float CELL_SIZE = 64.0f;
+    static constexpr size_t MAX_CELLS = 1 << 20;      // Cells get coarser when the area outgrows this
+    static constexpr size_t MAX_CELLS_PER_BOX = 1024; // Larger boxes go to the oversized list
+
+    // Synchronizes the index with `list`; paint order is taken from the list (rects, then text).
+    // Queries are answered inside `area` only; without it the area is the bounds of the list.
+    const SpatialIndexStats& update(const DisplayList& list);
+    const SpatialIndexStats& update(const DisplayList& list, const Rect& area);
+
+    // Boxes containing the point, topmost (painted last) first.
+    void hitTest(float x, float y, std::vector<DisplayKey>& hits) const;
+    // Boxes intersecting `region`, in paint order.
+    void query(const Rect& region, std::vector<DisplayKey>& result) const;
+
+    size_t size() const { return m_ids.size(); }
+    size_t cellCount() const { return m_cells.size(); }
+    size_t oversizedCount() const { return m_oversized.size(); }
+    const SpatialIndexStats& stats() const { return m_stats; }
+
+private:
+    enum class Placement : uint8_t { NONE, CELLS, OVERSIZED };
+    struct Entry {
+        DisplayKey key;
+        Rect rect;
+        uint32_t order = 0;
+        uint64_t frame = 0; // 0 — свободная запись
+        Placement placement = Placement::NONE;
+    };
+    struct CellRange { int c0, r0, c1, r1; };
+    // Прямоугольник хранится прямо в ячейке: запрос идёт по памяти подряд, не прыгая по записям
+    struct CellItem {
+        Rect rect;
+        uint32_t id;
+    };
+
+    const SpatialIndexStats& synchronize(const DisplayList& list, const Rect* area);
+    void add(const DisplayKey& key, const Rect& rect, uint32_t order);
+    uint32_t allocate();
+    bool cells(const Rect& rect, CellRange& range) const;
+    void link(uint32_t id);
+    void unlink(uint32_t id);
+    bool covers(const Rect& area) const;
+    void resize(const Rect& area);
+
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_free;
+    std::unordered_map<DisplayKey, uint32_t, DisplayKeyHash> m_ids;
+
+    // Порядок прошлого обновления: по нему ключи находятся без хеш-таблицы
+    std::vector<uint32_t> m_order, m_previousOrder;
+    std::vector<uint32_t> m_previousPosition;
+    size_t m_cursor = 0;
+
+    float m_originX = 0.0f, m_originY = 0.0f, m_cellSize = CELL_SIZE;
+    int m_columns = 0, m_rows = 0;
+    std::vector<std::vector<CellItem>> m_cells;
+    std::vector<uint32_t> m_oversized;
+    bool m_relink = false; // Сетка пересоздана: записи раскладываются по ячейкам в конце обновления
+
+    uint64_t m_frame = 0;
+    mutable std::vector<uint64_t> m_visited;
+    mutable uint64_t m_visit = 0;
+    mutable std::vector<uint32_t> m_candidates;
+    SpatialIndexStats m_stats;
+};
@@ -1,7 +1,7 @@
 #pragma once
 #include <string>
 #include <map>
-#include "Logger.hpp"
+#include "utils/Logger.hpp"
 struct Color { float r, g, b, a; };
 inline Color parseColor(const std::string& colorStr) {
     static const std::map<std::string, Color> colorMap = {
@@ -10,6 +10,6 @@ inline Color parseColor(const std::string& colorStr) {
     };
     auto it = colorMap.find(colorStr);
     if (it != colorMap.end()) return it->second;
-    Log::warn("Unknown color: " + colorStr);
+    Log::warnf("Unknown color: %s", colorStr.c_str());
     return {1.0f, 0.0f, 1.0f, 1.0f};
 }
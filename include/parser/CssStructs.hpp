@@ -8,6 +8,7 @@ using Declaration = std::pair<std::string, std::string>;
 
 struct Selector {
     std::string tagName;
+    std::string id;
     std::vector<std::string> classes;
 };
 
@@ -16,6 +16,7 @@ public:
         : type(type), value(value) {}
 
     std::vector<std::unique_ptr<DomNode>> children;
+    DomNode* parent = nullptr; // Non-owning back pointer, maintained by the parser and Document
     NodeType type;
     std::string value;
 
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CssStructs.hpp"
+#include "DomNode.hpp"
+#include "StyledNode.hpp"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Per-stylesheet index from selector keys (class, id, tag) to the rules that mention them.
+// Selectors are compound only (no combinators), so changing a node's classes or id can
+// affect the node itself but never its descendants or siblings.
+class InvalidationSet {
+public:
+    InvalidationSet() = default;
+    explicit InvalidationSet(const Stylesheet& stylesheet);
+
+    bool dependsOnClass(const std::string& className) const { return m_classDeps.count(className) != 0; }
+    bool dependsOnId(const std::string& id) const { return m_idDeps.count(id) != 0; }
+
+    // Same result as StyleApplier::computeStyle, but only evaluates rules bucketed under
+    // the node's id, classes, tag or the universal selector.
+    PropertyMap computeStyle(const DomNode& node, const Stylesheet& stylesheet) const;
+
+    // Properties that only change colors and never box geometry.
+    static bool isPaintOnlyProperty(const std::string& name);
+    // Properties applied by the compositor to a layer as a whole; no repaint is needed.
+    static bool isCompositeOnlyProperty(const std::string& name);
+
+private:
+    void collectCandidates(const std::unordered_map<std::string, std::vector<size_t>>& buckets,
+                           const std::string& key, std::vector<size_t>& out) const;
+
+    std::unordered_map<std::string, std::vector<size_t>> m_byId;
+    std::unordered_map<std::string, std::vector<size_t>> m_byClass;
+    std::unordered_map<std::string, std::vector<size_t>> m_byTag;
+    std::vector<size_t> m_universal;
+
+    std::unordered_set<std::string> m_classDeps;
+    std::unordered_set<std::string> m_idDeps;
+};
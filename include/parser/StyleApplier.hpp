@@ -4,11 +4,18 @@
 #include "StyledNode.hpp"
 #include "CssStructs.hpp"
 #include <memory>
+#include <string>
+#include <vector>
+
+// Splits a class attribute value "class1 class2" into individual class names.
+std::vector<std::string> splitClasses(const std::string& classString);
 
 class StyleApplier {
 public:
     static std::unique_ptr<StyledNode> applyStyles(const DomNode& root, const Stylesheet& stylesheet);
 
-private:
+    // Computes the specified values of a single node by cascading every rule in order.
+    static PropertyMap computeStyle(const DomNode& node, const Stylesheet& stylesheet);
+
     static bool matches(const DomNode& node, const Selector& selector);
 };
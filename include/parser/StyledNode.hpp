@@ -5,15 +5,29 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 // A map from CSS property name to value.
 using PropertyMap = std::map<std::string, std::string>;
 
+// Dirty bits set by Document when the DOM is mutated.
+enum StyleDirtyFlags : uint8_t {
+    STYLE_CLEAN = 0,
+    STYLE_DIRTY_STYLE = 1 << 0,    // specifiedValues must be recomputed
+    STYLE_DIRTY_LAYOUT = 1 << 1,   // box geometry depends on something that changed
+    STYLE_DIRTY_PAINT = 1 << 2,    // only paint properties (colors) changed
+    STYLE_DIRTY_CHILDREN = 1 << 3, // children were inserted or removed
+    STYLE_DIRTY_COMPOSITE = 1 << 4, // only compositor properties (transform, opacity) changed
+    STYLE_DIRTY_TEXT = 1 << 5       // text node content changed
+};
+
 class StyledNode {
 public:
     StyledNode(const DomNode& node) : domNode(node) {}
 
     const DomNode& domNode;
+    StyledNode* parent = nullptr; // Non-owning back pointer
     PropertyMap specifiedValues;
     std::vector<std::unique_ptr<StyledNode>> children;
+    uint8_t dirty = STYLE_CLEAN;
 };
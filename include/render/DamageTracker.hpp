@@ -0,0 +1,56 @@
+#pragma once
+
+#include "layout/LayoutBox.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A pixel rectangle in framebuffer coordinates.
+struct ScreenRect {
+    int32_t x, y;
+    uint32_t width, height;
+};
+
+// Tracks which parts of the screen have to be repainted. Damage is snapped to a tile grid,
+// so the rectangles handed out never overlap and a region is never blended twice. Each
+// swapchain image keeps its own history: an image presented three frames ago misses the
+// damage of all three frames since, so it accumulates every frame's damage until it is
+// rendered again.
+class DamageTracker {
+public:
+    static constexpr int TILE = 32;
+
+    // Resets the history; every image starts fully damaged (its contents are undefined).
+    void reset(uint32_t width, uint32_t height, size_t imageCount);
+
+    // Damage of the frame being built, in framebuffer pixels.
+    void add(const Rect& rect);
+    void addFull();
+
+    // Closes the frame: its damage joins the history of every image.
+    void endFrame();
+    // Damage of the last closed frame alone, as passed to the presentation engine.
+    const std::vector<ScreenRect>& frameDamage() const { return m_frameRects; }
+    bool frameDamageFull() const { return m_frameFull; }
+
+    // Everything image `image` has missed since it was last rendered; clears its history.
+    // `full` is set when the whole image has to be redrawn.
+    std::vector<ScreenRect> takeImageDamage(size_t image, bool& full);
+
+    static uint64_t area(const std::vector<ScreenRect>& rects);
+
+private:
+    struct Mask {
+        std::vector<uint8_t> tiles;
+        bool full = true;
+    };
+
+    void toRects(const Mask& mask, std::vector<ScreenRect>& rects) const;
+
+    uint32_t m_width = 0, m_height = 0;
+    int m_columns = 0, m_rows = 0;
+    Mask m_pending;
+    std::vector<Mask> m_images;
+    std::vector<ScreenRect> m_frameRects;
+    bool m_frameFull = true;
+};
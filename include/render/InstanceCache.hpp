@@ -0,0 +1,126 @@
+#pragma once
+
+#include "layout/DisplayList.hpp"
+#include "text/TextPainter.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// One quad as the vertex shader reads it from the instance storage buffer (std430).
+// Rect is in document pixels; a negative u marks a solid fill.
+struct GpuInstance {
+    float rect[4];
+    float uv[4];
+    float color[4];
+
+    bool operator==(const GpuInstance& other) const;
+    bool operator!=(const GpuInstance& other) const { return !(*this == other); }
+};
+
+// Identity of an instance: the display command plus the glyph within a text command.
+struct InstanceKey {
+    DisplayKey command;
+    uint32_t glyph = 0; // 0 for rects, 1 + glyph index for text
+
+    bool operator==(const InstanceKey& other) const { return command == other.command && glyph == other.glyph; }
+};
+
+struct InstanceKeyHash {
+    size_t operator()(const InstanceKey& key) const {
+        size_t h = DisplayKeyHash()(key.command);
+        h ^= (static_cast<size_t>(key.glyph) * 0xC2B2AE3D27D4EB4Full) + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// One entry of the draw list: the instance slot and its position in paint order, from
+// which the vertex shader derives depth (later paint is nearer).
+struct DrawEntry {
+    uint32_t slot;
+    uint32_t paint;
+
+    bool operator==(const DrawEntry& other) const { return slot == other.slot && paint == other.paint; }
+    bool operator!=(const DrawEntry& other) const { return !(*this == other); }
+};
+
+// Elements [first, first + count) of a GPU-side array that must be rewritten.
+struct InstanceRange {
+    uint32_t first, count;
+};
+
+struct InstanceUpdateStats {
+    size_t inserted = 0, removed = 0, changed = 0, unchanged = 0;
+    size_t moved = 0;                // Instances relocated by compaction
+    size_t instanceBytes = 0;        // Instance slots rewritten
+    size_t orderBytes = 0;           // Draw-list entries rewritten
+    size_t fullUploadBytes = 0;      // What re-uploading everything would cost
+    bool compacted = false;
+
+    size_t bytesUploaded() const { return instanceBytes + orderBytes; }
+};
+
+// CPU mirror of a persistent GPU instance buffer. Every frame the keyed display list is
+// diffed against the previous one: instances keep their slot while their key lives, new
+// keys fill holes from the free list, and only slots whose contents changed are reported
+// dirty. Slot order is unrelated to paint order, so a separate draw list of (slot, paint
+// position) pairs (8 bytes per quad) is diffed too; it only changes when commands are
+// inserted, removed, reordered or turn opaque/translucent. The draw list is split in two:
+// opaque rects front to back, drawn with depth writes and no blending, then translucent
+// rects and glyphs back to front, blended and depth-tested against the opaque ones. When
+// too much of the buffer is holes, live instances from the tail are moved into them.
+class InstanceCache {
+public:
+    // Compaction kicks in when holes exceed this share of the slots.
+    static constexpr double MAX_HOLE_RATIO = 0.25;
+    static constexpr size_t MIN_COMPACT_SLOTS = 1024;
+
+    void begin();
+    void add(const InstanceKey& key, const GpuInstance& instance);
+    const InstanceUpdateStats& end();
+
+    // Records a whole frame: rects first, then glyphs, in paint order.
+    const InstanceUpdateStats& update(const DisplayList& list, const std::vector<GlyphQuad>& glyphs);
+
+    const std::vector<GpuInstance>& slots() const { return m_slots; }
+    const std::vector<DrawEntry>& draws() const { return m_draws; }
+    // draws()[0, opaqueCount) are opaque rects; the rest need blending.
+    size_t opaqueCount() const { return m_opaqueCount; }
+    const std::vector<InstanceRange>& dirtySlots() const { return m_dirtySlots; }
+    const std::vector<InstanceRange>& dirtyDraws() const { return m_dirtyDraws; }
+    // Document-space bounds of everything that appeared, disappeared or changed this frame:
+    // old and new rects of changed instances. Relative paint order of surviving keys never
+    // changes (keys follow document order), so order-only edits add no damage.
+    const std::vector<Rect>& damage() const { return m_damage; }
+    size_t liveCount() const { return m_entries.size(); }
+    size_t holeCount() const { return m_freeSlots.size(); }
+    const InstanceUpdateStats& stats() const { return m_stats; }
+
+private:
+    uint32_t allocate();
+    void write(uint32_t slot, const GpuInstance& instance);
+    void compact();
+    void buildDraws();
+    static void toRanges(std::vector<uint32_t>& indices, std::vector<InstanceRange>& ranges);
+
+    std::unordered_map<InstanceKey, uint32_t, InstanceKeyHash> m_entries; // Key -> slot
+    std::vector<GpuInstance> m_slots;
+    std::vector<InstanceKey> m_slotKeys;
+    std::vector<uint64_t> m_slotFrames; // Last frame that used the slot; 0 for holes
+    std::vector<uint32_t> m_freeSlots;
+    std::vector<uint32_t> m_order, m_previousOrder; // Slots in paint order
+    std::vector<DrawEntry> m_draws, m_previousDraws;
+    size_t m_opaqueCount = 0;
+    std::vector<uint32_t> m_previousPosition; // Slot -> index in m_previousOrder
+    size_t m_cursor = 0;                      // Where the next key is expected in m_previousOrder
+    std::vector<uint32_t> m_touched; // Slots written this frame
+    std::vector<InstanceRange> m_dirtySlots, m_dirtyDraws;
+    std::vector<Rect> m_damage;
+    uint64_t m_frame = 0;
+    InstanceUpdateStats m_stats;
+};
+
+GpuInstance makeInstance(const Rect& rect, const Color& color);
+GpuInstance makeInstance(const GlyphQuad& glyph);
+// Solid fill that hides everything under it: drawn in the opaque pass.
+bool isOpaque(const GpuInstance& instance);
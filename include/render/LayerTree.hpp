@@ -0,0 +1,105 @@
+#pragma once
+
+#include "layout/DisplayList.hpp"
+#include "layout/LayoutTree.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Compositor-only properties of a layer, read from its owner's style. Changing them never
+// repaints the layer: the image is just placed differently.
+struct LayerProperties {
+    float translateX = 0.0f, translateY = 0.0f; // `transform: translate(x, y)`
+    float opacity = 1.0f;
+
+    bool operator==(const LayerProperties& other) const {
+        return translateX == other.translateX && translateY == other.translateY && opacity == other.opacity;
+    }
+    bool operator!=(const LayerProperties& other) const { return !(*this == other); }
+};
+
+// A subtree painted into its own image. Content is painted in document coordinates, so
+// the image holding `raster` is placed on screen at raster + composed translation - scroll.
+struct Layer {
+    const StyledNode* owner = nullptr; // Null for the root layer, the scrolled document
+    BoxIndex box = 0;
+    uint32_t parent = 0;               // Layer the owner is nested in (the root layer for itself)
+    Rect bounds;                       // Untransformed document rect of the subtree
+    LayerProperties properties;
+    LayerProperties composed;          // With the ancestor layers' translation added and opacity multiplied
+    Rect raster;                       // Document region the image holds, whole pixels; empty if none
+    // Commands of this layer inside `raster`. Immutable once painted: a repaint replaces the
+    // pointer, so copies of the layer (document snapshots) share it while it is unchanged.
+    std::shared_ptr<const DisplayList> content;
+    bool repainted = false;            // `content` was rebuilt by the last paint()
+    bool rasterMoved = false;          // ... for a new raster: the whole image must be redrawn
+};
+
+// Placement of a layer image for one frame. The image holds the layer raster at (0, 0).
+struct CompositeQuad {
+    size_t layer;    // Index into LayerTree::layers()
+    Rect screen;     // Destination in framebuffer pixels
+    float opacity;
+};
+
+struct LayerPaintStats {
+    size_t layers = 0, repainted = 0, rasterMoves = 0;
+    size_t commandsBefore = 0, commandsAfter = 0; // Around the overdraw optimization
+};
+
+// Splits the page into compositor layers: the root layer for the document plus one per
+// element with a `will-change` hint, a transform or an opacity. Each layer keeps a
+// rasterized window of its content (the whole layer if it fits into MAX_RASTER_SIZE,
+// otherwise the visible part and about a screen around it), so scrolling and transform or
+// opacity changes only move images until the visible part leaves a window.
+class LayerTree {
+public:
+    static constexpr size_t MAX_LAYERS = 64;          // Further hints paint into their parent layer
+    static constexpr float MAX_RASTER_SIZE = 4096.0f; // Image size limit in either direction
+
+    // Finds the layers of a laid-out tree after relayout. Layers are matched to the previous
+    // ones by owner, so their rasters survive.
+    void update(const LayoutTree& tree, const Rect& viewport);
+    // Re-reads transform and opacity; enough when only compositor properties changed.
+    void updateProperties();
+    // Takes over layers painted by another LayerTree (a document snapshot) to composite
+    // them here. layerOf() and ownsLayer() know nothing about nodes afterwards.
+    void setLayers(const std::vector<Layer>& layers);
+
+    // True if a visible part of some layer is outside its raster.
+    bool needsRaster(const Rect& viewport) const;
+    // Rebuilds layer content: of every layer when `contentChanged`, otherwise of the
+    // layers whose raster must move to cover the viewport.
+    const LayerPaintStats& paint(const LayoutTree& tree, const Rect& viewport, bool contentChanged);
+    // Places the layer images on screen, back to front. `damage` receives the screen rects
+    // covered by quads that appeared, disappeared, moved or faded since the last call.
+    void composite(const Rect& viewport, std::vector<CompositeQuad>& quads, std::vector<Rect>& damage);
+
+    // Offset from the layer's document coordinates to framebuffer pixels, in whole pixels.
+    static void screenOffset(const Layer& layer, const Rect& viewport, float& dx, float& dy);
+
+    const std::vector<Layer>& layers() const { return m_layers; }
+    // Layer that paints the styled node: the nearest layer owner at or above it.
+    size_t layerOf(const StyledNode* node) const;
+    bool ownsLayer(const StyledNode* node) const;
+
+private:
+    // Raster the layer should hold for this viewport; empty if the layer is far off screen.
+    Rect targetRaster(const Layer& layer, const Rect& viewport) const;
+    static Rect visiblePart(const Layer& layer, const Rect& viewport);
+    static LayerProperties readProperties(const StyledNode* node);
+    void composeProperties();
+
+    struct Placement {
+        const StyledNode* owner;
+        Rect screen;
+        float opacity;
+    };
+
+    std::vector<Layer> m_layers;
+    std::unordered_map<const StyledNode*, uint32_t> m_nodeLayers; // Nodes of non-root layers
+    std::vector<Placement> m_placed;                              // Quads of the last composite()
+    LayerPaintStats m_stats;
+};
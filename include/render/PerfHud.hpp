@@ -0,0 +1,58 @@
+#pragma once
+
+#include "layout/LayoutBox.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One solid rectangle of the overlay, read by the HUD pipeline as per-instance vertex input.
+struct HudRect {
+    float rect[4];  // x, y, width, height in framebuffer pixels
+    uint32_t color; // RGBA8, red in the low byte
+};
+
+// What one frame cost, as far as the backend can tell. Negative times are unknown.
+struct HudFrame {
+    float frameMs = 0.0f; // Between the starts of this and the previous frame
+    float gpuMs = -1.0f;  // Timestamps around the frame's command buffer
+    // Render thread; submit includes present
+    float applyMs = 0.0f, waitMs = 0.0f, recordMs = 0.0f, submitMs = 0.0f;
+    // Document thread, for the update behind the snapshot on screen
+    float styleMs = -1.0f, layoutMs = -1.0f, paintMs = -1.0f;
+    uint32_t drawCalls = 0;
+    uint32_t instances = 0;
+    uint64_t gpuMemoryBytes = 0;
+};
+
+// Performance overlay: a graph of recent frame times and averaged counters as text in the
+// bundled 5x7 font, all as solid rectangles so it draws in one instanced call. The graph is
+// rebuilt every frame; the text only every TEXT_INTERVAL frames, averaged over them, so it
+// stays readable and cheap.
+class PerfHud {
+public:
+    static const size_t HISTORY = 120;     // Frames in the graph
+    static const size_t TEXT_INTERVAL = 15;
+
+    PerfHud();
+
+    void addFrame(const HudFrame& frame);
+    // Rectangles of the whole overlay for the frames added so far.
+    const std::vector<HudRect>& build();
+    // Screen area the overlay covers, for damage tracking.
+    Rect bounds() const;
+
+private:
+    void buildText();
+    void appendText(float x, float y, const char* text, uint32_t color);
+
+    std::vector<float> m_history; // Ring of frame times
+    size_t m_next = 0, m_count = 0;
+
+    HudFrame m_sum;   // Accumulated since the text was last built
+    size_t m_summed = 0, m_gpuSamples = 0;
+    float m_maxMs = 0.0f;
+    HudFrame m_last;
+
+    std::vector<HudRect> m_text;
+    std::vector<HudRect> m_rects;
+};
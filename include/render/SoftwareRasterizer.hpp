@@ -0,0 +1,65 @@
+#pragma once
+
+#include "layout/DisplayList.hpp"
+#include "text/TextPainter.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// RGBA8 image in CPU memory; each pixel is one uint32_t with red in the lowest byte.
+struct Framebuffer {
+    uint32_t width = 0, height = 0;
+    std::vector<uint32_t> pixels;
+
+    void resize(uint32_t w, uint32_t h) {
+        width = w;
+        height = h;
+        pixels.assign(static_cast<size_t>(w) * h, 0);
+    }
+    uint32_t* row(uint32_t y) { return pixels.data() + static_cast<size_t>(y) * width; }
+};
+
+// Writes the framebuffer as a binary PPM (alpha dropped); returns false on I/O failure.
+bool writePpm(const Framebuffer& framebuffer, const std::string& path);
+
+enum class SimdLevel { SCALAR, SSE2, AVX2 };
+
+// Best span kernels the CPU supports.
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+struct RasterStats {
+    size_t rects = 0, glyphs = 0;
+    size_t pixelsFilled = 0;  // Opaque span pixels
+    size_t pixelsBlended = 0; // Translucent span and glyph pixels
+};
+
+// Draws display lists into a Framebuffer on the CPU. Solid rectangles become horizontal
+// spans written with SIMD stores (blended when the color is translucent); glyphs sample
+// atlas coverage. Pixels are covered when their center lies inside the rectangle, the
+// same rule the GPU rasterizer uses.
+class SoftwareRasterizer {
+public:
+    explicit SoftwareRasterizer(SimdLevel level = detectSimdLevel());
+
+    SimdLevel simdLevel() const { return m_level; }
+
+    void clear(Framebuffer& target, const Color& color) const;
+    // `rect` is in framebuffer pixels.
+    void fillRect(Framebuffer& target, const Rect& rect, const Color& color, RasterStats& stats) const;
+    void drawGlyph(Framebuffer& target, const GlyphQuad& quad, const GlyphAtlas& atlas, float originX, float originY,
+                   RasterStats& stats) const;
+
+    // Paints rects, then glyphs; document coordinates are shifted by -origin.
+    RasterStats draw(Framebuffer& target, const DisplayList& list, const std::vector<GlyphQuad>& glyphs,
+                     const GlyphAtlas& atlas, float originX, float originY) const;
+
+private:
+    using FillSpan = void (*)(uint32_t* dst, size_t count, uint32_t color);
+    using BlendSpan = void (*)(uint32_t* dst, size_t count, uint32_t color);
+
+    SimdLevel m_level;
+    FillSpan m_fill;
+    BlendSpan m_blend;
+};
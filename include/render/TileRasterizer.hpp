@@ -0,0 +1,65 @@
+#pragma once
+
+#include "render/SoftwareRasterizer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+struct TileStats {
+    size_t visible = 0;  // Tiles overlapping the viewport this frame
+    size_t rendered = 0; // Rasterized because their content changed or was not cached
+    size_t reused = 0;   // Copied from the cache
+    size_t cached = 0;   // Tiles held after the frame
+
+    double hitRate() const { return visible ? static_cast<double>(reused) / visible : 1.0; }
+};
+
+// Splits the document into a fixed grid of TILE_SIZE tiles, bins display commands into the
+// tiles they touch and rasterizes tiles independently on a thread pool. Tiles are anchored
+// to document coordinates and keyed by a hash of their binned commands, so a tile whose
+// commands did not change is copied from the cache — both between frames and while the
+// viewport scrolls over it.
+class TileRasterizer {
+public:
+    static constexpr int TILE_SIZE = 256;
+    static constexpr uint64_t MAX_IDLE_FRAMES = 120; // Tiles unused this long are dropped
+
+    // pool may be null: tiles are then drawn on the calling thread.
+    TileRasterizer(const SoftwareRasterizer& rasterizer, ThreadPool* pool) : m_rasterizer(rasterizer), m_pool(pool) {}
+
+    // The viewport grown to whole tiles; the display list passed to draw() must cover it,
+    // or tiles on the edge are cached with content missing.
+    static Rect tileBounds(const Rect& viewport);
+
+    // Draws the viewport (document coordinates) into target, which must match its size.
+    const TileStats& draw(Framebuffer& target, const Rect& viewport, const DisplayList& list,
+                          const std::vector<GlyphQuad>& glyphs, const GlyphAtlas& atlas, const Color& clearColor);
+
+    void clear() { m_tiles.clear(); }
+    const TileStats& stats() const { return m_stats; }
+
+private:
+    struct Tile {
+        int column = 0, row = 0;
+        uint64_t hash = 0;
+        uint64_t lastFrame = 0;
+        bool valid = false;
+        Framebuffer pixels;
+        // Команды кадра, попавшие в тайл, в порядке отрисовки
+        std::vector<uint32_t> rects, glyphs;
+    };
+
+    static uint64_t key(int column, int row) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(row)) << 32) | static_cast<uint32_t>(column);
+    }
+
+    const SoftwareRasterizer& m_rasterizer;
+    ThreadPool* m_pool;
+    std::unordered_map<uint64_t, Tile> m_tiles;
+    std::vector<Tile*> m_visible;
+    uint64_t m_frame = 0;
+    TileStats m_stats;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// Bundled 5x7 bitmap font covering printable ASCII (0x20..0x7E), so text rendering needs
+// no system fonts. Each glyph is 5 columns of 8 bits; bit 0 is the top row, rows 0..6 sit
+// above the baseline and row 7 holds descenders.
+namespace builtin_font {
+
+constexpr int FIRST_CHAR = 0x20;
+constexpr int LAST_CHAR = 0x7E;
+constexpr int GLYPH_COLUMNS = 5;
+constexpr int GLYPH_ROWS = 8;
+constexpr int ADVANCE = 6;    // Columns including one column of spacing
+constexpr int ASCENT = 7;     // Rows above the baseline
+constexpr int LINE_HEIGHT = 10;
+
+extern const uint8_t GLYPHS[LAST_CHAR - FIRST_CHAR + 1][GLYPH_COLUMNS];
+
+} // namespace builtin_font
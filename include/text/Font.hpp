@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+using FontId = uint16_t;
+constexpr FontId BUILTIN_FONT = 0;
+
+// Coverage bitmap of one glyph rasterized at an integer pixel size.
+struct GlyphBitmap {
+    int width = 0, height = 0;
+    std::vector<uint8_t> coverage; // width * height, row-major, 0..255
+};
+
+// Metrics and rasterization of the bundled monospace bitmap font. `fontSize` is the CSS
+// font-size in pixels; one em spans the 8 rows of a glyph cell.
+class Font {
+public:
+    static float advance(float fontSize);
+    static float ascent(float fontSize);
+    static float lineHeight(float fontSize);
+    // Offset from the top of a line box to the top of the glyph cell
+    static float cellTop(float fontSize);
+    static float cellHeight(float fontSize);
+
+    // Characters outside the bundled range are drawn as '?'
+    static char32_t resolve(char32_t codepoint);
+    static bool isBlank(char32_t codepoint);
+
+    // Supersampled box-filter downscale/upscale of the 5x8 cell to `pixelSize` rows.
+    static GlyphBitmap rasterize(char32_t codepoint, int pixelSize);
+};
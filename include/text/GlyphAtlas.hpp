@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Font.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Location of a rasterized glyph inside the atlas, in texels.
+struct AtlasGlyph {
+    uint16_t x = 0, y = 0, width = 0, height = 0;
+    int pixelSize = 0;
+};
+
+// Single-channel CPU atlas of rasterized glyphs, split into uniform slots and managed as
+// an LRU cache. The GPU copy is refreshed from the dirty row range after each frame.
+class GlyphAtlas {
+public:
+    static constexpr int SIZE = 512;
+    static constexpr int SLOT = 32;
+    static constexpr int MAX_PIXEL_SIZE = SLOT - 1; // One empty texel row/column keeps linear filtering clean
+
+    struct Stats {
+        size_t hits = 0, misses = 0, evictions = 0, overflows = 0;
+        double hitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 1.0; }
+    };
+
+    GlyphAtlas();
+
+    // Glyphs looked up after beginFrame() are pinned until the next frame, so quads already
+    // emitted never point at a reused slot.
+    void beginFrame() { m_frame++; }
+    // Returns nullptr if every slot is in use by the current frame.
+    const AtlasGlyph* lookup(FontId font, char32_t codepoint, int pixelSize);
+
+    const std::vector<uint8_t>& pixels() const { return m_pixels; }
+    // Rows [first, first + count) changed since the last clearDirty()
+    bool dirtyRows(uint32_t& first, uint32_t& count) const;
+    void clearDirty();
+
+    // Changes whenever a slot is handed to another glyph: texels sampled by older quads may
+    // then hold a different glyph. Never reset, unlike the stats.
+    uint64_t generation() const { return m_generation; }
+
+    const Stats& stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats{}; }
+    size_t glyphCount() const { return m_lru.size(); }
+
+private:
+    struct Entry {
+        uint64_t key;
+        AtlasGlyph glyph;
+        uint64_t lastFrame;
+    };
+
+    void upload(const GlyphBitmap& bitmap, AtlasGlyph& glyph);
+
+    std::vector<uint8_t> m_pixels;
+    std::list<Entry> m_lru; // Front is the most recently used
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> m_entries;
+    std::vector<uint32_t> m_freeSlots;
+    uint64_t m_frame = 0;
+    uint64_t m_generation = 0;
+    int m_dirtyTop = SIZE, m_dirtyBottom = 0;
+    Stats m_stats;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A break-free run of characters; begin/end are byte offsets into the source text.
+struct TextWord {
+    uint32_t begin, end;
+    float width;
+};
+
+// Measurements of one text node at one font size. Breaking into lines only needs these
+// numbers, so a width change re-breaks text without touching the string again.
+struct TextMetrics {
+    std::vector<TextWord> words;
+    float fontSize = -1.0f; // Size the words were measured at; negative = not measured
+    float spaceWidth = 0.0f;
+    bool leadingSpace = false, trailingSpace = false;
+
+    bool isMeasured(float size) const { return fontSize == size; }
+    void invalidate() { fontSize = -1.0f; } // The text changed: measure again on next layout
+    void measure(const std::string& text, float size);
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "GlyphAtlas.hpp"
+#include "TextShaper.hpp"
+#include "layout/DisplayList.hpp"
+#include <vector>
+
+// A textured quad sampling one glyph from the atlas; uv is normalized.
+struct GlyphQuad {
+    Rect rect;
+    float u0, v0, u1, v1;
+    Color color;
+    DisplayKey key;     // Text command the glyph belongs to
+    uint32_t glyph = 0; // Position of the glyph in the shaped run
+};
+
+// Turns text commands into glyph quads: runs come from the shaped-run cache and glyph
+// bitmaps from the atlas, so steady-state frames do no shaping or rasterization.
+class TextPainter {
+public:
+    // Appends quads for all commands; call once per frame.
+    void paint(const std::vector<TextCommand>& commands, std::vector<GlyphQuad>& quads);
+
+    GlyphAtlas& atlas() { return m_atlas; }
+    const TextShaper& shaper() const { return m_shaper; }
+    void resetStats();
+
+private:
+    TextShaper m_shaper;
+    GlyphAtlas m_atlas;
+};
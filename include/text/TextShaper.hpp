@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Font.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ShapedGlyph {
+    char32_t codepoint;
+    float x; // Pen position relative to the start of the run
+};
+
+// A run of text with whitespace collapsed and glyphs positioned on one line.
+// Blank characters advance the pen but produce no glyphs.
+struct ShapedRun {
+    std::vector<ShapedGlyph> glyphs;
+    float width = 0.0f;
+};
+
+// Shapes text runs and caches the result by (string, font, size), so unchanged text is
+// never re-decoded or re-positioned between frames.
+class TextShaper {
+public:
+    struct Stats {
+        size_t hits = 0, misses = 0;
+        double hitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 1.0; }
+    };
+
+    explicit TextShaper(size_t capacity = 4096) : m_capacity(capacity) {}
+
+    // The returned run stays valid until the next call to shape().
+    const ShapedRun& shape(const std::string& text, FontId font, float fontSize);
+
+    // Calls fn(codepoint) for every character after decoding UTF-8 and collapsing whitespace.
+    template <typename Fn>
+    static void forEachCollapsed(const std::string& text, Fn&& fn);
+
+    const Stats& stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats{}; }
+    size_t size() const { return m_lru.size(); }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        std::string text;
+        FontId font;
+        float fontSize;
+        ShapedRun run;
+    };
+
+    size_t m_capacity;
+    std::list<Entry> m_lru; // Front is the most recently used
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> m_entries;
+    Stats m_stats;
+};
+
+char32_t decodeUtf8(const std::string& text, size_t& pos);
+
+template <typename Fn>
+void TextShaper::forEachCollapsed(const std::string& text, Fn&& fn) {
+    bool pendingSpace = false;
+    bool started = false;
+    for (size_t pos = 0; pos < text.size();) {
+        char32_t codepoint = decodeUtf8(text, pos);
+        if (Font::isBlank(codepoint)) {
+            pendingSpace = started;
+            continue;
+        }
+        // Пробелы схлопываются в один, в начале и в конце строки отбрасываются
+        if (pendingSpace) fn(U' ');
+        fn(codepoint);
+        pendingSpace = false;
+        started = true;
+    }
+}
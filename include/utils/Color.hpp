@@ -2,18 +2,59 @@
 
 #include <string>
 #include <cstdint>
+#include <cstdlib>
 
 struct Color {
     uint8_t r = 0, g = 0, b = 0, a = 255;
+
+    bool operator==(const Color& o) const { return r == o.r && g == o.g && b == o.b && a == o.a; }
+    bool operator!=(const Color& o) const { return !(*this == o); }
+    bool isOpaque() const { return a == 255; }
 };
 
-// Parses a hex color string like "#RRGGBB"
+// Parses "#RGB", "#RGBA", "#RRGGBB" or "#RRGGBBAA"; anything else gives opaque black.
 inline Color parseHexColor(const std::string& hex) {
     Color color;
-    if (hex.length() == 7 && hex[0] == '#') {
-        color.r = std::stoi(hex.substr(1, 2), nullptr, 16);
-        color.g = std::stoi(hex.substr(3, 2), nullptr, 16);
-        color.b = std::stoi(hex.substr(5, 2), nullptr, 16);
+    size_t digits = hex.size() - 1;
+    if (hex.empty() || hex[0] != '#' || (digits != 3 && digits != 4 && digits != 6 && digits != 8)) return color;
+    if (hex.find_first_not_of("0123456789abcdefABCDEF", 1) != std::string::npos) return color;
+    // Короткая запись: каждая цифра повторяется, #f80 == #ff8800
+    size_t width = digits <= 4 ? 1 : 2;
+    auto channel = [&](size_t index) {
+        int value = std::stoi(hex.substr(1 + index * width, width), nullptr, 16);
+        return static_cast<uint8_t>(width == 1 ? value * 17 : value);
+    };
+    color.r = channel(0);
+    color.g = channel(1);
+    color.b = channel(2);
+    if (digits == 4 || digits == 8) color.a = channel(3);
+    return color;
+}
+
+// Parses a CSS color: hex forms, "rgb(r, g, b)", "rgba(r, g, b, alpha)" with alpha in [0, 1],
+// and "transparent". Unknown values give opaque black.
+inline Color parseColor(const std::string& value) {
+    if (!value.empty() && value[0] == '#') return parseHexColor(value);
+    if (value == "transparent") return {0, 0, 0, 0};
+
+    Color color;
+    size_t open = value.find('(');
+    std::string function = value.substr(0, open);
+    if (open == std::string::npos || (function != "rgb" && function != "rgba")) return color;
+    float channels[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    const char* cursor = value.c_str() + open + 1;
+    for (int i = 0; i < 4; ++i) {
+        char* end;
+        float number = std::strtof(cursor, &end);
+        if (end == cursor) break;
+        channels[i] = number;
+        cursor = end;
+        while (*cursor == ' ' || *cursor == ',') ++cursor;
     }
+    auto clamp255 = [](float v) { return static_cast<uint8_t>(v < 0.0f ? 0.0f : v > 255.0f ? 255.0f : v + 0.5f); };
+    color.r = clamp255(channels[0]);
+    color.g = clamp255(channels[1]);
+    color.b = clamp255(channels[2]);
+    color.a = clamp255(channels[3] * 255.0f);
     return color;
 }
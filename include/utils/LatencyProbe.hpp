@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Input-to-present latency: the time from the earliest input event not yet shown to the
+// present of the frame that follows it. Later events before that present are folded into
+// the same sample, so a burst of pointer moves counts once, at its worst.
+class LatencyProbe {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Summary {
+        size_t samples = 0;
+        double meanMs = 0.0, p50Ms = 0.0, p99Ms = 0.0, maxMs = 0.0;
+    };
+
+    void input(Clock::time_point time);
+    // Closes the pending sample, if any.
+    void presented(Clock::time_point time);
+
+    size_t samples() const { return m_samplesMs.size(); }
+    Summary summary() const;
+    void reset() { m_samplesMs.clear(); }
+
+private:
+    bool m_pending = false;
+    Clock::time_point m_firstInput;
+    std::vector<double> m_samplesMs;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+#include <string>
+
+enum class LogLevel { DEBUG, INFO, WARN, ERROR };
+
+// Levels below VKUI_LOG_LEVEL (0 debug .. 3 error) are compiled out.
+#ifndef VKUI_LOG_LEVEL
+#define VKUI_LOG_LEVEL 1
+#endif
+
+#if defined(__GNUC__)
+#define LOG_PRINTF_FORMAT __attribute__((format(printf, 1, 2)))
+#else
+#define LOG_PRINTF_FORMAT
+#endif
+
+// Asynchronous logger. A call formats the message into a ring buffer of the calling thread,
+// without locks or allocation; a background thread drains all rings to stdout in timestamp
+// order. Timestamps are monotonic seconds since the first message. A message repeated more
+// than REPEAT_LIMIT times within a second is suppressed for the rest of that second, and the
+// number of suppressed repeats is logged with the next one that gets through. The *f
+// variants take printf formats and do not build a std::string at the call site.
+class Log {
+public:
+    static void debug(const std::string& message) { log(LogLevel::DEBUG, message); }
+    static void info(const std::string& message) { log(LogLevel::INFO, message); }
+    static void warn(const std::string& message) { log(LogLevel::WARN, message); }
+    static void error(const std::string& message) { log(LogLevel::ERROR, message); }
+
+    static void debugf(const char* format, ...) LOG_PRINTF_FORMAT {
+        if (!enabled(LogLevel::DEBUG)) return;
+        va_list args;
+        va_start(args, format);
+        vformat(LogLevel::DEBUG, format, args);
+        va_end(args);
+    }
+    static void infof(const char* format, ...) LOG_PRINTF_FORMAT {
+        if (!enabled(LogLevel::INFO)) return;
+        va_list args;
+        va_start(args, format);
+        vformat(LogLevel::INFO, format, args);
+        va_end(args);
+    }
+    static void warnf(const char* format, ...) LOG_PRINTF_FORMAT {
+        if (!enabled(LogLevel::WARN)) return;
+        va_list args;
+        va_start(args, format);
+        vformat(LogLevel::WARN, format, args);
+        va_end(args);
+    }
+    static void errorf(const char* format, ...) LOG_PRINTF_FORMAT {
+        if (!enabled(LogLevel::ERROR)) return;
+        va_list args;
+        va_start(args, format);
+        vformat(LogLevel::ERROR, format, args);
+        va_end(args);
+    }
+
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= VKUI_LOG_LEVEL && static_cast<int>(level) >= s_level.load(std::memory_order_relaxed);
+    }
+    // Runtime filter on top of VKUI_LOG_LEVEL.
+    static void setLevel(LogLevel level) { s_level.store(static_cast<int>(level), std::memory_order_relaxed); }
+    // Blocks until everything logged so far on any thread is written out.
+    static void flush();
+
+    static const size_t MAX_MESSAGE = 480; // Longer messages are truncated
+    static const unsigned REPEAT_LIMIT = 10;
+
+private:
+    static void log(LogLevel level, const std::string& message) {
+        if (enabled(level)) write(level, message.data(), message.size());
+    }
+    static void vformat(LogLevel level, const char* format, va_list args);
+    static void write(LogLevel level, const char* text, size_t length);
+
+    static inline std::atomic<int> s_level{static_cast<int>(LogLevel::INFO)};
+};
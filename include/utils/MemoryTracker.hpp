@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Pipeline stage that owns a heap allocation: the trees each stage builds are separate.
+enum class MemoryStage : uint8_t { OTHER, TOKENS, DOM, STYLESHEET, STYLE, LAYOUT, DISPLAY_LIST, LAYERS, COUNT };
+
+enum class GpuMemoryKind : uint8_t { BUFFER, TEXTURE, LAYER_SURFACE, COUNT };
+
+struct MemoryStats {
+    uint64_t allocations = 0, frees = 0;
+    uint64_t allocatedBytes = 0; // Total over the process lifetime
+    uint64_t liveBytes = 0, peakBytes = 0;
+};
+
+struct GpuMemoryStats {
+    uint64_t allocations = 0;
+    uint64_t liveBytes = 0, peakBytes = 0;
+};
+
+// Per-stage heap accounting. Allocations are attributed to the stage of the innermost Scope
+// on the allocating thread and freed against the stage that allocated them, whichever thread
+// frees. The heap is only tracked in builds with the allocator hooks (make MEMORY=1, see
+// src/MemoryHooks.cpp); elsewhere Scope is a thread-local store and enabled() is false.
+// Device memory of GPU buffers, textures and layer surfaces is counted in every build.
+class MemoryTracker {
+public:
+    class Scope {
+    public:
+        explicit Scope(MemoryStage stage) : m_previous(s_stage) { s_stage = stage; }
+        ~Scope() { s_stage = m_previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        MemoryStage m_previous;
+    };
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static MemoryStats stats(MemoryStage stage);
+    static MemoryStats total();
+    static GpuMemoryStats gpuStats(GpuMemoryKind kind);
+    static GpuMemoryStats gpuTotal();
+    static const char* name(MemoryStage stage);
+    static const char* name(GpuMemoryKind kind);
+    // Logs the heap by stage when enabled() and GPU memory by kind when any was allocated.
+    static void logSummary();
+
+    // Allocator hooks
+    static MemoryStage currentStage() { return s_stage; }
+    static void allocated(MemoryStage stage, size_t size);
+    static void freed(MemoryStage stage, size_t size);
+
+    static void gpuAllocated(GpuMemoryKind kind, uint64_t size);
+    static void gpuFreed(GpuMemoryKind kind, uint64_t size);
+
+private:
+    static inline thread_local MemoryStage s_stage = MemoryStage::OTHER;
+    static inline std::atomic<bool> s_enabled{false};
+};
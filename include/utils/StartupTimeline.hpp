@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// Startup phases on every thread, timed from the first call to instance() (the start of
+// main). Logged once as a timeline when the first frame is out; phases recorded after that
+// are dropped, so instrumented code that also runs later costs a single atomic load.
+class StartupTimeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Records the enclosing scope as a phase. Track and name must be string literals.
+    class Phase {
+    public:
+        Phase(const char* track, const char* name) : m_track(track), m_name(name), m_start(Clock::now()) {}
+        ~Phase() { StartupTimeline::instance().record(m_track, m_name, m_start, Clock::now()); }
+
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+
+    private:
+        const char* m_track;
+        const char* m_name;
+        Clock::time_point m_start;
+    };
+
+    static StartupTimeline& instance();
+
+    void record(const char* track, const char* name, Clock::time_point start, Clock::time_point end);
+    // Ends startup: logs all phases in start order and the time to first frame.
+    void finish();
+    // Milliseconds since the timeline started.
+    double elapsedMs() const;
+
+private:
+    struct Entry {
+        const char* track;
+        const char* name;
+        double startMs, durationMs;
+    };
+
+    StartupTimeline() = default;
+    double offsetMs(Clock::time_point time) const;
+
+    const Clock::time_point m_origin = Clock::now();
+    std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+    std::atomic<bool> m_finished{false};
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads fed from a single FIFO queue.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return m_workers.size(); }
+    // 1..size() on the pool's own workers, 0 on any other thread: lets parallelFor tasks
+    // pick per-thread state without locking, as long as one outside thread drives the pool.
+    size_t threadIndex() const;
+    void submit(std::function<void()> task);
+
+    // Runs fn(0) .. fn(count - 1) on the pool and the calling thread; returns when all are done.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping = false;
+};
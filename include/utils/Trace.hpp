@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Scoped zones of the frame pipeline on every thread, written out as Chrome trace-event JSON
+// (chrome://tracing, ui.perfetto.dev). Each thread appends to a ring buffer of its own without
+// locks; once it is full the oldest zones are overwritten. Zones are recorded only between
+// start() and stop(); with VKUI_TRACE undefined (make TRACE=0) the macros expand to nothing.
+class Trace {
+public:
+    // Timestamps of zones in ticks: the TSC on x86, whose rate is constant on current CPUs and
+    // which is cheaper to read than steady_clock; nanoseconds elsewhere. write() converts
+    // ticks to time against steady_clock.
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Zones each thread keeps before overwriting the oldest
+    static const size_t RING_CAPACITY = 1 << 15;
+
+    // Ring of one thread's zones. Only the owning thread writes; head publishes its entries.
+    struct ThreadBuffer {
+        struct Event {
+            const char* name;
+            uint64_t start, duration; // Ticks
+        };
+
+        uint32_t tid = 0;
+        std::string name;
+        std::unique_ptr<Event[]> events{new Event[RING_CAPACITY]};
+        std::atomic<uint64_t> head{0}; // Zones ever recorded
+
+        void record(const char* zone, uint64_t start, uint64_t end) {
+            uint64_t index = head.load(std::memory_order_relaxed);
+            events[index % RING_CAPACITY] = {zone, start, end - start};
+            head.store(index + 1, std::memory_order_release);
+        }
+    };
+
+    // Records the enclosing scope. The name must be a string literal.
+    class Zone {
+    public:
+        explicit Zone(const char* name) : m_name(name), m_buffer(enabled() ? &threadBuffer() : nullptr) {
+            if (m_buffer) m_start = now();
+        }
+        ~Zone() {
+            if (m_buffer) m_buffer->record(m_name, m_start, now());
+        }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* m_name;
+        ThreadBuffer* m_buffer; // Null when not recording
+        uint64_t m_start = 0;
+    };
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void start() { s_enabled.store(true, std::memory_order_relaxed); }
+    static void stop() { s_enabled.store(false, std::memory_order_relaxed); }
+
+    // Names the calling thread in the trace; the name is copied.
+    static void setThreadName(const std::string& name);
+    static ThreadBuffer& threadBuffer() { return t_buffer ? *t_buffer : registerThread(); }
+    // Writes the zones the ring buffers hold now; recording may go on meanwhile.
+    static bool write(const std::string& path);
+    // Where flush() writes: set together with start() by the application.
+    static void setOutputPath(const std::string& path);
+    static bool flush();
+    // Zones recorded so far on all threads, including overwritten ones.
+    static uint64_t recordedZones();
+
+private:
+    static ThreadBuffer& registerThread();
+
+    static inline std::atomic<bool> s_enabled{false};
+    static inline thread_local ThreadBuffer* t_buffer = nullptr;
+};
+
+#ifdef VKUI_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ZONE(name) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_THREAD(name) Trace::setThreadName(name)
+#else
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free handoff of the latest value from one producer thread to one consumer thread.
+// The producer fills back() and publishes it; the consumer picks up the newest published
+// value with consume() and reads it through front(). Neither side ever waits: values the
+// consumer did not get to in time are overwritten, and the slots' storage is reused.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side. The slot holds whatever was published two rounds ago.
+    T& back() { return m_slots[m_back]; }
+    void publish() {
+        // Готовый слот меняется местами со средним; неподобранное значение становится новым задним
+        uint8_t previous = m_middle.exchange(static_cast<uint8_t>(m_back | FRESH), std::memory_order_acq_rel);
+        m_back = previous & INDEX;
+    }
+
+    // Consumer side. Returns true if a newer value replaced front().
+    bool consume() {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX;
+        return true;
+    }
+    const T& front() const { return m_slots[m_front]; }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;
+
+    T m_slots[3];
+    // Индексы заднего и переднего слотов принадлежат каждый своему потоку; общий только средний
+    alignas(64) std::atomic<uint8_t> m_middle{1};
+    alignas(64) uint8_t m_back = 0;
+    alignas(64) uint8_t m_front = 2;
+};
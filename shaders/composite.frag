@@ -0,0 +1,20 @@
+#version 450
+
+layout(location = 0) in vec2 fragUV;
+
+// Layer image with premultiplied alpha
+layout(set = 0, binding = 0) uniform sampler2D layerImage;
+
+layout(push_constant) uniform Quad {
+    vec4 rect;
+    vec4 uv;
+    vec2 viewport;
+    float opacity;
+} quad;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Premultiplied color scales as a whole: opacity fades the layer, not just its alpha
+    outColor = texture(layerImage, fragUV) * quad.opacity;
+}
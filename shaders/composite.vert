@@ -0,0 +1,23 @@
+#version 450
+
+// One textured quad per compositor layer; the layer image holds its raster at (0, 0)
+layout(push_constant) uniform Quad {
+    vec4 rect;     // x, y, width, height in framebuffer pixels
+    vec4 uv;       // u0, v0, u1, v1 inside the layer image
+    vec2 viewport; // Framebuffer size in pixels
+    float opacity;
+} quad;
+
+layout(location = 0) out vec2 fragUV;
+
+const vec2 CORNERS[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0)
+);
+
+void main() {
+    vec2 corner = CORNERS[gl_VertexIndex];
+    vec2 pixel = quad.rect.xy + corner * quad.rect.zw;
+    gl_Position = vec4(pixel / quad.viewport * 2.0 - 1.0, 0.0, 1.0);
+    fragUV = mix(quad.uv.xy, quad.uv.zw, corner);
+}
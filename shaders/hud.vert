@@ -0,0 +1,22 @@
+#version 450
+
+// One solid rectangle of the performance overlay per instance
+layout(location = 0) in vec4 inRect;  // x, y, width, height in framebuffer pixels
+layout(location = 1) in vec4 inColor; // RGBA8, normalized by the vertex fetch
+
+layout(push_constant) uniform Viewport {
+    vec2 size; // Framebuffer size in pixels
+} viewport;
+
+layout(location = 0) out vec4 fragColor;
+
+const vec2 CORNERS[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0)
+);
+
+void main() {
+    vec2 pixel = inRect.xy + CORNERS[gl_VertexIndex] * inRect.zw;
+    gl_Position = vec4(pixel / viewport.size * 2.0 - 1.0, 0.0, 1.0);
+    fragColor = inColor;
+}
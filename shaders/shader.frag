@@ -1,13 +1,17 @@
 #version 450
 
-// Input variable from the vertex shader (must match 'out' variable)
-layout(location = 0) in vec3 fragColor;
+// Input variables from the vertex shader (must match 'out' variables)
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragUV;
+
+// Single-channel glyph atlas: coverage in the red channel
+layout(set = 0, binding = 0) uniform sampler2D glyphAtlas;
 
 // Output variable for the final color
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    // The hardware automatically interpolates fragColor between vertices.
-    // We just output it as the final color. Alpha is 1.0 (opaque).
-    outColor = vec4(fragColor, 1.0);
+    // Rectangles carry a negative u and cover the whole quad; glyphs scale alpha by atlas coverage.
+    float coverage = fragUV.x < 0.0 ? 1.0 : texture(glyphAtlas, fragUV).r;
+    outColor = vec4(fragColor.rgb, fragColor.a * coverage);
 }
@@ -1,13 +1,41 @@
 #version 450
 
-// Input from the vertex buffer
-layout(location = 0) in vec2 inPosition;
-layout(location = 1) in vec3 inColor;
+// One quad per instance; must match GpuInstance (std430)
+struct Instance {
+    vec4 rect;  // x, y, width, height in document pixels
+    vec4 uv;    // u0, v0, u1, v1; negative u means a solid fill
+    vec4 color;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(push_constant) uniform Viewport {
+    vec2 size;   // Framebuffer size in pixels
+    vec2 scroll; // Document offset of the top-left corner
+} viewport;
+
+// Per-instance input: slot of the quad in the instance buffer and its position in paint order
+layout(location = 0) in uvec2 inDraw;
 
 // Output to the fragment shader
-layout(location = 0) out vec3 fragColor;
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragUV;
+
+const vec2 CORNERS[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0)
+);
 
 void main() {
-    gl_Position = vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
+    Instance instance = instances[inDraw.x];
+    vec2 corner = CORNERS[gl_VertexIndex];
+    vec2 pixel = instance.rect.xy + corner * instance.rect.zw - viewport.scroll;
+    // Later paint is nearer: opaque quads drawn front to back hide what lies under them
+    // from the depth test, before the fragment shader runs. 2^24 steps fit D24 and D32.
+    float depth = 1.0 - float(min(inDraw.y + 1u, 16777215u)) / 16777216.0;
+    gl_Position = vec4(pixel / viewport.size * 2.0 - 1.0, depth, 1.0);
+    fragColor = instance.color;
+    fragUV = mix(instance.uv.xy, instance.uv.zw, corner);
 }
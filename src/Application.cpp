@@ -1,32 +1,41 @@
 #include "Application.hpp"
-#include "Logger.hpp"
-#include "VulkanEngine.hpp"
+#include "utils/Logger.hpp"
+#include "RenderEngine.hpp"
+#include "document/Document.hpp"
+#include "utils/StartupTimeline.hpp"
+#include "utils/Trace.hpp"
+#include <chrono>
+#include <limits>
 #include <stdexcept>
 #include <utility>
 
-Application::Application(int width, int height, std::string title, std::string html, std::string css)
+Application::Application(int width, int height, std::string title, std::string html, std::string css,
+                         std::unique_ptr<RenderEngine> engine)
     : m_width(width), 
       m_height(height), 
       m_title(std::move(title)), 
       m_htmlContent(std::move(html)),
       m_cssContent(std::move(css)),
-      m_window(nullptr) {
+      m_window(nullptr),
+      m_engine(std::move(engine)) {
     Log::info("Application created.");
-    m_vulkanEngine = std::make_unique<VulkanEngine>();
 }
 
 Application::~Application() {
+    m_engine.reset(); // Ресурсы движка привязаны к окну — освобождаем до него
     teardown();
     Log::info("Application destroyed.");
 }
 
 void Application::run() {
     setupWindow();
-    m_vulkanEngine->init(m_window, m_htmlContent, m_cssContent); // <-- Передаем контент
+    m_engine->init(m_window, m_htmlContent, m_cssContent);
+    setupInput();
     mainLoop();
 }
 
 void Application::setupWindow() {
+    StartupTimeline::Phase phase("main", "window");
     glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_X11);
     if (!glfwInit()) throw std::runtime_error("GLFW init failed");
     
@@ -36,14 +45,89 @@ void Application::setupWindow() {
     if (!m_window) throw std::runtime_error("GLFW window creation failed");
 }
 
+void Application::setupInput() {
+    glfwSetWindowUserPointer(m_window, this);
+    glfwSetScrollCallback(m_window, scrollCallback);
+    glfwSetKeyCallback(m_window, keyCallback);
+    glfwSetCursorPosCallback(m_window, cursorPosCallback);
+    glfwSetCursorEnterCallback(m_window, cursorEnterCallback);
+    glfwSetMouseButtonCallback(m_window, mouseButtonCallback);
+
+    // Клики всплывают до корня документа — один слушатель видит их все
+    m_engine->postTask([](Document& document) {
+        document.addEventListener(document.root(), EventType::CLICK, [](Event& event) {
+            auto id = event.target->attributes.find("id");
+            Log::info("Click on <" + event.target->value + (id != event.target->attributes.end() ? " id=\"" + id->second + "\"" : "") +
+                      "> at " + std::to_string(static_cast<int>(event.x)) + ", " + std::to_string(static_cast<int>(event.y)) + ".");
+        });
+    });
+}
+
+void Application::scrollCallback(GLFWwindow* window, double /*xoffset*/, double yoffset) {
+    auto* app = static_cast<Application*>(glfwGetWindowUserPointer(window));
+    app->m_engine->inputReceived(std::chrono::steady_clock::now());
+    const float pixelsPerNotch = 40.0f;
+    app->m_engine->scrollBy(static_cast<float>(-yoffset) * pixelsPerNotch);
+}
+
+void Application::cursorPosCallback(GLFWwindow* window, double x, double y) {
+    auto* app = static_cast<Application*>(glfwGetWindowUserPointer(window));
+    app->m_engine->inputReceived(std::chrono::steady_clock::now());
+    app->m_engine->pointerMoved(static_cast<float>(x), static_cast<float>(y));
+}
+
+void Application::cursorEnterCallback(GLFWwindow* window, int entered) {
+    auto* app = static_cast<Application*>(glfwGetWindowUserPointer(window));
+    if (!entered) app->m_engine->pointerLeft();
+}
+
+void Application::mouseButtonCallback(GLFWwindow* window, int button, int action, int /*mods*/) {
+    if (action != GLFW_PRESS && action != GLFW_RELEASE) return;
+    auto* app = static_cast<Application*>(glfwGetWindowUserPointer(window));
+    app->m_engine->inputReceived(std::chrono::steady_clock::now());
+    app->m_engine->pointerButton(button, action == GLFW_PRESS);
+}
+
+void Application::keyCallback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/) {
+    if (action != GLFW_PRESS && action != GLFW_REPEAT) return;
+    auto* app = static_cast<Application*>(glfwGetWindowUserPointer(window));
+    RenderEngine& engine = *app->m_engine;
+    engine.inputReceived(std::chrono::steady_clock::now());
+    const float line = 40.0f;
+    const float page = static_cast<float>(app->m_height) - line;
+    switch (key) {
+        case GLFW_KEY_DOWN:      engine.scrollBy(line); break;
+        case GLFW_KEY_UP:        engine.scrollBy(-line); break;
+        case GLFW_KEY_PAGE_DOWN:
+        case GLFW_KEY_SPACE:     engine.scrollBy(page); break;
+        case GLFW_KEY_PAGE_UP:   engine.scrollBy(-page); break;
+        case GLFW_KEY_HOME:      engine.scrollTo(0.0f); break;
+        case GLFW_KEY_END:       engine.scrollTo(std::numeric_limits<float>::max()); break;
+        case GLFW_KEY_F3:
+            if (action == GLFW_PRESS) engine.toggleHud();
+            break;
+        case GLFW_KEY_F12:
+            if (Trace::enabled() && Trace::flush()) Log::info("Trace written.");
+            break;
+        default: break;
+    }
+}
+
 void Application::mainLoop() {
     Log::info("Starting main loop...");
+    bool firstFrame = true;
     while (!glfwWindowShouldClose(m_window)) {
+        // Ввод опрашивается как можно ближе к кадру, который его покажет
+        m_engine->paceFrame();
         glfwPollEvents();
-        m_vulkanEngine->drawFrame();
+        m_engine->drawFrame();
+        if (firstFrame) {
+            firstFrame = false;
+            StartupTimeline::instance().finish();
+        }
     }
     Log::info("Main loop finished.");
-    vkDeviceWaitIdle(m_vulkanEngine->getDevice());
+    m_engine->waitIdle();
 }
 
 void Application::teardown() {
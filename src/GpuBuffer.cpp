@@ -0,0 +1,80 @@
+#include "GpuBuffer.hpp"
+#include "utils/Logger.hpp"
+#include "utils/MemoryTracker.hpp"
+
+#include <stdexcept>
+#include <cstring>
+
+GpuBuffer::GpuBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkBufferUsageFlags usage, VkDeviceSize capacity)
+    : m_physicalDevice(physicalDevice), m_device(device), m_usage(usage) {
+    allocate(capacity);
+}
+
+GpuBuffer::~GpuBuffer() {
+    release();
+}
+
+bool GpuBuffer::reserve(VkDeviceSize size) {
+    if (size <= m_capacity) return false;
+    VkDeviceSize capacity = m_capacity > 0 ? m_capacity : 256;
+    while (capacity < size) capacity *= 2;
+    release();
+    allocate(capacity);
+    Log::infof("GPU buffer grown to %zu bytes.", static_cast<size_t>(capacity));
+    return true;
+}
+
+void GpuBuffer::write(VkDeviceSize offset, const void* data, size_t size) {
+    if (offset + size > m_capacity) throw std::runtime_error("GPU buffer write out of range!");
+    memcpy(static_cast<char*>(m_mapped) + offset, data, size);
+}
+
+void GpuBuffer::allocate(VkDeviceSize capacity) {
+    VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferInfo.size = capacity;
+    bufferInfo.usage = m_usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(m_device, &bufferInfo, nullptr, &m_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create GPU buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(m_device, m_buffer, &memRequirements);
+    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
+                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (vkAllocateMemory(m_device, &allocInfo, nullptr, &m_memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate GPU buffer memory!");
+    }
+    m_memorySize = memRequirements.size;
+    MemoryTracker::gpuAllocated(GpuMemoryKind::BUFFER, m_memorySize);
+    vkBindBufferMemory(m_device, m_buffer, m_memory, 0);
+    // Отображение держим открытым: частичные обновления — просто memcpy
+    vkMapMemory(m_device, m_memory, 0, capacity, 0, &m_mapped);
+    m_capacity = capacity;
+}
+
+void GpuBuffer::release() {
+    if (m_mapped) vkUnmapMemory(m_device, m_memory);
+    if (m_buffer) vkDestroyBuffer(m_device, m_buffer, nullptr);
+    if (m_memory) {
+        vkFreeMemory(m_device, m_memory, nullptr);
+        MemoryTracker::gpuFreed(GpuMemoryKind::BUFFER, m_memorySize);
+    }
+    m_mapped = nullptr;
+    m_buffer = VK_NULL_HANDLE;
+    m_memory = VK_NULL_HANDLE;
+    m_capacity = 0;
+}
+
+uint32_t GpuBuffer::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProperties);
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    throw std::runtime_error("failed to find suitable memory type!");
+}
@@ -0,0 +1,158 @@
+#include "LayerSurface.hpp"
+#include "utils/Logger.hpp"
+#include "utils/MemoryTracker.hpp"
+
+#include <stdexcept>
+
+LayerSurface::LayerSurface(VkPhysicalDevice physicalDevice, VkDevice device, VkRenderPass renderPass, VkFormat format,
+                           VkFormat depthFormat, uint32_t width, uint32_t height)
+    : m_physicalDevice(physicalDevice), m_device(device), m_format(format), m_depthFormat(depthFormat),
+      m_width(width), m_height(height) {
+    createImage();
+    createImageView();
+    createDepthImage();
+    createSampler();
+    createFramebuffer(renderPass);
+    Log::infof("Layer surface %ux%u created.", width, height);
+}
+
+LayerSurface::~LayerSurface() {
+    vkDestroyFramebuffer(m_device, m_framebuffer, nullptr);
+    vkDestroySampler(m_device, m_sampler, nullptr);
+    vkDestroyImageView(m_device, m_depthView, nullptr);
+    vkDestroyImage(m_device, m_depthImage, nullptr);
+    vkFreeMemory(m_device, m_depthMemory, nullptr);
+    vkDestroyImageView(m_device, m_imageView, nullptr);
+    vkDestroyImage(m_device, m_image, nullptr);
+    vkFreeMemory(m_device, m_imageMemory, nullptr);
+    MemoryTracker::gpuFreed(GpuMemoryKind::LAYER_SURFACE, m_memorySize);
+}
+
+void LayerSurface::createImage() {
+    VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = {m_width, m_height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = m_format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(m_device, &imageInfo, nullptr, &m_image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create layer image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(m_device, m_image, &memRequirements);
+    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (vkAllocateMemory(m_device, &allocInfo, nullptr, &m_imageMemory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate layer image memory!");
+    }
+    m_memorySize += memRequirements.size;
+    MemoryTracker::gpuAllocated(GpuMemoryKind::LAYER_SURFACE, memRequirements.size);
+    vkBindImageMemory(m_device, m_image, m_imageMemory, 0);
+}
+
+void LayerSurface::createImageView() {
+    VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    viewInfo.image = m_image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = m_format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(m_device, &viewInfo, nullptr, &m_imageView) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create layer image view!");
+    }
+}
+
+void LayerSurface::createDepthImage() {
+    VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = {m_width, m_height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = m_depthFormat;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(m_device, &imageInfo, nullptr, &m_depthImage) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create layer depth image!");
+    }
+
+    // На тайловых GPU глубина может вообще не попасть в память; иначе — обычная память устройства
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(m_device, m_depthImage, &memRequirements);
+    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = memRequirements.size;
+    try {
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+    } catch (const std::runtime_error&) {
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+    if (vkAllocateMemory(m_device, &allocInfo, nullptr, &m_depthMemory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate layer depth memory!");
+    }
+    // Ленивая глубина может не занять памяти вовсе; учитывается запрошенный размер
+    m_memorySize += memRequirements.size;
+    MemoryTracker::gpuAllocated(GpuMemoryKind::LAYER_SURFACE, memRequirements.size);
+    vkBindImageMemory(m_device, m_depthImage, m_depthMemory, 0);
+
+    VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    viewInfo.image = m_depthImage;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = m_depthFormat;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(m_device, &viewInfo, nullptr, &m_depthView) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create layer depth view!");
+    }
+}
+
+void LayerSurface::createSampler() {
+    // Слой ложится на экран со сдвигом на целые пиксели, тексел в пиксель — фильтрация не нужна
+    VkSamplerCreateInfo samplerInfo{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    if (vkCreateSampler(m_device, &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create layer sampler!");
+    }
+}
+
+void LayerSurface::createFramebuffer(VkRenderPass renderPass) {
+    VkFramebufferCreateInfo framebufferInfo{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+    framebufferInfo.renderPass = renderPass;
+    VkImageView attachments[] = {m_imageView, m_depthView};
+    framebufferInfo.attachmentCount = 2;
+    framebufferInfo.pAttachments = attachments;
+    framebufferInfo.width = m_width;
+    framebufferInfo.height = m_height;
+    framebufferInfo.layers = 1;
+    if (vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &m_framebuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create layer framebuffer!");
+    }
+}
+
+uint32_t LayerSurface::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProperties);
+
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    throw std::runtime_error("failed to find suitable memory type!");
+}
@@ -0,0 +1,44 @@
+// Global allocator hooks for utils/MemoryTracker, built into the application with make
+// MEMORY=1. Every block carries a header with its size and the stage that allocated it, so a
+// free is charged to the right stage. Over-aligned new/delete are left to the runtime.
+#ifdef VKUI_MEMORY_TRACKING
+
+#include "utils/MemoryTracker.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+struct alignas(alignof(std::max_align_t)) Header {
+    size_t size;
+    MemoryStage stage;
+};
+
+void* trackedAlloc(size_t size) {
+    MemoryStage stage = MemoryTracker::currentStage();
+    auto* header = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+    if (!header) throw std::bad_alloc();
+    header->size = size;
+    header->stage = stage;
+    MemoryTracker::allocated(stage, size);
+    return header + 1;
+}
+
+void trackedFree(void* p) {
+    if (!p) return;
+    Header* header = static_cast<Header*>(p) - 1;
+    MemoryTracker::freed(header->stage, header->size);
+    std::free(header);
+}
+
+} // namespace
+
+void* operator new(size_t size) { return trackedAlloc(size); }
+void* operator new[](size_t size) { return trackedAlloc(size); }
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { trackedFree(p); }
+
+#endif
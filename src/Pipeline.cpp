@@ -1,6 +1,5 @@
 #include "Pipeline.hpp"
-#include "Model.hpp" // We need this for vertex descriptions
-#include "Logger.hpp"
+#include "utils/Logger.hpp"
 
 #include <fstream>
 #include <stdexcept>
@@ -53,8 +52,8 @@ void Pipeline::createGraphicsPipeline(
     shaderStages[0] = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule, "main", nullptr};
     shaderStages[1] = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule, "main", nullptr};
 
-    auto bindingDescriptions = Model::Vertex::getBindingDescriptions();
-    auto attributeDescriptions = Model::Vertex::getAttributeDescriptions();
+    const auto& bindingDescriptions = configInfo.bindingDescriptions;
+    const auto& attributeDescriptions = configInfo.attributeDescriptions;
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
     vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -71,7 +70,7 @@ void Pipeline::createGraphicsPipeline(
     pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
     pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
     pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
-    pipelineInfo.pDepthStencilState = nullptr;
+    pipelineInfo.pDepthStencilState = configInfo.depthStencilInfo.sType ? &configInfo.depthStencilInfo : nullptr;
     pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
     pipelineInfo.layout = configInfo.pipelineLayout;
     pipelineInfo.renderPass = configInfo.renderPass;
@@ -87,3 +86,27 @@ void Pipeline::createGraphicsPipeline(
     vkDestroyShaderModule(m_device, vertShaderModule, nullptr);
     Log::info("Graphics pipeline created (with vertex input).");
 }
+
+ComputePipeline::ComputePipeline(VkDevice device, const std::string& compFilepath, VkPipelineLayout pipelineLayout) : m_device(device) {
+    auto compCode = Pipeline::readFile(compFilepath);
+    VkShaderModule compShaderModule;
+    VkShaderModuleCreateInfo createInfo{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, nullptr, 0, compCode.size(), reinterpret_cast<const uint32_t*>(compCode.data())};
+    if (vkCreateShaderModule(m_device, &createInfo, nullptr, &compShaderModule) != VK_SUCCESS) throw std::runtime_error("failed to create compute shader module");
+
+    VkComputePipelineCreateInfo pipelineInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    pipelineInfo.stage = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_COMPUTE_BIT, compShaderModule, "main", nullptr};
+    pipelineInfo.layout = pipelineLayout;
+    VkResult result = vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_computePipeline);
+    vkDestroyShaderModule(m_device, compShaderModule, nullptr);
+    if (result != VK_SUCCESS) throw std::runtime_error("failed to create compute pipeline");
+    Log::info("Compute pipeline created.");
+}
+
+ComputePipeline::~ComputePipeline() {
+    vkDestroyPipeline(m_device, m_computePipeline, nullptr);
+    Log::info("Compute pipeline destroyed.");
+}
+
+void ComputePipeline::bind(VkCommandBuffer commandBuffer) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipeline);
+}
@@ -0,0 +1,160 @@
+#include "SoftwareEngine.hpp"
+#include "utils/Logger.hpp"
+#include "X11Blitter.hpp"
+
+#include "document/Document.hpp"
+#include "document/PointerDispatcher.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/DisplayList.hpp"
+#include "layout/DisplayListOptimizer.hpp"
+#include "layout/SpatialIndex.hpp"
+#include "utils/ThreadPool.hpp"
+#include "utils/Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+static const Color CLEAR_COLOR = {26, 26, 26, 255};
+static const std::chrono::microseconds FRAME_INTERVAL(16667);
+
+SoftwareEngine::SoftwareEngine(SimdLevel simdLevel) : m_rasterizer(simdLevel) {
+    Log::info(std::string("SoftwareEngine created (") + simdLevelName(m_rasterizer.simdLevel()) + " spans).");
+}
+
+SoftwareEngine::~SoftwareEngine() {
+    m_pointer.reset();
+    m_tiles.reset();
+    m_spatialIndex.reset();
+    m_layoutEngine.reset();
+    m_threadPool.reset();
+    m_document.reset();
+    m_blitter.reset();
+    Log::info("SoftwareEngine destroyed.");
+}
+
+void SoftwareEngine::init(GLFWwindow* window, const std::string& htmlContent, const std::string& cssContent) {
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    m_blitter = std::make_unique<X11Blitter>(window);
+    build(static_cast<uint32_t>(width), static_cast<uint32_t>(height), htmlContent, cssContent);
+    m_nextFrame = std::chrono::steady_clock::now();
+    Log::info("Software engine initialization complete.");
+}
+
+void SoftwareEngine::initOffscreen(uint32_t width, uint32_t height, const std::string& htmlContent, const std::string& cssContent) {
+    build(width, height, htmlContent, cssContent);
+    Log::info("Software engine initialized offscreen (" + std::to_string(width) + "x" + std::to_string(height) + ").");
+}
+
+void SoftwareEngine::build(uint32_t width, uint32_t height, const std::string& htmlContent, const std::string& cssContent) {
+    m_framebuffer.resize(width, height);
+    m_document = std::make_unique<Document>(htmlContent, cssContent);
+    m_threadPool = std::make_unique<ThreadPool>();
+    m_layoutEngine = std::make_unique<LayoutEngine>();
+    m_layoutEngine->setThreadPool(m_threadPool.get());
+    m_layoutEngine->setViewport(static_cast<float>(width), static_cast<float>(height));
+    m_layoutEngine->setLazyLayout(true);
+    m_layoutEngine->build(m_document->styleRoot());
+    m_textPainter = std::make_unique<TextPainter>();
+    m_spatialIndex = std::make_unique<SpatialIndex>();
+    m_pointer = std::make_unique<PointerDispatcher>(*m_document, *m_spatialIndex);
+    m_tiles = std::make_unique<TileRasterizer>(m_rasterizer, m_threadPool.get());
+}
+
+void SoftwareEngine::postTask(DocumentTask task) {
+    task(*m_document);
+}
+
+void SoftwareEngine::pointerMoved(float x, float y) {
+    m_pointer->moved(x, y);
+}
+
+void SoftwareEngine::pointerButton(int button, bool pressed) {
+    m_pointer->button(button, pressed);
+}
+
+void SoftwareEngine::pointerLeft() {
+    m_pointer->left();
+}
+
+void SoftwareEngine::scrollBy(float dy) {
+    scrollTo(m_scrollY + dy);
+}
+
+void SoftwareEngine::scrollTo(float y) {
+    float maxScroll = std::max(0.0f, m_layoutEngine->documentHeight() - static_cast<float>(m_framebuffer.height));
+    // Тайлы лежат в пиксельной сетке документа — прокручиваем на целые пиксели
+    float clamped = std::round(std::clamp(y, 0.0f, maxScroll));
+    if (clamped == m_scrollY) return;
+    m_scrollY = clamped;
+    m_scrollChanged = true;
+}
+
+void SoftwareEngine::drawFrame() {
+    TRACE_ZONE("frame");
+    update();
+    if (!m_blitter) return;
+    {
+        TRACE_ZONE("present");
+        m_blitter->present(m_framebuffer.pixels, m_framebuffer.width, m_framebuffer.height);
+    }
+    // Присутствие кадра ничем не ограничено — держим частоту обновления экрана
+    auto now = std::chrono::steady_clock::now();
+    m_nextFrame = std::max(m_nextFrame + FRAME_INTERVAL, now);
+    std::this_thread::sleep_until(m_nextFrame);
+}
+
+bool SoftwareEngine::update() {
+    StyleUpdate update = m_document->updateStyles();
+    if (!m_firstFrame && !update.needsPaint() && !m_scrollChanged) return false;
+    m_scrollChanged = false;
+
+    for (StyledNode* node : update.paintDirty) m_layoutEngine->styleChanged(*node);
+    for (StyledNode* node : update.childrenChanged) m_layoutEngine->rebuildChildren(*node);
+    for (StyledNode* node : update.textChanged) m_layoutEngine->textChanged(*node);
+    for (StyledNode* node : update.layoutDirty) m_layoutEngine->styleChanged(*node);
+    m_layoutEngine->setScrollOffset(m_scrollY);
+    const LayoutStats& stats = m_layoutEngine->relayout();
+    if (stats.scrollAnchorShift != 0.0f) {
+        m_scrollY = std::max(0.0f, std::round(m_scrollY + stats.scrollAnchorShift));
+        m_layoutEngine->setScrollOffset(m_scrollY);
+    }
+    bool firstFrame = m_firstFrame;
+    bool logFrame = m_firstFrame || update.needsPaint();
+    m_firstFrame = false;
+
+    auto start = std::chrono::steady_clock::now();
+    render();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (logFrame) {
+        double megapixels = static_cast<double>(m_framebuffer.width) * m_framebuffer.height / 1e6;
+        const TileStats& tiles = m_tiles->stats();
+        // Первый кадр — в общий журнал, перерисовки — только в отладочный
+        auto log = firstFrame ? Log::infof : Log::debugf;
+        log("Software frame: %.3f ms, %d Mpx/s, tiles %zu drawn / %zu reused.", elapsed.count(),
+            static_cast<int>(megapixels / elapsed.count() * 1000.0), tiles.rendered, tiles.reused);
+    }
+    m_pointer->refresh();
+    return true;
+}
+
+void SoftwareEngine::render() {
+    TRACE_ZONE("raster");
+    Rect visibleRect = {0.0f, m_scrollY, static_cast<float>(m_framebuffer.width), static_cast<float>(m_framebuffer.height)};
+    // Тайлы на краю кэшируются целиком, поэтому команды нужны для всей их площади
+    Rect tileRect = TileRasterizer::tileBounds(visibleRect);
+    DisplayList displayList = buildDisplayList(m_layoutEngine->tree(), tileRect);
+    m_spatialIndex->update(displayList, visibleRect);
+    m_pointer->setScrollOffset(m_scrollY);
+    // На CPU каждый перекрытый пиксель стоит записи в память — отбрасываем их до растеризации
+    optimizeDisplayList(displayList, tileRect);
+    std::vector<GlyphQuad> glyphs;
+    m_textPainter->paint(displayList.texts, glyphs);
+
+    m_tiles->draw(m_framebuffer, visibleRect, displayList, glyphs, m_textPainter->atlas(), CLEAR_COLOR);
+}
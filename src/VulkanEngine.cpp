@@ -1,42 +1,84 @@
 #include "VulkanEngine.hpp"
 #include "Pipeline.hpp"
-#include "Model.hpp"
-#include "Logger.hpp"
+#include "GpuBuffer.hpp"
+#include "Texture.hpp"
+#include "LayerSurface.hpp"
+#include "utils/Logger.hpp"
 
-#include "parser/HtmlTokenizer.hpp"
-#include "parser/HtmlParser.hpp"
-#include "parser/CssParser.hpp"
-#include "parser/StyleApplier.hpp"
-#include "layout/LayoutEngine.hpp"
-#include "layout/DisplayList.hpp"
+#include "document/DocumentWorker.hpp"
+#include "text/TextPainter.hpp"
+#include "render/InstanceCache.hpp"
+#include "utils/MemoryTracker.hpp"
+#include "utils/StartupTimeline.hpp"
+#include "utils/ThreadPool.hpp"
+#include "utils/Trace.hpp"
 
 #include <stdexcept>
 #include <set>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 struct SwapchainSupportDetails { VkSurfaceCapabilitiesKHR capabilities; std::vector<VkSurfaceFormatKHR> formats; std::vector<VkPresentModeKHR> presentModes; };
 SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice, VkSurfaceKHR);
 VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>&);
-VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>&);
+VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>&, std::optional<VkPresentModeKHR>);
 VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR&, GLFWwindow*);
 
-VulkanEngine::VulkanEngine() { Log::info("VulkanEngine created."); }
+// Записи списка отрисовки на сегмент: у сегмента своя косвенная команда и свой вторичный буфер,
+// так что большой слой записывается несколькими потоками. Должно совпадать с SEGMENT в cull.comp
+static const uint32_t DRAWS_PER_CHUNK = 65536;
+
+VulkanEngine::VulkanEngine(const PresentConfig& config) : m_hudVisible(config.hud), m_config(config) {
+    if (m_config.framesInFlight < 1 || m_config.framesInFlight > 4) throw std::runtime_error("frames in flight must be 1..4");
+    Log::info("VulkanEngine created.");
+}
 
 VulkanEngine::~VulkanEngine() {
-    m_renderObjects.clear();
-    m_pipeline.reset();
+    if (m_latency.samples() > 0) logLatency("Input-to-present latency", m_latency, "inputs");
+    if (m_applyLatency.samples() > 0) logLatency("Snapshot apply-to-present time", m_applyLatency, "snapshots");
+    m_worker.reset();
+    m_gpuLayers.clear();
+    m_uploads.clear();
+    m_layers.reset();
+    m_textPainter.reset();
+    m_glyphTexture.reset();
+    if (m_descriptorPool) vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+    m_opaquePipeline.reset();
+    m_translucentPipeline.reset();
+    m_compositePipeline.reset();
+    m_cullPipeline.reset();
+    m_hudPipeline.reset();
+    m_hudBuffers.clear();
+    if (m_hudLayout) vkDestroyPipelineLayout(m_device, m_hudLayout, nullptr);
+    if (m_queryPool) vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+    if (m_cullLayout) vkDestroyPipelineLayout(m_device, m_cullLayout, nullptr);
+    if (m_cullSetLayout) vkDestroyDescriptorSetLayout(m_device, m_cullSetLayout, nullptr);
     if (m_pipelineLayout) vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    if (m_compositeLayout) vkDestroyPipelineLayout(m_device, m_compositeLayout, nullptr);
+    if (m_descriptorSetLayout) vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+    if (m_compositeSetLayout) vkDestroyDescriptorSetLayout(m_device, m_compositeSetLayout, nullptr);
     if (m_renderPass) vkDestroyRenderPass(m_device, m_renderPass, nullptr);
+    if (m_loadRenderPass) vkDestroyRenderPass(m_device, m_loadRenderPass, nullptr);
+    if (m_layerClearPass) vkDestroyRenderPass(m_device, m_layerClearPass, nullptr);
+    if (m_layerLoadPass) vkDestroyRenderPass(m_device, m_layerLoadPass, nullptr);
     for (auto fb : m_swapchainFramebuffers) vkDestroyFramebuffer(m_device, fb, nullptr);
     for (auto iv : m_swapchainImageViews) vkDestroyImageView(m_device, iv, nullptr);
     if (m_swapchain) vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < m_inFlightFences.size(); i++) {
         vkDestroySemaphore(m_device, m_renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(m_device, m_imageAvailableSemaphores[i], nullptr);
         vkDestroyFence(m_device, m_inFlightFences[i], nullptr);
     }
+    m_recordPool.reset();
+    for (auto& frame : m_recordContexts) {
+        for (RecordContext& context : frame) vkDestroyCommandPool(m_device, context.pool, nullptr);
+    }
     if (m_commandPool) vkDestroyCommandPool(m_device, m_commandPool, nullptr);
     if (m_device) vkDestroyDevice(m_device, nullptr);
     if (m_surface) vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
@@ -45,30 +87,141 @@ VulkanEngine::~VulkanEngine() {
 }
 
 void VulkanEngine::init(GLFWwindow* window, const std::string& htmlContent, const std::string& cssContent) {
-    createInstance();
-    createSurface(window);
-    pickPhysicalDevice();
-    createLogicalDevice();
-    createSwapchain(window);
-    createImageViews();
-    createRenderPass();
-    createPipelineLayout();
-    createPipeline();
-    createFramebuffers();
-    createCommandPool();
-    buildRenderObjects(htmlContent, cssContent);
+    // Документ не зависит от устройства: разбор, стили и компоновка идут в своём потоке, пока
+    // создаются экземпляр, устройство и конвейеры. Встречаются потоки только у загрузки геометрии
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    m_worker = std::make_unique<DocumentWorker>(htmlContent, cssContent, static_cast<float>(width), static_cast<float>(height));
+    {
+        StartupTimeline::Phase phase("vulkan", "instance");
+        createInstance();
+        createSurface(window);
+    }
+    {
+        StartupTimeline::Phase phase("vulkan", "device");
+        pickPhysicalDevice();
+        createLogicalDevice();
+    }
+    {
+        StartupTimeline::Phase phase("vulkan", "swapchain");
+        createSwapchain(window);
+        createImageViews();
+    }
+    if (m_swapchainExtent.width != static_cast<uint32_t>(width) || m_swapchainExtent.height != static_cast<uint32_t>(height)) {
+        Log::warn("Swapchain extent differs from the framebuffer size the document is laid out for.");
+    }
+    {
+        StartupTimeline::Phase phase("vulkan", "pipelines");
+        createRenderPass();
+        createLayerRenderPasses();
+        createDescriptorSetLayout();
+        createPipelineLayout();
+        createPipeline();
+        createCompositePipeline();
+        if (m_config.gpuCulling) createCullPipeline();
+        createHudPipeline();
+        createFramebuffers();
+    }
+    {
+        StartupTimeline::Phase phase("vulkan", "glyph atlas");
+        createCommandPool();
+        createGlyphAtlas();
+        createDescriptorPool();
+        createUploads();
+    }
+    m_layers = std::make_unique<LayerTree>();
+    {
+        // Первый кадр показывает готовую страницу, а не пустой экран
+        StartupTimeline::Phase phase("vulkan", "wait for document");
+        m_worker->waitIdle();
+    }
+    m_worker->checkFailure();
+    {
+        StartupTimeline::Phase phase("vulkan", "geometry upload");
+        m_worker->consume();
+        applySnapshot(m_worker->snapshot());
+        flushUploads();
+    }
     createCommandBuffers();
+    createRecordContexts();
     createSyncObjects();
+    createQueryPool();
+    m_damage.reset(m_swapchainExtent.width, m_swapchainExtent.height, m_swapchainImages.size());
     Log::info("Vulkan Engine initialization complete.");
 }
 
 void VulkanEngine::drawFrame() {
-    vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+    TRACE_ZONE("frame");
+    auto frameStart = std::chrono::steady_clock::now();
+    HudFrame hud;
+    if (m_lastFrameStart.time_since_epoch().count() != 0) {
+        hud.frameMs = std::chrono::duration<float, std::milli>(frameStart - m_lastFrameStart).count();
+    }
+    m_lastFrameStart = frameStart;
+
+    {
+        TRACE_ZONE("wait for frame");
+        vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+    }
+    auto applyStart = std::chrono::steady_clock::now();
+    hud.waitMs = std::chrono::duration<float, std::milli>(applyStart - frameStart).count();
+    // Забор пройден: все кадры до прошлого занятия этого слота исполнены — освобождённое ими
+    // и промежуточный буфер слота снова свободны
+    releaseRetired(m_uploads[m_currentFrame]);
+
+    // Поток документа не ждём: кадр собирается из последнего готового снимка
+    m_worker->checkFailure();
+    if (m_worker->consume()) {
+        // Сколько снимок стоит потоку отрисовки: применение, запись и отправка его кадра
+        m_applyLatency.input(applyStart);
+        applySnapshot(m_worker->snapshot());
+    }
+    if (m_scrollChanged) {
+        m_scrollChanged = false;
+        compositeLayers();
+    }
+    // Оверлей меняется каждый кадр: его область перерисовывается вместе с тем, что под ним
+    if (m_hudVisible || m_hudHidden) m_damage.add(m_hud.bounds());
+    m_hudHidden = false;
+    m_damage.endFrame();
+    auto recordStart = std::chrono::steady_clock::now();
+    hud.applyMs = std::chrono::duration<float, std::milli>(recordStart - applyStart).count();
+    // Буфер оверлея этого кадра в полёте свободен только после его забора
+    m_hudCount = 0;
+    if (m_hudVisible) {
+        hud.gpuMs = readGpuTime();
+        const std::vector<HudRect>& rects = m_hud.build();
+        GpuBuffer& buffer = *m_hudBuffers[m_currentFrame];
+        buffer.reserve(rects.size() * sizeof(HudRect));
+        buffer.write(0, rects.data(), rects.size() * sizeof(HudRect));
+        m_hudCount = static_cast<uint32_t>(rects.size());
+    }
+    // Вторичные буферы этого кадра больше не исполняются — пулы сбрасываются целиком
+    for (RecordContext& context : m_recordContexts[m_currentFrame]) {
+        if (context.used == 0) continue;
+        vkResetCommandPool(m_device, context.pool, 0);
+        context.used = 0;
+    }
     uint32_t imageIndex;
-    vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+    {
+        TRACE_ZONE("acquire");
+        vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+    }
     vkResetFences(m_device, 1, &m_inFlightFences[m_currentFrame]);
     vkResetCommandBuffer(m_commandBuffers[m_currentFrame], 0);
-    recordCommandBuffer(m_commandBuffers[m_currentFrame], imageIndex);
+
+    // Изображение перерисовывается только там, где оно отстало от текущего кадра
+    bool fullRedraw;
+    std::vector<ScreenRect> damage = m_damage.takeImageDamage(imageIndex, fullRedraw);
+    recordCommandBuffer(m_commandBuffers[m_currentFrame], imageIndex, damage, fullRedraw);
+    auto submitStart = std::chrono::steady_clock::now();
+    hud.recordMs = std::chrono::duration<float, std::milli>(submitStart - recordStart).count();
+    if (m_logRepaint) {
+        m_logRepaint = false;
+        Log::debugf("Repaint: %zu rects, %llu of %u pixels shaded; layers recorded in %zu chunks, %.3f ms.", damage.size(),
+                    static_cast<unsigned long long>(DamageTracker::area(damage)), m_swapchainExtent.width * m_swapchainExtent.height,
+                    m_lastChunks, m_lastRecordMs);
+    }
     VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
     VkSemaphore waitSemaphores[] = {m_imageAvailableSemaphores[m_currentFrame]};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
@@ -80,8 +233,11 @@ void VulkanEngine::drawFrame() {
     VkSemaphore signalSemaphores[] = {m_renderFinishedSemaphores[m_currentFrame]};
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
-    if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS)
-        throw std::runtime_error("failed to submit draw command buffer!");
+    {
+        TRACE_ZONE("submit");
+        if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit draw command buffer!");
+    }
     VkPresentInfoKHR presentInfo{VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
     presentInfo.waitSemaphoreCount = 1;
     presentInfo.pWaitSemaphores = signalSemaphores;
@@ -89,43 +245,518 @@ void VulkanEngine::drawFrame() {
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = swapChains;
     presentInfo.pImageIndices = &imageIndex;
-    vkQueuePresentKHR(m_presentQueue, &presentInfo);
-    m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-}
-
-void VulkanEngine::buildRenderObjects(const std::string& htmlContent, const std::string& cssContent) {
-    Log::info("--- Building Render Pipeline ---");
-    auto tokens = HtmlTokenizer(htmlContent).tokenize();
-    auto domRoot = HtmlParser(tokens).parse();
-    auto stylesheet = CssParser(cssContent).parse();
-    auto styleRoot = StyleApplier::applyStyles(*domRoot, stylesheet);
-    auto layoutRoot = LayoutEngine::buildLayoutTree(*styleRoot);
-    DisplayList displayList = buildDisplayList(*layoutRoot);
-    
-    float screenWidth = m_swapchainExtent.width;
-    float screenHeight = m_swapchainExtent.height;
-    for (const auto& command : displayList) {
-        float r = command.color.r / 255.0f;
-        float g = command.color.g / 255.0f;
-        float b = command.color.b / 255.0f;
-        float x = (command.rect.x / screenWidth) * 2.0f - 1.0f;
-        float y = (command.rect.y / screenHeight) * 2.0f - 1.0f;
-        float w = (command.rect.width / screenWidth) * 2.0f;
-        float h = (command.rect.height / screenHeight) * 2.0f;
-        std::vector<Model::Vertex> vertices = {
-            {{x, y}, {r, g, b}}, {{x + w, y}, {r, g, b}}, {{x + w, y + h}, {r, g, b}},
-            {{x + w, y + h}, {r, g, b}}, {{x, y + h}, {r, g, b}}, {{x, y}, {r, g, b}}
-        };
-        m_renderObjects.push_back(std::make_unique<Model>(m_physicalDevice, m_device, vertices));
-    }
-    Log::info("Created " + std::to_string(m_renderObjects.size()) + " render objects.");
-}
-
-void VulkanEngine::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+    // Подсказка композитору: изменилась только повреждённая в этом кадре область
+    std::vector<VkRectLayerKHR> presentRects;
+    VkPresentRegionKHR presentRegion{};
+    VkPresentRegionsKHR presentRegions{VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR};
+    if (m_incrementalPresent && !m_damage.frameDamageFull() && !m_damage.frameDamage().empty()) {
+        for (const ScreenRect& rect : m_damage.frameDamage()) presentRects.push_back({{rect.x, rect.y}, {rect.width, rect.height}, 0});
+        presentRegion.rectangleCount = static_cast<uint32_t>(presentRects.size());
+        presentRegion.pRectangles = presentRects.data();
+        presentRegions.swapchainCount = 1;
+        presentRegions.pRegions = &presentRegion;
+        presentInfo.pNext = &presentRegions;
+    }
+    {
+        TRACE_ZONE("present");
+        vkQueuePresentKHR(m_presentQueue, &presentInfo);
+    }
+    if (m_hudVisible) {
+        hud.submitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+        const DocumentSnapshot& snapshot = m_worker->snapshot();
+        hud.styleMs = snapshot.styleMs;
+        hud.layoutMs = snapshot.layoutMs;
+        hud.paintMs = snapshot.paintMs;
+        hud.drawCalls = m_lastDrawCalls;
+        for (const auto& entry : m_gpuLayers) hud.instances += entry.second.drawCount;
+        hud.gpuMemoryBytes = MemoryTracker::gpuTotal().liveBytes;
+        m_hud.addFrame(hud);
+    }
+    // Сводки примерно раз в десять секунд непрерывного ввода или обновлений документа
+    const size_t LATENCY_LOG_SAMPLES = 600;
+    auto presented = std::chrono::steady_clock::now();
+    if (m_config.latencyProbe) {
+        m_latency.presented(presented);
+        if (m_latency.samples() >= LATENCY_LOG_SAMPLES) {
+            logLatency("Input-to-present latency", m_latency, "inputs");
+            m_latency.reset();
+        }
+    }
+    m_applyLatency.presented(presented);
+    if (m_applyLatency.samples() >= LATENCY_LOG_SAMPLES) {
+        logLatency("Snapshot apply-to-present time", m_applyLatency, "snapshots");
+        m_applyLatency.reset();
+    }
+    m_currentFrame = (m_currentFrame + 1) % m_config.framesInFlight;
+}
+
+void VulkanEngine::paceFrame() {
+    if (!m_config.paceFrames) return;
+    TRACE_ZONE("pace");
+    // Ввод опрашивается только после того, как GPU закончил прошлый кадр: новый кадр не встаёт
+    // в очередь за ним и показывает ввод, свежий на момент записи, а не на кадр раньше
+    uint32_t previous = (m_currentFrame + m_config.framesInFlight - 1) % m_config.framesInFlight;
+    vkWaitForFences(m_device, 1, &m_inFlightFences[previous], VK_TRUE, UINT64_MAX);
+}
+
+void VulkanEngine::inputReceived(std::chrono::steady_clock::time_point time) {
+    if (m_config.latencyProbe) m_latency.input(time);
+}
+
+void VulkanEngine::toggleHud() {
+    m_hudVisible = !m_hudVisible;
+    m_hudHidden = !m_hudVisible;
+    Log::info(m_hudVisible ? "Performance overlay shown." : "Performance overlay hidden.");
+}
+
+// Метки кадра, который прошлым занимал этот слот; их результат готов — забор уже пройден
+float VulkanEngine::readGpuTime() {
+    if (!m_queryPool || !m_queriesWritten[m_currentFrame]) return -1.0f;
+    uint64_t timestamps[2];
+    VkResult result = vkGetQueryPoolResults(m_device, m_queryPool, 2 * m_currentFrame, 2, sizeof(timestamps), timestamps,
+                                            sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) return -1.0f;
+    uint64_t ticks = (timestamps[1] - timestamps[0]) & m_timestampMask;
+    return static_cast<float>(ticks * static_cast<double>(m_timestampPeriod) / 1e6);
+}
+
+void VulkanEngine::logLatency(const char* label, const LatencyProbe& probe, const char* samples) {
+    LatencyProbe::Summary latency = probe.summary();
+    Log::infof("%s over %zu %s: mean %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms.", label, latency.samples, samples, latency.meanMs,
+               latency.p50Ms, latency.p99Ms, latency.maxMs);
+}
+
+void VulkanEngine::postTask(DocumentTask task) {
+    m_worker->post(std::move(task));
+}
+
+void VulkanEngine::pointerMoved(float x, float y) {
+    m_worker->pointerMoved(x, y);
+}
+
+void VulkanEngine::pointerButton(int button, bool pressed) {
+    m_worker->pointerButton(button, pressed);
+}
+
+void VulkanEngine::pointerLeft() {
+    m_worker->pointerLeft();
+}
+
+void VulkanEngine::scrollBy(float dy) {
+    scrollTo(m_scrollY + dy);
+}
+
+void VulkanEngine::scrollTo(float y) {
+    float maxScroll = std::max(0.0f, m_documentHeight - static_cast<float>(m_swapchainExtent.height));
+    float clamped = std::clamp(y, 0.0f, maxScroll);
+    if (clamped == m_scrollY) return;
+    // Слои сдвигаются сразу; поток документа догоняет растры и индекс попаданий в своём темпе
+    m_scrollY = clamped;
+    m_scrollChanged = true;
+    m_worker->scrollTo(m_scrollY, m_scrollAnchor);
+}
+
+Rect VulkanEngine::visibleRect() const {
+    return {0.0f, m_scrollY, static_cast<float>(m_swapchainExtent.width), static_cast<float>(m_swapchainExtent.height)};
+}
+
+void VulkanEngine::applySnapshot(const DocumentSnapshot& snapshot) {
+    TRACE_ZONE("apply snapshot");
+    bool first = m_snapshotVersion == 0;
+    m_snapshotVersion = snapshot.version;
+    m_documentHeight = snapshot.documentHeight;
+    // Якорение прокрутки в снимке сдвигает и то, что пользователь успел прокрутить поверх него
+    if (snapshot.scrollAnchor != m_scrollAnchor) {
+        m_scrollY = std::max(0.0f, m_scrollY + snapshot.scrollAnchor - m_scrollAnchor);
+        m_scrollAnchor = snapshot.scrollAnchor;
+    }
+    m_layers->setLayers(snapshot.layers);
+
+    InstanceUpdateStats diff;
+    size_t repainted = 0;
+    paintLayers(diff, repainted);
+    compositeLayers();
+    m_scrollChanged = false;
+    if (first) {
+        Log::infof("Instances: %zu quads, %zu bytes uploaded.", diff.inserted, m_lastUploadBytes);
+    } else if (repainted > 0) {
+        m_logRepaint = true;
+        Log::debugf("Snapshot %llu: %zu of %zu layers repainted. Instance diff: %zu inserted, %zu removed, %zu changed; "
+                    "%zu of %zu bytes uploaded%s", static_cast<unsigned long long>(snapshot.version), repainted, snapshot.layers.size(),
+                    diff.inserted, diff.removed, diff.changed, m_lastUploadBytes, diff.fullUploadBytes,
+                    diff.compacted ? " (compacted)." : ".");
+    }
+}
+
+void VulkanEngine::paintLayers(InstanceUpdateStats& diff, size_t& repainted) {
+    const Rect viewport = visibleRect();
+    const std::vector<Layer>& layers = m_layers->layers();
+    // Снимки между кадрами могли пропасть — перерисованным считается слой с другим содержимым, чем в буферах
+    std::vector<size_t> changed;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        if (!layers[i].content) continue;
+        auto it = m_gpuLayers.find(layers[i].owner);
+        if (it == m_gpuLayers.end() || it->second.content != layers[i].content) changed.push_back(i);
+    }
+    repainted = changed.size();
+    size_t alive = std::count_if(layers.begin(), layers.end(), [&](const Layer& layer) { return m_gpuLayers.count(layer.owner) > 0; });
+    bool released = alive != m_gpuLayers.size();
+    if (changed.empty() && !released) return;
+
+    // Кадры в полёте могут ещё читать буферы слоёв: изменения идут через промежуточный буфер кадра,
+    // а заменённое и освобождённое живёт до забора этого слота
+    releaseGpuLayers();
+
+    // Текст всех перерисованных слоёв раскладывается одним вызовом: атлас не отдаст другому глифу
+    // ячейку, на которую уже ссылается слой этого же кадра
+    std::vector<TextCommand> merged;
+    const std::vector<TextCommand>* texts = &merged;
+    std::unordered_map<const StyledNode*, size_t> textLayers;
+    if (changed.size() == 1) {
+        texts = &layers[changed.front()].content->texts;
+    } else {
+        for (size_t i : changed) {
+            const std::vector<TextCommand>& layerTexts = layers[i].content->texts;
+            merged.insert(merged.end(), layerTexts.begin(), layerTexts.end());
+            for (const TextCommand& text : layerTexts) textLayers[text.key.node] = i;
+        }
+    }
+    std::vector<GlyphQuad> glyphs;
+    if (!changed.empty()) m_textPainter->paint(*texts, glyphs);
+    std::vector<std::vector<GlyphQuad>> layerGlyphs(layers.size());
+    if (changed.size() == 1) {
+        layerGlyphs[changed.front()] = std::move(glyphs);
+    } else {
+        for (const GlyphQuad& glyph : glyphs) layerGlyphs[textLayers[glyph.key.node]].push_back(glyph);
+    }
+
+    // Каждый слой сравнивается со своим прошлым содержимым по ключам; перезаписываются только изменившиеся слоты
+    m_lastUploadBytes = 0;
+    for (size_t i : changed) {
+        const Layer& layer = layers[i];
+        GpuLayer& gpu = gpuLayer(layer);
+        const InstanceUpdateStats& layerDiff = gpu.instances->update(*layer.content, layerGlyphs[i]);
+        diff.inserted += layerDiff.inserted;
+        diff.removed += layerDiff.removed;
+        diff.changed += layerDiff.changed;
+        diff.fullUploadBytes += layerDiff.fullUploadBytes;
+        diff.compacted |= layerDiff.compacted;
+        m_lastUploadBytes += writeInstances(gpu);
+
+        // Новый растр перерисовывается целиком и попадает на экран через размещение квада;
+        // иначе повреждено только изменившееся — и в изображении слоя, и на экране
+        bool rasterMoved = !gpu.content || gpu.raster.x != layer.raster.x || gpu.raster.y != layer.raster.y ||
+                           gpu.raster.width != layer.raster.width || gpu.raster.height != layer.raster.height;
+        if (rasterMoved) {
+            gpu.damage.addFull();
+        } else {
+            float dx, dy;
+            LayerTree::screenOffset(layer, viewport, dx, dy);
+            for (const Rect& rect : gpu.instances->damage()) {
+                gpu.damage.add({rect.x - layer.raster.x, rect.y - layer.raster.y, rect.width, rect.height});
+                m_damage.add({rect.x + dx, rect.y + dy, rect.width, rect.height});
+            }
+        }
+        gpu.damage.endFrame();
+        gpu.content = layer.content;
+        gpu.raster = layer.raster;
+    }
+
+    // Догружаем на GPU только строки атласа, куда легли новые глифы; копию запишет кадр
+    GlyphAtlas& atlas = m_textPainter->atlas();
+    uint32_t firstRow, rowCount;
+    if (atlas.dirtyRows(firstRow, rowCount)) {
+        VkDeviceSize rowSize = m_glyphTexture->rowSize();
+        VkBuffer source;
+        VkDeviceSize offset = stage(atlas.pixels().data() + firstRow * rowSize, rowCount * rowSize, source);
+        m_uploads[m_currentFrame].atlasRows.push_back({source, offset, firstRow, rowCount});
+        atlas.clearDirty();
+        Log::debugf("Glyph atlas: %u rows uploaded, hit rate %d%%, run cache hit rate %d%%.", rowCount,
+                    static_cast<int>(atlas.stats().hitRate() * 100), static_cast<int>(m_textPainter->shaper().stats().hitRate() * 100));
+    }
+}
+
+VulkanEngine::GpuLayer& VulkanEngine::gpuLayer(const Layer& layer) {
+    GpuLayer& gpu = m_gpuLayers[layer.owner];
+    if (!gpu.instances) {
+        size_t capacity = layer.owner ? 256 : 4096;
+        gpu.instances = std::make_unique<InstanceCache>();
+        gpu.instanceBuffer = std::make_unique<GpuBuffer>(m_physicalDevice, m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                         capacity * sizeof(GpuInstance));
+        // Без отсечения на GPU список отрисовки сам читается как вход вершин
+        gpu.drawBuffer = std::make_unique<GpuBuffer>(m_physicalDevice, m_device,
+                                                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                     capacity * sizeof(DrawEntry));
+        if (m_config.gpuCulling) {
+            gpu.visibleBuffer = std::make_unique<GpuBuffer>(m_physicalDevice, m_device, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                            capacity * sizeof(DrawEntry));
+            gpu.indirectBuffer = std::make_unique<GpuBuffer>(m_physicalDevice, m_device,
+                                                             VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                             2 * sizeof(VkDrawIndirectCommand));
+        }
+
+        VkDescriptorSetLayout layouts[] = {m_descriptorSetLayout, m_compositeSetLayout, m_cullSetLayout};
+        VkDescriptorSet sets[3] = {};
+        VkDescriptorSetAllocateInfo allocInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+        allocInfo.descriptorPool = m_descriptorPool;
+        allocInfo.descriptorSetCount = m_config.gpuCulling ? 3 : 2;
+        allocInfo.pSetLayouts = layouts;
+        if (vkAllocateDescriptorSets(m_device, &allocInfo, sets) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate layer descriptor sets!");
+        gpu.contentSet = sets[0];
+        gpu.compositeSet = sets[1];
+        gpu.cullSet = sets[2];
+        writeContentDescriptor(gpu);
+        if (m_config.gpuCulling) writeCullDescriptor(gpu);
+    }
+
+    // Изображение только растёт: окно растра ездит по слою, почти не меняя размера
+    uint32_t width = static_cast<uint32_t>(layer.raster.width), height = static_cast<uint32_t>(layer.raster.height);
+    if (width > 0 && height > 0 && (!gpu.surface || gpu.surface->width() < width || gpu.surface->height() < height)) {
+        if (gpu.surface) {
+            width = std::max(width, gpu.surface->width());
+            height = std::max(height, gpu.surface->height());
+            // Прежнее изображение и набор, через который его читает сборка, нужны кадрам в полёте
+            m_uploads[m_currentFrame].retiredSurfaces.push_back(std::move(gpu.surface));
+            renewSet(gpu.compositeSet, m_compositeSetLayout);
+        }
+        gpu.surface = std::make_unique<LayerSurface>(m_physicalDevice, m_device, m_layerClearPass, m_swapchainImageFormat, m_depthFormat,
+                                                      width, height);
+        VkDescriptorImageInfo imageInfo{gpu.surface->sampler(), gpu.surface->imageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write.dstSet = gpu.compositeSet;
+        write.dstBinding = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.descriptorCount = 1;
+        write.pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+        gpu.damage.reset(width, height, 1);
+    }
+    return gpu;
+}
+
+void VulkanEngine::releaseGpuLayers() {
+    const std::vector<Layer>& layers = m_layers->layers();
+    for (auto it = m_gpuLayers.begin(); it != m_gpuLayers.end();) {
+        bool alive = std::any_of(layers.begin(), layers.end(), [&](const Layer& layer) { return layer.owner == it->first; });
+        if (alive) {
+            ++it;
+            continue;
+        }
+        // Кадры в полёте могут ещё рисовать слой: его ресурсы освобождаются после забора этого слота
+        FrameUploads& frame = m_uploads[m_currentFrame];
+        GpuLayer& gpu = it->second;
+        for (std::unique_ptr<GpuBuffer>* buffer : {&gpu.instanceBuffer, &gpu.drawBuffer, &gpu.visibleBuffer, &gpu.indirectBuffer}) {
+            if (*buffer) frame.retiredBuffers.push_back(std::move(*buffer));
+        }
+        if (gpu.surface) frame.retiredSurfaces.push_back(std::move(gpu.surface));
+        for (VkDescriptorSet set : {gpu.contentSet, gpu.compositeSet, gpu.cullSet}) {
+            if (set) frame.retiredSets.push_back(set);
+        }
+        it = m_gpuLayers.erase(it);
+    }
+}
+
+void VulkanEngine::compositeLayers() {
+    TRACE_ZONE("composite");
+    std::vector<Rect> damage;
+    m_layers->composite(visibleRect(), m_quads, damage);
+    for (const Rect& rect : damage) m_damage.add(rect);
+}
+
+size_t VulkanEngine::writeInstances(GpuLayer& layer) {
+    TRACE_ZONE("upload");
+    const std::vector<GpuInstance>& slots = layer.instances->slots();
+    const std::vector<DrawEntry>& draws = layer.instances->draws();
+    size_t bytes = 0;
+    bool reallocated = false;
+
+    // Выросший буфер — новый, его не читает ни один кадр в полёте: пишем всё прямо в отображение.
+    // Иначе изменившиеся диапазоны копирует GPU из промежуточного буфера кадра, до проходов слоёв
+    if (grow(layer.instanceBuffer, std::max<size_t>(slots.size(), 1) * sizeof(GpuInstance))) {
+        if (!slots.empty()) layer.instanceBuffer->write(0, slots.data(), slots.size() * sizeof(GpuInstance));
+        bytes += slots.size() * sizeof(GpuInstance);
+        renewSet(layer.contentSet, m_descriptorSetLayout);
+        writeContentDescriptor(layer);
+        reallocated = true;
+    } else {
+        for (const InstanceRange& range : layer.instances->dirtySlots()) {
+            stageCopy(*layer.instanceBuffer, range.first * sizeof(GpuInstance), &slots[range.first], range.count * sizeof(GpuInstance));
+            bytes += range.count * sizeof(GpuInstance);
+        }
+    }
+
+    if (grow(layer.drawBuffer, std::max<size_t>(draws.size(), 1) * sizeof(DrawEntry))) {
+        if (!draws.empty()) layer.drawBuffer->write(0, draws.data(), draws.size() * sizeof(DrawEntry));
+        bytes += draws.size() * sizeof(DrawEntry);
+        reallocated = true;
+    } else {
+        for (const InstanceRange& range : layer.instances->dirtyDraws()) {
+            stageCopy(*layer.drawBuffer, range.first * sizeof(DrawEntry), &draws[range.first], range.count * sizeof(DrawEntry));
+            bytes += range.count * sizeof(DrawEntry);
+        }
+    }
+    layer.drawCount = static_cast<uint32_t>(draws.size());
+    layer.opaqueCount = static_cast<uint32_t>(layer.instances->opaqueCount());
+    if (!m_config.gpuCulling) return bytes;
+    // Выжившие после отсечения пишет GPU; место нужно под весь список и по команде на сегмент
+    reallocated |= grow(layer.visibleBuffer, std::max<size_t>(draws.size(), 1) * sizeof(DrawEntry));
+    reallocated |= grow(layer.indirectBuffer, std::max<size_t>(drawSegments(layer).size(), 1) * sizeof(VkDrawIndirectCommand));
+    if (reallocated) {
+        renewSet(layer.cullSet, m_cullSetLayout);
+        writeCullDescriptor(layer);
+    }
+    return bytes;
+}
+
+// Буфер растёт заменой: прежний могут читать кадры в полёте, он освобождается после забора слота
+bool VulkanEngine::grow(std::unique_ptr<GpuBuffer>& buffer, VkDeviceSize size) {
+    if (size <= buffer->capacity()) return false;
+    VkDeviceSize capacity = std::max<VkDeviceSize>(buffer->capacity(), 256);
+    while (capacity < size) capacity *= 2;
+    std::unique_ptr<GpuBuffer> grown = std::make_unique<GpuBuffer>(m_physicalDevice, m_device, buffer->usage(), capacity);
+    m_uploads[m_currentFrame].retiredBuffers.push_back(std::move(buffer));
+    buffer = std::move(grown);
+    Log::infof("GPU buffer grown to %zu bytes.", static_cast<size_t>(capacity));
+    return true;
+}
+
+// Набор, привязанный в записанных кадрах, переписывать нельзя — на его место встаёт новый
+void VulkanEngine::renewSet(VkDescriptorSet& set, VkDescriptorSetLayout layout) {
+    VkDescriptorSetAllocateInfo allocInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+    VkDescriptorSet renewed;
+    if (vkAllocateDescriptorSets(m_device, &allocInfo, &renewed) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate layer descriptor set!");
+    m_uploads[m_currentFrame].retiredSets.push_back(set);
+    set = renewed;
+}
+
+// Пишет в промежуточный буфер кадра и возвращает смещение; смещения выровнены и для копий в изображение
+VkDeviceSize VulkanEngine::stage(const void* data, size_t size, VkBuffer& source) {
+    FrameUploads& frame = m_uploads[m_currentFrame];
+    VkDeviceSize offset = (frame.stagingUsed + 15) & ~VkDeviceSize(15);
+    if (offset + size > frame.staging->capacity()) {
+        // Записанные копии ещё читают прежний буфер — он уходит вместе с кадром
+        VkDeviceSize capacity = frame.staging->capacity() * 2;
+        while (capacity < size) capacity *= 2;
+        frame.retiredBuffers.push_back(std::move(frame.staging));
+        frame.staging = std::make_unique<GpuBuffer>(m_physicalDevice, m_device, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, capacity);
+        offset = 0;
+    }
+    frame.staging->write(offset, data, size);
+    frame.stagingUsed = offset + size;
+    source = frame.staging->handle();
+    return offset;
+}
+
+void VulkanEngine::stageCopy(GpuBuffer& destination, VkDeviceSize offset, const void* data, size_t size) {
+    VkBuffer source;
+    VkDeviceSize sourceOffset = stage(data, size, source);
+    m_uploads[m_currentFrame].copies.push_back({source, destination.handle(), sourceOffset, offset, size});
+}
+
+void VulkanEngine::recordUploads(VkCommandBuffer commandBuffer) {
+    FrameUploads& frame = m_uploads[m_currentFrame];
+    if (frame.copies.empty() && frame.atlasRows.empty()) return;
+    TRACE_ZONE("record uploads");
+    // Прошлые кадры в этой очереди могли ещё читать перезаписываемые диапазоны или копировать в них
+    VkMemoryBarrier before{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    before.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    before.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &before, 0, nullptr, 0, nullptr);
+    // Соседние копии между одной парой буферов — одной командой
+    std::vector<VkBufferCopy> regions;
+    for (size_t i = 0; i < frame.copies.size(); ++i) {
+        const FrameUploads::Copy& copy = frame.copies[i];
+        regions.push_back({copy.sourceOffset, copy.destinationOffset, copy.size});
+        bool last = i + 1 == frame.copies.size() || frame.copies[i + 1].source != copy.source ||
+                    frame.copies[i + 1].destination != copy.destination;
+        if (!last) continue;
+        vkCmdCopyBuffer(commandBuffer, copy.source, copy.destination, static_cast<uint32_t>(regions.size()), regions.data());
+        regions.clear();
+    }
+    for (const FrameUploads::AtlasRows& rows : frame.atlasRows) {
+        m_glyphTexture->recordUpload(commandBuffer, rows.source, rows.offset, rows.firstRow, rows.rowCount);
+    }
+    VkMemoryBarrier after{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    after.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    after.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &after, 0, nullptr, 0, nullptr);
+    frame.copies.clear();
+    frame.atlasRows.clear();
+}
+
+// Только при запуске: кадров в полёте ещё нет, и загрузку первого снимка можно дождаться
+void VulkanEngine::flushUploads() {
+    VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate upload command buffer!");
     VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    recordUploads(commandBuffer);
+    vkEndCommandBuffer(commandBuffer);
+    VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(m_graphicsQueue);
+    vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
+    releaseRetired(m_uploads[m_currentFrame]);
+}
+
+void VulkanEngine::releaseRetired(FrameUploads& frame) {
+    if (!frame.retiredSets.empty()) {
+        vkFreeDescriptorSets(m_device, m_descriptorPool, static_cast<uint32_t>(frame.retiredSets.size()), frame.retiredSets.data());
+        frame.retiredSets.clear();
+    }
+    frame.retiredBuffers.clear();
+    frame.retiredSurfaces.clear();
+    frame.stagingUsed = 0;
+}
+
+std::vector<VulkanEngine::DrawSegment> VulkanEngine::drawSegments(const GpuLayer& layer) {
+    std::vector<DrawSegment> segments;
+    auto cut = [&](uint32_t first, uint32_t count, bool translucent) {
+        for (uint32_t offset = 0; offset < count; offset += DRAWS_PER_CHUNK) {
+            segments.push_back({first + offset, std::min(DRAWS_PER_CHUNK, count - offset), static_cast<uint32_t>(segments.size()), translucent});
+        }
+    };
+    cut(0, layer.opaqueCount, false);
+    cut(layer.opaqueCount, layer.drawCount - layer.opaqueCount, true);
+    return segments;
+}
+
+void VulkanEngine::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<ScreenRect>& damage, bool fullRedraw) {
+    TRACE_ZONE("record");
+    VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    // Время GPU меряется, только пока его показывает оверлей
+    bool timed = m_hudVisible && m_queryPool;
+    if (timed) {
+        vkCmdResetQueryPool(commandBuffer, m_queryPool, 2 * m_currentFrame, 2);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 2 * m_currentFrame);
+    }
+    m_queriesWritten[m_currentFrame] = timed;
+    // Сначала догоняются изображения слоёв, затем кадр собирается из их квадов
+    m_lastDrawCalls = 0;
+    recordUploads(commandBuffer);
+    recordLayers(commandBuffer);
+
     VkRenderPassBeginInfo renderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
-    renderPassInfo.renderPass = m_renderPass;
+    renderPassInfo.renderPass = fullRedraw ? m_renderPass : m_loadRenderPass;
     renderPassInfo.framebuffer = m_swapchainFramebuffers[imageIndex];
     renderPassInfo.renderArea.offset = {0, 0};
     renderPassInfo.renderArea.extent = m_swapchainExtent;
@@ -133,19 +764,265 @@ void VulkanEngine::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t i
     renderPassInfo.clearValueCount = 1;
     renderPassInfo.pClearValues = &clearColor;
     vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-    m_pipeline->bind(commandBuffer);
+
+    if (!fullRedraw && !damage.empty()) {
+        // Повреждённые области заливаем фоном так же, как это делает очистка при полной перерисовке
+        std::vector<VkClearRect> clearRects;
+        for (const ScreenRect& rect : damage) clearRects.push_back({{{rect.x, rect.y}, {rect.width, rect.height}}, 0, 1});
+        VkClearAttachment clearAttachment{VK_IMAGE_ASPECT_COLOR_BIT, 0, clearColor};
+        vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, static_cast<uint32_t>(clearRects.size()), clearRects.data());
+    }
+
+    m_compositePipeline->bind(commandBuffer);
     VkViewport viewport{0.0f, 0.0f, (float)m_swapchainExtent.width, (float)m_swapchainExtent.height, 0.0f, 1.0f};
     vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-    VkRect2D scissor{{0, 0}, m_swapchainExtent};
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-    for (const auto& obj : m_renderObjects) {
-        obj->bind(commandBuffer);
-        obj->draw(commandBuffer);
+    const std::vector<Layer>& layers = m_layers->layers();
+    for (const CompositeQuad& quad : m_quads) {
+        const Layer& layer = layers[quad.layer];
+        auto it = m_gpuLayers.find(layer.owner);
+        if (it == m_gpuLayers.end() || !it->second.surface) continue;
+        const LayerSurface& surface = *it->second.surface;
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_compositeLayout, 0, 1, &it->second.compositeSet, 0, nullptr);
+        // Прокрутка, сдвиг и прозрачность слоя — только эти константы, его изображение и буферы не меняются
+        float constants[12] = {quad.screen.x, quad.screen.y, quad.screen.width, quad.screen.height,
+                               0.0f, 0.0f, layer.raster.width / surface.width(), layer.raster.height / surface.height(),
+                               (float)m_swapchainExtent.width, (float)m_swapchainExtent.height, quad.opacity, 0.0f};
+        vkCmdPushConstants(commandBuffer, m_compositeLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+                           sizeof(constants), constants);
+        // Прямоугольники повреждений не пересекаются, поэтому смешивание в каждом пикселе происходит один раз
+        for (const ScreenRect& rect : damage) {
+            if (rect.x >= quad.screen.x + quad.screen.width || rect.x + (float)rect.width <= quad.screen.x ||
+                rect.y >= quad.screen.y + quad.screen.height || rect.y + (float)rect.height <= quad.screen.y) continue;
+            VkRect2D scissor{{rect.x, rect.y}, {rect.width, rect.height}};
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+            vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+            ++m_lastDrawCalls;
+        }
     }
+    recordHud(commandBuffer);
     vkCmdEndRenderPass(commandBuffer);
+    if (timed) vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 2 * m_currentFrame + 1);
     vkEndCommandBuffer(commandBuffer);
 }
 
+// Весь оверлей — один инстансированный вызов поверх собранного кадра
+void VulkanEngine::recordHud(VkCommandBuffer commandBuffer) {
+    if (m_hudCount == 0) return;
+    Rect bounds = m_hud.bounds();
+    int32_t x0 = std::max(0, static_cast<int32_t>(bounds.x)), y0 = std::max(0, static_cast<int32_t>(bounds.y));
+    int32_t x1 = std::min(static_cast<int32_t>(m_swapchainExtent.width), static_cast<int32_t>(std::ceil(bounds.x + bounds.width)));
+    int32_t y1 = std::min(static_cast<int32_t>(m_swapchainExtent.height), static_cast<int32_t>(std::ceil(bounds.y + bounds.height)));
+    if (x1 <= x0 || y1 <= y0) return;
+    m_hudPipeline->bind(commandBuffer);
+    VkRect2D scissor{{x0, y0}, {static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0)}};
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    float viewportSize[2] = {(float)m_swapchainExtent.width, (float)m_swapchainExtent.height};
+    vkCmdPushConstants(commandBuffer, m_hudLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(viewportSize), viewportSize);
+    VkBuffer buffers[] = {m_hudBuffers[m_currentFrame]->handle()};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+    vkCmdDraw(commandBuffer, 6, m_hudCount, 0, 0);
+    ++m_lastDrawCalls;
+}
+
+void VulkanEngine::recordLayers(VkCommandBuffer commandBuffer) {
+    // Пачка прямоугольников повреждений на сегмент списка отрисовки — единица работы одного потока
+    const size_t RECTS_PER_CHUNK = 8;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<LayerPass> passes;
+    std::vector<RecordChunk> chunks;
+    for (const Layer& layer : m_layers->layers()) {
+        auto it = m_gpuLayers.find(layer.owner);
+        if (it == m_gpuLayers.end() || !it->second.surface) continue;
+        LayerPass pass{&layer, &it->second};
+        pass.damage = it->second.damage.takeImageDamage(0, pass.fullRedraw);
+        if (pass.damage.empty()) continue;
+        // Корневой слой непрозрачен, как прежний фон кадра; остальные слои — прозрачны вне своего содержимого
+        pass.clearColor = layer.owner ? VkClearValue{{{0.0f, 0.0f, 0.0f, 0.0f}}} : VkClearValue{{{0.1f, 0.1f, 0.1f, 1.0f}}};
+        pass.segments = drawSegments(it->second);
+        pass.firstChunk = chunks.size();
+        for (size_t first = 0; first < pass.damage.size(); first += RECTS_PER_CHUNK) {
+            size_t rectCount = std::min(RECTS_PER_CHUNK, pass.damage.size() - first);
+            // Слой без квадов только очищается — одна пачка без сегмента
+            for (size_t segment = 0; segment < std::max<size_t>(pass.segments.size(), 1); ++segment) {
+                chunks.push_back({passes.size(), first, rectCount, segment});
+            }
+        }
+        pass.chunkCount = chunks.size() - pass.firstChunk;
+        // Косвенная отрисовка на каждый прямоугольник повреждений и каждый сегмент
+        m_lastDrawCalls += static_cast<uint32_t>(pass.segments.size() * pass.damage.size());
+        passes.push_back(std::move(pass));
+    }
+
+    // Каждый поток пишет во вторичные буферы из своего пула — без блокировок
+    std::vector<RecordContext>& contexts = m_recordContexts[m_currentFrame];
+    m_recordPool->parallelFor(chunks.size(), [&](size_t i) {
+        RecordChunk& chunk = chunks[i];
+        const LayerPass& pass = passes[chunk.pass];
+        chunk.commandBuffer = secondaryBuffer(contexts[m_recordPool->threadIndex()]);
+        VkCommandBufferInheritanceInfo inheritance{VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+        inheritance.renderPass = pass.fullRedraw ? m_layerClearPass : m_layerLoadPass;
+        inheritance.subpass = 0;
+        inheritance.framebuffer = pass.gpu->surface->framebuffer();
+        VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritance;
+        vkBeginCommandBuffer(chunk.commandBuffer, &beginInfo);
+        recordChunk(pass, chunk, chunk.commandBuffer);
+        vkEndCommandBuffer(chunk.commandBuffer);
+    });
+
+    if (m_config.gpuCulling) recordCulling(commandBuffer, passes);
+
+    // Порядок исполнения задаёт первичный буфер: проходы слоёв и пачки внутри них — как в списке
+    std::vector<VkCommandBuffer> secondaries;
+    for (const LayerPass& pass : passes) {
+        VkClearValue clearValues[2] = {pass.clearColor, {}};
+        clearValues[1].depthStencil = {1.0f, 0};
+        VkRenderPassBeginInfo renderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+        renderPassInfo.renderPass = pass.fullRedraw ? m_layerClearPass : m_layerLoadPass;
+        renderPassInfo.framebuffer = pass.gpu->surface->framebuffer();
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = {pass.gpu->surface->width(), pass.gpu->surface->height()};
+        renderPassInfo.clearValueCount = 2;
+        renderPassInfo.pClearValues = clearValues;
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        secondaries.clear();
+        for (size_t i = 0; i < pass.chunkCount; ++i) secondaries.push_back(chunks[pass.firstChunk + i].commandBuffer);
+        vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+        vkCmdEndRenderPass(commandBuffer);
+    }
+    m_lastChunks = chunks.size();
+    m_lastRecordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void VulkanEngine::recordChunk(const LayerPass& pass, const RecordChunk& chunk, VkCommandBuffer commandBuffer) {
+    TRACE_ZONE("record chunk");
+    const GpuLayer& gpu = *pass.gpu;
+    const ScreenRect* rects = pass.damage.data() + chunk.firstRect;
+    if (!pass.fullRedraw && chunk.segment == 0) {
+        std::vector<VkClearRect> clearRects;
+        for (size_t r = 0; r < chunk.rectCount; ++r) clearRects.push_back({{{rects[r].x, rects[r].y}, {rects[r].width, rects[r].height}}, 0, 1});
+        VkClearAttachment clearAttachment{VK_IMAGE_ASPECT_COLOR_BIT, 0, pass.clearColor};
+        vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, static_cast<uint32_t>(clearRects.size()), clearRects.data());
+    }
+    if (pass.segments.empty()) return;
+    const DrawSegment& segment = pass.segments[chunk.segment];
+
+    // Вторичный буфер не наследует состояние — всё привязывается заново
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &gpu.contentSet, 0, nullptr);
+    VkViewport viewport{0.0f, 0.0f, (float)gpu.surface->width(), (float)gpu.surface->height(), 0.0f, 1.0f};
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    // Начало координат изображения — левый верхний угол растра слоя в документе
+    float viewportConstants[4] = {(float)gpu.surface->width(), (float)gpu.surface->height(), pass.layer->raster.x, pass.layer->raster.y};
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(viewportConstants), viewportConstants);
+    // Непрозрачные идут спереди назад: закрытые ими фрагменты отсекает ранний тест глубины.
+    // Полупрозрачные и глифы — в пачках после них, сзади вперёд, со смешиванием и без записи глубины
+    (segment.translucent ? *m_translucentPipeline : *m_opaquePipeline).bind(commandBuffer);
+    if (!m_config.gpuCulling) {
+        // Весь сегмент списка одним инстансированным вызовом на прямоугольник; лишнее отрезает ножницы
+        VkBuffer buffers[] = {gpu.drawBuffer->handle()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        for (size_t r = 0; r < chunk.rectCount; ++r) {
+            VkRect2D scissor{{rects[r].x, rects[r].y}, {rects[r].width, rects[r].height}};
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+            vkCmdDraw(commandBuffer, 6, segment.count, 0, segment.first);
+        }
+        return;
+    }
+    // Сколько квадов рисовать, решило отсечение на GPU: CPU записывает одну косвенную команду.
+    // Выжившие сегмента лежат с его начала; смещение привязки вместо firstInstance в косвенной команде
+    VkBuffer buffers[] = {gpu.visibleBuffer->handle()};
+    VkDeviceSize offsets[] = {segment.first * sizeof(DrawEntry)};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+    for (size_t r = 0; r < chunk.rectCount; ++r) {
+        VkRect2D scissor{{rects[r].x, rects[r].y}, {rects[r].width, rects[r].height}};
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        vkCmdDrawIndirect(commandBuffer, gpu.indirectBuffer->handle(), segment.command * sizeof(VkDrawIndirectCommand), 1,
+                          sizeof(VkDrawIndirectCommand));
+    }
+}
+
+void VulkanEngine::recordCulling(VkCommandBuffer commandBuffer, const std::vector<LayerPass>& passes) {
+    struct CullConstants {
+        float bounds[4];
+        uint32_t first, count, ordered, firstCommand;
+    };
+    bool any = std::any_of(passes.begin(), passes.end(), [](const LayerPass& pass) { return !pass.segments.empty(); });
+    if (!any) return;
+
+    // Прошлый кадр мог ещё читать выживших и косвенные команды — перезапись ждёт его отрисовки
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+    std::vector<VkDrawIndirectCommand> reset;
+    for (const LayerPass& pass : passes) {
+        if (pass.segments.empty()) continue;
+        reset.assign(pass.segments.size(), {6, 0, 0, 0});
+        vkCmdUpdateBuffer(commandBuffer, pass.gpu->indirectBuffer->handle(), 0, reset.size() * sizeof(VkDrawIndirectCommand), reset.data());
+    }
+    VkMemoryBarrier resetBarrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr,
+                         0, nullptr);
+
+    m_cullPipeline->bind(commandBuffer);
+    for (const LayerPass& pass : passes) {
+        const GpuLayer& gpu = *pass.gpu;
+        if (pass.segments.empty()) continue;
+        // Отсекается всё вне охватывающего прямоугольника повреждений, в координатах документа
+        int32_t x0 = pass.damage.front().x, y0 = pass.damage.front().y, x1 = x0, y1 = y0;
+        for (const ScreenRect& rect : pass.damage) {
+            x0 = std::min(x0, rect.x);
+            y0 = std::min(y0, rect.y);
+            x1 = std::max(x1, rect.x + static_cast<int32_t>(rect.width));
+            y1 = std::max(y1, rect.y + static_cast<int32_t>(rect.height));
+        }
+        CullConstants constants{{pass.layer->raster.x + x0, pass.layer->raster.y + y0, static_cast<float>(x1 - x0), static_cast<float>(y1 - y0)}};
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullLayout, 0, 1, &gpu.cullSet, 0, nullptr);
+        uint32_t opaqueSegments = (gpu.opaqueCount + DRAWS_PER_CHUNK - 1) / DRAWS_PER_CHUNK;
+        if (gpu.opaqueCount > 0) {
+            constants.first = 0;
+            constants.count = gpu.opaqueCount;
+            constants.ordered = 0;
+            constants.firstCommand = 0;
+            vkCmdPushConstants(commandBuffer, m_cullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+            vkCmdDispatch(commandBuffer, (gpu.opaqueCount + 255) / 256, 1, 1);
+        }
+        if (gpu.drawCount > gpu.opaqueCount) {
+            // Порядок смешивания внутри сегмента сохраняет его рабочая группа
+            constants.first = gpu.opaqueCount;
+            constants.count = gpu.drawCount - gpu.opaqueCount;
+            constants.ordered = 1;
+            constants.firstCommand = opaqueSegments;
+            vkCmdPushConstants(commandBuffer, m_cullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+            vkCmdDispatch(commandBuffer, static_cast<uint32_t>(pass.segments.size()) - opaqueSegments, 1, 1);
+        }
+    }
+
+    VkMemoryBarrier cullBarrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+}
+
+VkCommandBuffer VulkanEngine::secondaryBuffer(RecordContext& context) {
+    if (context.used == context.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        allocInfo.commandPool = context.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate secondary command buffer!");
+        context.buffers.push_back(commandBuffer);
+    }
+    return context.buffers[context.used++];
+}
+
 void VulkanEngine::createInstance() {
     VkApplicationInfo appInfo{VK_STRUCTURE_TYPE_APPLICATION_INFO};
     appInfo.pApplicationName = "VkUI Engine";
@@ -202,23 +1079,36 @@ void VulkanEngine::createLogicalDevice() {
     info.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     info.pQueueCreateInfos = queueCreateInfos.data();
     info.pEnabledFeatures = &features;
-    info.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    info.ppEnabledExtensionNames = deviceExtensions.data();
+    // VK_KHR_incremental_present необязателен: без него повреждения просто не передаются композитору
+    std::vector<const char*> extensions = deviceExtensions;
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+    for (const auto& extension : availableExtensions) {
+        if (std::string(extension.extensionName) == VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME) m_incrementalPresent = true;
+    }
+    if (m_incrementalPresent) extensions.push_back(VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME);
+    info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    info.ppEnabledExtensionNames = extensions.data();
     if (vkCreateDevice(m_physicalDevice, &info, nullptr, &m_device) != VK_SUCCESS)
         throw std::runtime_error("failed to create logical device!");
     vkGetDeviceQueue(m_device, indices.graphicsFamily.value(), 0, &m_graphicsQueue);
     vkGetDeviceQueue(m_device, indices.presentFamily.value(), 0, &m_presentQueue);
-    Log::info("Logical device and queues created.");
+    Log::info(std::string("Logical device and queues created") + (m_incrementalPresent ? " (incremental present)." : "."));
 }
 
 void VulkanEngine::createSwapchain(GLFWwindow* window) {
     SwapchainSupportDetails support = querySwapchainSupport(m_physicalDevice, m_surface);
     VkSurfaceFormatKHR format = chooseSwapSurfaceFormat(support.formats);
-    VkPresentModeKHR mode = chooseSwapPresentMode(support.presentModes);
+    VkPresentModeKHR mode = chooseSwapPresentMode(support.presentModes, m_config.presentMode);
     VkExtent2D extent = chooseSwapExtent(support.capabilities, window);
-    uint32_t imageCount = support.capabilities.minImageCount + 1;
+    uint32_t imageCount = m_config.swapchainImages ? m_config.swapchainImages : support.capabilities.minImageCount + 1;
+    imageCount = std::max(imageCount, support.capabilities.minImageCount);
     if (support.capabilities.maxImageCount > 0 && imageCount > support.capabilities.maxImageCount)
         imageCount = support.capabilities.maxImageCount;
+    if (m_config.swapchainImages && imageCount != m_config.swapchainImages)
+        Log::warn("Swapchain image count " + std::to_string(m_config.swapchainImages) + " is not supported, using " + std::to_string(imageCount) + ".");
     VkSwapchainCreateInfoKHR info{VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
     info.surface = m_surface;
     info.minImageCount = imageCount;
@@ -239,7 +1129,8 @@ void VulkanEngine::createSwapchain(GLFWwindow* window) {
     info.preTransform = support.capabilities.currentTransform;
     info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     info.presentMode = mode;
-    info.clipped = VK_TRUE;
+    // Частичная перерисовка опирается на прежнее содержимое изображения, в том числе скрытых пикселей
+    info.clipped = VK_FALSE;
     if (vkCreateSwapchainKHR(m_device, &info, nullptr, &m_swapchain) != VK_SUCCESS)
         throw std::runtime_error("failed to create swap chain!");
     vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, nullptr);
@@ -247,7 +1138,10 @@ void VulkanEngine::createSwapchain(GLFWwindow* window) {
     vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, m_swapchainImages.data());
     m_swapchainImageFormat = format.format;
     m_swapchainExtent = extent;
-    Log::info("Swapchain created.");
+    const char* modeName = mode == VK_PRESENT_MODE_MAILBOX_KHR ? "MAILBOX" : mode == VK_PRESENT_MODE_IMMEDIATE_KHR ? "IMMEDIATE"
+                           : mode == VK_PRESENT_MODE_FIFO_KHR ? "FIFO" : "other";
+    Log::info("Swapchain created: " + std::to_string(imageCount) + " images, " + modeName + ", " + std::to_string(m_config.framesInFlight) +
+              " frames in flight" + (m_config.paceFrames ? ", paced." : "."));
 }
 
 void VulkanEngine::createImageViews() {
@@ -267,40 +1161,138 @@ void VulkanEngine::createImageViews() {
 }
 
 void VulkanEngine::createRenderPass() {
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = m_swapchainImageFormat;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    VkRenderPassCreateInfo renderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
-    if (vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS)
-        throw std::runtime_error("failed to create render pass!");
-    Log::info("Render pass created.");
+    // Два совместимых прохода: очищающий для полной перерисовки и загружающий прежнее
+    // содержимое для частичной; один набор фреймбуферов и конвейер подходят обоим.
+    auto create = [&](VkAttachmentLoadOp loadOp, VkImageLayout initialLayout, VkRenderPass& renderPass) {
+        VkAttachmentDescription colorAttachment{};
+        colorAttachment.format = m_swapchainImageFormat;
+        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.loadOp = loadOp;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.initialLayout = initialLayout;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        VkAttachmentReference colorAttachmentRef{};
+        colorAttachmentRef.attachment = 0;
+        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorAttachmentRef;
+        VkSubpassDependency dependency{};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        VkRenderPassCreateInfo renderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+        renderPassInfo.attachmentCount = 1;
+        renderPassInfo.pAttachments = &colorAttachment;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = 1;
+        renderPassInfo.pDependencies = &dependency;
+        if (vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+            throw std::runtime_error("failed to create render pass!");
+    };
+    create(VK_ATTACHMENT_LOAD_OP_CLEAR, VK_IMAGE_LAYOUT_UNDEFINED, m_renderPass);
+    create(VK_ATTACHMENT_LOAD_OP_LOAD, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, m_loadRenderPass);
+    Log::info("Render passes created.");
+}
+
+VkFormat VulkanEngine::findDepthFormat() {
+    for (VkFormat format : {VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D24_UNORM_S8_UINT}) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &properties);
+        if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) return format;
+    }
+    throw std::runtime_error("failed to find a supported depth format!");
+}
+
+void VulkanEngine::createLayerRenderPasses() {
+    // Та же пара для изображений слоёв: после прохода изображение готово к чтению при сборке кадра.
+    // Глубина нужна только внутри прохода: всегда очищается и не сохраняется
+    m_depthFormat = findDepthFormat();
+    auto create = [&](VkAttachmentLoadOp loadOp, VkImageLayout initialLayout, VkRenderPass& renderPass) {
+        VkAttachmentDescription attachments[2]{};
+        attachments[0].format = m_swapchainImageFormat;
+        attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[0].loadOp = loadOp;
+        attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachments[0].initialLayout = initialLayout;
+        attachments[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        attachments[1].format = m_depthFormat;
+        attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        VkAttachmentReference colorAttachmentRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        VkAttachmentReference depthAttachmentRef{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorAttachmentRef;
+        subpass.pDepthStencilAttachment = &depthAttachmentRef;
+        // Вход: прошлая сборка кадра могла ещё читать изображение, прошлый проход — писать глубину;
+        // выход: запись видна сборке этого кадра
+        VkSubpassDependency dependencies[2]{};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                       VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                       VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        VkRenderPassCreateInfo renderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+        renderPassInfo.attachmentCount = 2;
+        renderPassInfo.pAttachments = attachments;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = 2;
+        renderPassInfo.pDependencies = dependencies;
+        if (vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+            throw std::runtime_error("failed to create layer render pass!");
+    };
+    create(VK_ATTACHMENT_LOAD_OP_CLEAR, VK_IMAGE_LAYOUT_UNDEFINED, m_layerClearPass);
+    create(VK_ATTACHMENT_LOAD_OP_LOAD, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_layerLoadPass);
+    Log::info("Layer render passes created.");
+}
+
+void VulkanEngine::createDescriptorSetLayout() {
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    VkDescriptorSetLayoutCreateInfo layoutInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create descriptor set layout!");
+    Log::info("Descriptor set layout created.");
 }
 
 void VulkanEngine::createPipelineLayout() {
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+    VkPushConstantRange viewportRange{VK_SHADER_STAGE_VERTEX_BIT, 0, 4 * sizeof(float)};
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &viewportRange;
     if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
         throw std::runtime_error("failed to create pipeline layout!");
     Log::info("Pipeline layout created.");
@@ -308,18 +1300,161 @@ void VulkanEngine::createPipelineLayout() {
 
 void VulkanEngine::createPipeline() {
     PipelineConfigInfo pipelineConfig{};
+    // Единственный вершинный вход — слот экземпляра и его место в порядке отрисовки; углы квада берутся из gl_VertexIndex
+    pipelineConfig.bindingDescriptions = {{0, sizeof(DrawEntry), VK_VERTEX_INPUT_RATE_INSTANCE}};
+    pipelineConfig.attributeDescriptions = {{0, 0, VK_FORMAT_R32G32_UINT, 0}};
     pipelineConfig.inputAssemblyInfo = {VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, nullptr, 0, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE};
     pipelineConfig.viewportInfo = {VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO, nullptr, 0, 1, nullptr, 1, nullptr};
     pipelineConfig.rasterizationInfo = {VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO, nullptr, 0, VK_FALSE, VK_FALSE, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE, VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f};
     pipelineConfig.multisampleInfo = {VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, nullptr, 0, VK_SAMPLE_COUNT_1_BIT, VK_FALSE, 1.0f, nullptr, VK_FALSE, VK_FALSE};
-    pipelineConfig.colorBlendAttachment = {VK_FALSE, VK_BLEND_FACTOR_ZERO, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD, VK_BLEND_FACTOR_ZERO, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD, 0xf};
-    pipelineConfig.colorBlendInfo = {VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, nullptr, 0, VK_FALSE, VK_LOGIC_OP_COPY, 1, &pipelineConfig.colorBlendAttachment, {0.0f, 0.0f, 0.0f, 0.0f}};
     std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
     pipelineConfig.dynamicStateInfo = {VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO, nullptr, 0, static_cast<uint32_t>(dynamicStates.size()), dynamicStates.data()};
     pipelineConfig.pipelineLayout = m_pipelineLayout;
+    pipelineConfig.renderPass = m_layerClearPass;
+    pipelineConfig.subpass = 0;
+
+    // Непрозрачные: без смешивания, пишут глубину — всё, что нарисовано позже под ними, отсекается до шейдера
+    pipelineConfig.colorBlendAttachment = {VK_FALSE, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD, 0xf};
+    pipelineConfig.colorBlendInfo = {VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, nullptr, 0, VK_FALSE, VK_LOGIC_OP_COPY, 1, &pipelineConfig.colorBlendAttachment, {0.0f, 0.0f, 0.0f, 0.0f}};
+    pipelineConfig.depthStencilInfo = {VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
+    pipelineConfig.depthStencilInfo.depthTestEnable = VK_TRUE;
+    pipelineConfig.depthStencilInfo.depthWriteEnable = VK_TRUE;
+    pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+    pipelineConfig.depthStencilInfo.maxDepthBounds = 1.0f;
+    m_opaquePipeline = std::make_unique<Pipeline>(m_device, "shaders/vert.spv", "shaders/frag.spv", pipelineConfig);
+
+    // Полупрозрачные и глифы смешиваются с тем, что под ними, и проверяют глубину непрозрачных, не записывая свою.
+    // Альфа накапливается как «поверх»: в прозрачном слое получается цвет с предумноженной альфой
+    pipelineConfig.colorBlendAttachment = {VK_TRUE, VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD, 0xf};
+    pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+    m_translucentPipeline = std::make_unique<Pipeline>(m_device, "shaders/vert.spv", "shaders/frag.spv", pipelineConfig);
+}
+
+void VulkanEngine::createCompositePipeline() {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutCreateInfo layoutInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &m_compositeSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create composite descriptor set layout!");
+
+    // Квад слоя целиком в push-константах: прямоугольник на экране, uv, размер кадра и прозрачность
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_compositeSetLayout;
+    VkPushConstantRange quadRange{VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, 12 * sizeof(float)};
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &quadRange;
+    if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_compositeLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create composite pipeline layout!");
+
+    PipelineConfigInfo pipelineConfig{};
+    // Вершинного входа нет: углы квада берутся из gl_VertexIndex
+    pipelineConfig.inputAssemblyInfo = {VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, nullptr, 0, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE};
+    pipelineConfig.viewportInfo = {VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO, nullptr, 0, 1, nullptr, 1, nullptr};
+    pipelineConfig.rasterizationInfo = {VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO, nullptr, 0, VK_FALSE, VK_FALSE, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE, VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f};
+    pipelineConfig.multisampleInfo = {VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, nullptr, 0, VK_SAMPLE_COUNT_1_BIT, VK_FALSE, 1.0f, nullptr, VK_FALSE, VK_FALSE};
+    // Изображения слоёв хранят цвет с предумноженной альфой
+    pipelineConfig.colorBlendAttachment = {VK_TRUE, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD, 0xf};
+    pipelineConfig.colorBlendInfo = {VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, nullptr, 0, VK_FALSE, VK_LOGIC_OP_COPY, 1, &pipelineConfig.colorBlendAttachment, {0.0f, 0.0f, 0.0f, 0.0f}};
+    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    pipelineConfig.dynamicStateInfo = {VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO, nullptr, 0, static_cast<uint32_t>(dynamicStates.size()), dynamicStates.data()};
+    pipelineConfig.pipelineLayout = m_compositeLayout;
     pipelineConfig.renderPass = m_renderPass;
     pipelineConfig.subpass = 0;
-    m_pipeline = std::make_unique<Pipeline>(m_device, "shaders/vert.spv", "shaders/frag.spv", pipelineConfig);
+    m_compositePipeline = std::make_unique<Pipeline>(m_device, "shaders/composite_vert.spv", "shaders/composite_frag.spv", pipelineConfig);
+    Log::info("Composite pipeline created.");
+}
+
+void VulkanEngine::createCullPipeline() {
+    VkDescriptorSetLayoutBinding bindings[4]{};
+    for (uint32_t i = 0; i < 4; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layoutInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layoutInfo.bindingCount = 4;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &m_cullSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create cull descriptor set layout!");
+
+    // Перерисовываемая область в координатах документа и диапазон списка отрисовки
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_cullSetLayout;
+    VkPushConstantRange cullRange{VK_SHADER_STAGE_COMPUTE_BIT, 0, 4 * sizeof(float) + 4 * sizeof(uint32_t)};
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &cullRange;
+    if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_cullLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create cull pipeline layout!");
+
+    m_cullPipeline = std::make_unique<ComputePipeline>(m_device, "shaders/cull.spv", m_cullLayout);
+    Log::info("Cull pipeline created.");
+}
+
+void VulkanEngine::createHudPipeline() {
+    // Дескрипторов нет: прямоугольники и цвета приходят вершинным входом, размер кадра — константой
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    VkPushConstantRange viewportRange{VK_SHADER_STAGE_VERTEX_BIT, 0, 2 * sizeof(float)};
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &viewportRange;
+    if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_hudLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create HUD pipeline layout!");
+
+    PipelineConfigInfo pipelineConfig{};
+    pipelineConfig.bindingDescriptions = {{0, sizeof(HudRect), VK_VERTEX_INPUT_RATE_INSTANCE}};
+    pipelineConfig.attributeDescriptions = {{0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(HudRect, rect)},
+                                            {1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(HudRect, color)}};
+    pipelineConfig.inputAssemblyInfo = {VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, nullptr, 0, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE};
+    pipelineConfig.viewportInfo = {VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO, nullptr, 0, 1, nullptr, 1, nullptr};
+    pipelineConfig.rasterizationInfo = {VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO, nullptr, 0, VK_FALSE, VK_FALSE, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE, VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f};
+    pipelineConfig.multisampleInfo = {VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, nullptr, 0, VK_SAMPLE_COUNT_1_BIT, VK_FALSE, 1.0f, nullptr, VK_FALSE, VK_FALSE};
+    pipelineConfig.colorBlendAttachment = {VK_TRUE, VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD, 0xf};
+    pipelineConfig.colorBlendInfo = {VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, nullptr, 0, VK_FALSE, VK_LOGIC_OP_COPY, 1, &pipelineConfig.colorBlendAttachment, {0.0f, 0.0f, 0.0f, 0.0f}};
+    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    pipelineConfig.dynamicStateInfo = {VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO, nullptr, 0, static_cast<uint32_t>(dynamicStates.size()), dynamicStates.data()};
+    pipelineConfig.pipelineLayout = m_hudLayout;
+    pipelineConfig.renderPass = m_renderPass;
+    pipelineConfig.subpass = 0;
+    m_hudPipeline = std::make_unique<Pipeline>(m_device, "shaders/hud_vert.spv", "shaders/hud_frag.spv", pipelineConfig);
+
+    // Буфер на каждый кадр в полёте: кадр пишет свои прямоугольники, пока GPU читает прошлые
+    m_hudBuffers.clear();
+    for (uint32_t i = 0; i < m_config.framesInFlight; ++i) {
+        m_hudBuffers.push_back(std::make_unique<GpuBuffer>(m_physicalDevice, m_device, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 1024 * sizeof(HudRect)));
+    }
+    Log::info("HUD pipeline created.");
+}
+
+void VulkanEngine::createQueryPool() {
+    m_queriesWritten.assign(m_config.framesInFlight, false);
+    // Очередь без меток времени оставляет оверлей без времени GPU
+    QueueFamilyIndices indices = findQueueFamilies(m_physicalDevice);
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &count, queueFamilies.data());
+    uint32_t validBits = queueFamilies[indices.graphicsFamily.value()].timestampValidBits;
+    if (validBits == 0) {
+        Log::warn("Graphics queue has no timestamps; the overlay shows no GPU time.");
+        return;
+    }
+    m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    m_timestampPeriod = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = 2 * m_config.framesInFlight;
+    if (vkCreateQueryPool(m_device, &poolInfo, nullptr, &m_queryPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create timestamp query pool!");
 }
 
 void VulkanEngine::createFramebuffers() {
@@ -349,8 +1484,64 @@ void VulkanEngine::createCommandPool() {
     Log::info("Command pool created.");
 }
 
+void VulkanEngine::createGlyphAtlas() {
+    m_textPainter = std::make_unique<TextPainter>();
+    m_glyphTexture = std::make_unique<Texture>(m_physicalDevice, m_device, GlyphAtlas::SIZE, GlyphAtlas::SIZE, VK_FORMAT_R8_UNORM);
+    // Первая загрузка целиком переводит изображение в режим чтения шейдером
+    m_glyphTexture->upload(m_commandPool, m_graphicsQueue, m_textPainter->atlas().pixels().data(), 0, GlyphAtlas::SIZE);
+    Log::info("Glyph atlas created.");
+}
+
+void VulkanEngine::createDescriptorPool() {
+    // На слой три набора: содержимое (атлас + экземпляры), его изображение для сборки кадра
+    // и четыре буфера отсечения. Заменённые наборы ждут забора, пока кадры в полёте их читают:
+    // на каждый кадр в полёте — ещё столько же
+    const uint32_t layers = static_cast<uint32_t>(LayerTree::MAX_LAYERS) * (1 + m_config.framesInFlight);
+    VkDescriptorPoolSize poolSizes[] = {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 * layers}, {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5 * layers}};
+    VkDescriptorPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.maxSets = 3 * layers;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create descriptor pool!");
+    Log::info("Descriptor pool created.");
+}
+
+// Пишется в новый набор и после роста буфера экземпляров: дескриптор указывает на конкретный VkBuffer
+void VulkanEngine::writeContentDescriptor(GpuLayer& layer) {
+    VkDescriptorImageInfo imageInfo{m_glyphTexture->sampler(), m_glyphTexture->imageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkDescriptorBufferInfo bufferInfo{layer.instanceBuffer->handle(), 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet writes[2]{{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}, {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}};
+    writes[0].dstSet = layer.contentSet;
+    writes[0].dstBinding = 0;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].descriptorCount = 1;
+    writes[0].pImageInfo = &imageInfo;
+    writes[1].dstSet = layer.contentSet;
+    writes[1].dstBinding = 1;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[1].descriptorCount = 1;
+    writes[1].pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(m_device, 2, writes, 0, nullptr);
+}
+
+void VulkanEngine::writeCullDescriptor(GpuLayer& layer) {
+    VkDescriptorBufferInfo bufferInfos[4] = {{layer.instanceBuffer->handle(), 0, VK_WHOLE_SIZE},
+                                             {layer.drawBuffer->handle(), 0, VK_WHOLE_SIZE},
+                                             {layer.visibleBuffer->handle(), 0, VK_WHOLE_SIZE},
+                                             {layer.indirectBuffer->handle(), 0, VK_WHOLE_SIZE}};
+    VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet = layer.cullSet;
+    write.dstBinding = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 4;
+    write.pBufferInfo = bufferInfos;
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+}
+
 void VulkanEngine::createCommandBuffers() {
-    m_commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    m_commandBuffers.resize(m_config.framesInFlight);
     VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
     allocInfo.commandPool = m_commandPool;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -360,13 +1551,40 @@ void VulkanEngine::createCommandBuffers() {
     Log::info("Command buffers allocated.");
 }
 
+void VulkanEngine::createRecordContexts() {
+    // Записи слоёв хватает половины ядер: остальные заняты потоком документа и его компоновкой
+    m_recordPool = std::make_unique<ThreadPool>(std::max(1u, std::thread::hardware_concurrency() / 2));
+    QueueFamilyIndices queueFamilyIndices = findQueueFamilies(m_physicalDevice);
+    VkCommandPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+    m_recordContexts.resize(m_config.framesInFlight);
+    for (auto& frame : m_recordContexts) {
+        frame.resize(m_recordPool->size() + 1);
+        for (RecordContext& context : frame) {
+            if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &context.pool) != VK_SUCCESS)
+                throw std::runtime_error("failed to create recording command pool!");
+        }
+    }
+    Log::info("Recording command pools created for " + std::to_string(m_recordPool->size() + 1) + " threads.");
+}
+
+void VulkanEngine::createUploads() {
+    // Промежуточный буфер слота растёт под самое большое обновление; обычное — единицы килобайт
+    const VkDeviceSize STAGING_CAPACITY = 256 * 1024;
+    m_uploads.resize(m_config.framesInFlight);
+    for (FrameUploads& frame : m_uploads) {
+        frame.staging = std::make_unique<GpuBuffer>(m_physicalDevice, m_device, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, STAGING_CAPACITY);
+    }
+}
+
 void VulkanEngine::createSyncObjects() {
-    m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    m_imageAvailableSemaphores.resize(m_config.framesInFlight);
+    m_renderFinishedSemaphores.resize(m_config.framesInFlight);
+    m_inFlightFences.resize(m_config.framesInFlight);
     VkSemaphoreCreateInfo semaphoreInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
     VkFenceCreateInfo fenceInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, VK_FENCE_CREATE_SIGNALED_BIT};
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < m_config.framesInFlight; i++) {
         if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
             vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
             vkCreateFence(m_device, &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS)
@@ -433,7 +1651,13 @@ VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>
     }
     return formats[0];
 }
-VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& modes) {
+VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& modes, std::optional<VkPresentModeKHR> requested) {
+    // FIFO поддерживается всегда — на него откатывается и неподдерживаемый запрошенный режим
+    if (requested) {
+        if (std::find(modes.begin(), modes.end(), *requested) != modes.end()) return *requested;
+        Log::warn("Requested present mode is not supported by the surface, falling back to FIFO.");
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
     for (const auto& mode : modes) {
         if (mode == VK_PRESENT_MODE_MAILBOX_KHR) return mode;
     }
@@ -0,0 +1,53 @@
+#include "X11Blitter.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#define GLFW_EXPOSE_NATIVE_X11
+#include <GLFW/glfw3native.h>
+#include <X11/Xutil.h>
+
+X11Blitter::X11Blitter(GLFWwindow* window) {
+    Display* display = glfwGetX11Display();
+    Window handle = glfwGetX11Window(window);
+    if (!display || !handle) throw std::runtime_error("software backend requires an X11 window");
+    XWindowAttributes attributes;
+    XGetWindowAttributes(display, handle, &attributes);
+    if (attributes.depth != 24 && attributes.depth != 32)
+        throw std::runtime_error("software backend requires a 24- or 32-bit X11 visual");
+    m_display = display;
+    m_window = handle;
+    m_visual = attributes.visual;
+    m_depth = attributes.depth;
+    m_swapRedBlue = attributes.visual->red_mask != 0xFF;
+    m_gc = XCreateGC(display, handle, 0, nullptr);
+    Log::info("X11 blit target created.");
+}
+
+X11Blitter::~X11Blitter() {
+    if (m_gc) XFreeGC(static_cast<Display*>(m_display), static_cast<GC>(m_gc));
+}
+
+void X11Blitter::present(const std::vector<uint32_t>& pixels, uint32_t width, uint32_t height) {
+    m_pixels.resize(pixels.size());
+    if (m_swapRedBlue) {
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            uint32_t p = pixels[i];
+            m_pixels[i] = (p & 0xFF00FF00u) | ((p & 0xFFu) << 16) | ((p >> 16) & 0xFFu);
+        }
+    } else {
+        std::copy(pixels.begin(), pixels.end(), m_pixels.begin());
+    }
+
+    Display* display = static_cast<Display*>(m_display);
+    XImage* image = XCreateImage(display, static_cast<Visual*>(m_visual), m_depth, ZPixmap, 0,
+                                 reinterpret_cast<char*>(m_pixels.data()), width, height, 32, 0);
+    if (!image) throw std::runtime_error("failed to create X11 image!");
+    XPutImage(display, m_window, static_cast<GC>(m_gc), image, 0, 0, 0, 0, width, height);
+    image->data = nullptr; // Память принадлежит m_pixels
+    XDestroyImage(image);
+    XFlush(display);
+}
@@ -0,0 +1,290 @@
+#include "document/Document.hpp"
+#include "parser/HtmlTokenizer.hpp"
+#include "parser/HtmlParser.hpp"
+#include "parser/CssParser.hpp"
+#include "parser/StyleApplier.hpp"
+#include "utils/MemoryTracker.hpp"
+#include "utils/StartupTimeline.hpp"
+#include "utils/Trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+Document::Document(const std::string& htmlContent, const std::string& cssContent) {
+    std::vector<Token> tokens;
+    {
+        StartupTimeline::Phase phase("document", "tokenize");
+        tokens = HtmlTokenizer(htmlContent).tokenize();
+    }
+    {
+        StartupTimeline::Phase phase("document", "parse html");
+        m_domRoot = HtmlParser(tokens).parse();
+    }
+    {
+        StartupTimeline::Phase phase("document", "parse css");
+        m_stylesheet = CssParser(cssContent).parse();
+        m_invalidationSet = InvalidationSet(m_stylesheet);
+    }
+    StartupTimeline::Phase phase("document", "style");
+    TRACE_ZONE("style");
+    MemoryTracker::Scope memory(MemoryStage::STYLE);
+    m_styleRoot = StyleApplier::applyStyles(*m_domRoot, m_stylesheet);
+    registerSubtree(*m_styleRoot);
+}
+
+StyledNode* Document::styledNodeFor(const DomNode& node) const {
+    auto it = m_styledNodes.find(&node);
+    return it != m_styledNodes.end() ? it->second : nullptr;
+}
+
+DomNode* Document::getElementById(const std::string& id) const {
+    std::vector<DomNode*> stack = {m_domRoot.get()};
+    while (!stack.empty()) {
+        DomNode* node = stack.back();
+        stack.pop_back();
+        auto it = node->attributes.find("id");
+        if (it != node->attributes.end() && it->second == id) return node;
+        for (auto& child : node->children) stack.push_back(child.get());
+    }
+    return nullptr;
+}
+
+void Document::setAttribute(DomNode& node, const std::string& name, const std::string& value) {
+    auto it = node.attributes.find(name);
+    std::string oldValue = it != node.attributes.end() ? it->second : "";
+    if (it != node.attributes.end() && oldValue == value) return;
+    node.attributes[name] = value;
+    invalidateAttribute(node, name, oldValue, value);
+}
+
+void Document::removeAttribute(DomNode& node, const std::string& name) {
+    auto it = node.attributes.find(name);
+    if (it == node.attributes.end()) return;
+    std::string oldValue = std::move(it->second);
+    node.attributes.erase(it);
+    invalidateAttribute(node, name, oldValue, "");
+}
+
+void Document::toggleClass(DomNode& node, const std::string& className) {
+    auto it = node.attributes.find("class");
+    std::vector<std::string> classes = it != node.attributes.end() ? splitClasses(it->second) : std::vector<std::string>{};
+    auto pos = std::find(classes.begin(), classes.end(), className);
+    if (pos != classes.end()) classes.erase(pos);
+    else classes.push_back(className);
+
+    std::string value;
+    for (const auto& c : classes) {
+        if (!value.empty()) value += ' ';
+        value += c;
+    }
+    setAttribute(node, "class", value);
+}
+
+DomNode& Document::insertChild(DomNode& parent, std::unique_ptr<DomNode> child, size_t index) {
+    StyledNode* styledParent = styledNodeFor(parent);
+    if (!styledParent) throw std::runtime_error("insertChild: parent is not part of this document");
+    index = std::min(index, parent.children.size());
+
+    DomNode& inserted = *child;
+    child->parent = &parent;
+    parent.children.insert(parent.children.begin() + index, std::move(child));
+
+    // Новое поддерево стилизуется целиком — его узлы ещё нигде не закэшированы
+    MemoryTracker::Scope memory(MemoryStage::STYLE);
+    auto styledChild = StyleApplier::applyStyles(inserted, m_stylesheet);
+    styledChild->parent = styledParent;
+    registerSubtree(*styledChild);
+    styledParent->children.insert(styledParent->children.begin() + index, std::move(styledChild));
+
+    if (!(styledParent->dirty & STYLE_DIRTY_CHILDREN)) {
+        styledParent->dirty |= STYLE_DIRTY_CHILDREN;
+        m_pending.childrenChanged.push_back(styledParent);
+    }
+    return inserted;
+}
+
+DomNode& Document::appendChild(DomNode& parent, std::unique_ptr<DomNode> child) {
+    return insertChild(parent, std::move(child), parent.children.size());
+}
+
+std::unique_ptr<DomNode> Document::removeChild(DomNode& parent, DomNode& child) {
+    auto it = std::find_if(parent.children.begin(), parent.children.end(),
+                           [&](const std::unique_ptr<DomNode>& c) { return c.get() == &child; });
+    if (it == parent.children.end()) throw std::runtime_error("removeChild: node is not a child of parent");
+    size_t index = static_cast<size_t>(it - parent.children.begin());
+
+    StyledNode* styledParent = styledNodeFor(parent);
+    if (!styledParent) throw std::runtime_error("removeChild: parent is not part of this document");
+    std::unique_ptr<StyledNode> styledChild = std::move(styledParent->children[index]);
+    styledParent->children.erase(styledParent->children.begin() + index);
+
+    // Узлы удалённого поддерева не должны остаться в очередях на пересчёт
+    std::unordered_set<const StyledNode*> removed;
+    std::vector<const StyledNode*> stack = {styledChild.get()};
+    while (!stack.empty()) {
+        const StyledNode* node = stack.back();
+        stack.pop_back();
+        removed.insert(node);
+        for (const auto& c : node->children) stack.push_back(c.get());
+    }
+    auto isRemoved = [&](StyledNode* node) { return removed.count(node) != 0; };
+    for (auto* list : {&m_pendingRestyle, &m_pending.layoutDirty, &m_pending.paintDirty, &m_pending.childrenChanged,
+                       &m_pending.compositeDirty, &m_pending.textChanged}) {
+        list->erase(std::remove_if(list->begin(), list->end(), isRemoved), list->end());
+    }
+    unregisterSubtree(*styledChild);
+    m_detachedStyles.push_back(std::move(styledChild));
+
+    if (!(styledParent->dirty & STYLE_DIRTY_CHILDREN)) {
+        styledParent->dirty |= STYLE_DIRTY_CHILDREN;
+        m_pending.childrenChanged.push_back(styledParent);
+    }
+
+    std::unique_ptr<DomNode> detached = std::move(*it);
+    parent.children.erase(it);
+    detached->parent = nullptr;
+
+    if (!m_listeners.empty()) {
+        std::vector<const DomNode*> domStack = {detached.get()};
+        while (!domStack.empty()) {
+            const DomNode* node = domStack.back();
+            domStack.pop_back();
+            m_listeners.erase(node);
+            for (const auto& c : node->children) domStack.push_back(c.get());
+        }
+    }
+    return detached;
+}
+
+void Document::addEventListener(DomNode& node, EventType type, EventListener listener) {
+    m_listeners[&node].emplace_back(type, std::move(listener));
+}
+
+void Document::dispatchEvent(Event& event) {
+    for (DomNode* node = event.target; node && !event.propagationStopped; node = node->parent) {
+        auto it = m_listeners.find(node);
+        if (it == m_listeners.end()) continue;
+        event.currentTarget = node;
+        // Копия: слушатель может добавить новых слушателей этому же узлу
+        auto listeners = it->second;
+        for (auto& [type, listener] : listeners) {
+            if (type == event.type) listener(event);
+        }
+    }
+    event.currentTarget = nullptr;
+}
+
+void Document::setText(DomNode& textNode, const std::string& text) {
+    if (textNode.type != NodeType::TEXT_NODE) throw std::runtime_error("setText: node is not a text node");
+    if (textNode.value == text) return;
+    auto blank = [](const std::string& value) { return value.find_first_not_of(" \t\n\r") == std::string::npos; };
+    bool hadBox = !blank(textNode.value), hasBox = !blank(text);
+    textNode.value = text;
+
+    // Пробельный текст бокса не получает: узел появился в дереве боксов или исчез из него
+    if (hadBox != hasBox) {
+        StyledNode* styledParent = textNode.parent ? styledNodeFor(*textNode.parent) : nullptr;
+        if (styledParent && !(styledParent->dirty & STYLE_DIRTY_CHILDREN)) {
+            styledParent->dirty |= STYLE_DIRTY_CHILDREN;
+            m_pending.childrenChanged.push_back(styledParent);
+        }
+        return;
+    }
+    // Иначе бокс остаётся на месте — перемерить нужно только его слова
+    StyledNode* styled = hasBox ? styledNodeFor(textNode) : nullptr;
+    if (styled && !(styled->dirty & STYLE_DIRTY_TEXT)) {
+        styled->dirty |= STYLE_DIRTY_TEXT;
+        m_pending.textChanged.push_back(styled);
+    }
+}
+
+StyleUpdate Document::updateStyles() {
+    TRACE_ZONE("style");
+    MemoryTracker::Scope memory(MemoryStage::STYLE);
+    m_retiredStyles = std::move(m_detachedStyles);
+    m_detachedStyles.clear();
+
+    for (StyledNode* node : m_pendingRestyle) {
+        PropertyMap newValues = m_invalidationSet.computeStyle(node->domNode, m_stylesheet);
+        m_pending.restyledNodes++;
+
+        // Определяем минимальную «грязность»: меняется ли геометрия или только цвет
+        bool layoutChanged = false;
+        bool paintChanged = false;
+        bool compositeChanged = false;
+        auto classify = [&](const std::string& property) {
+            if (InvalidationSet::isPaintOnlyProperty(property)) paintChanged = true;
+            else if (InvalidationSet::isCompositeOnlyProperty(property)) compositeChanged = true;
+            else layoutChanged = true;
+        };
+        for (const auto& [property, value] : newValues) {
+            auto old = node->specifiedValues.find(property);
+            if (old == node->specifiedValues.end() || old->second != value) classify(property);
+        }
+        for (const auto& [property, value] : node->specifiedValues) {
+            if (newValues.find(property) == newValues.end()) classify(property);
+        }
+
+        node->specifiedValues = std::move(newValues);
+        node->dirty &= ~STYLE_DIRTY_STYLE;
+        if (layoutChanged && !(node->dirty & STYLE_DIRTY_LAYOUT)) {
+            node->dirty |= STYLE_DIRTY_LAYOUT;
+            m_pending.layoutDirty.push_back(node);
+        } else if (paintChanged && !(node->dirty & (STYLE_DIRTY_LAYOUT | STYLE_DIRTY_PAINT))) {
+            node->dirty |= STYLE_DIRTY_PAINT;
+            m_pending.paintDirty.push_back(node);
+        } else if (compositeChanged && !(node->dirty & (STYLE_DIRTY_LAYOUT | STYLE_DIRTY_PAINT | STYLE_DIRTY_COMPOSITE))) {
+            // Перерисовка слоёв и так перечитывает transform и opacity — отдельно отмечаем только без неё
+            node->dirty |= STYLE_DIRTY_COMPOSITE;
+            m_pending.compositeDirty.push_back(node);
+        }
+    }
+    m_pendingRestyle.clear();
+
+    StyleUpdate update = std::move(m_pending);
+    m_pending = StyleUpdate{};
+    for (auto* list : {&update.layoutDirty, &update.paintDirty, &update.childrenChanged, &update.compositeDirty,
+                       &update.textChanged}) {
+        for (StyledNode* node : *list) node->dirty = STYLE_CLEAN;
+    }
+    return update;
+}
+
+void Document::invalidateAttribute(DomNode& node, const std::string& name,
+                                   const std::string& oldValue, const std::string& newValue) {
+    StyledNode* styled = styledNodeFor(node);
+    if (!styled) return;
+
+    bool affected = false;
+    if (name == "class") {
+        // Пересчитываем стиль, только если изменившийся класс упоминается в таблице стилей
+        auto oldClasses = splitClasses(oldValue);
+        auto newClasses = splitClasses(newValue);
+        for (const auto& c : oldClasses) {
+            if (std::find(newClasses.begin(), newClasses.end(), c) == newClasses.end() && m_invalidationSet.dependsOnClass(c)) affected = true;
+        }
+        for (const auto& c : newClasses) {
+            if (std::find(oldClasses.begin(), oldClasses.end(), c) == oldClasses.end() && m_invalidationSet.dependsOnClass(c)) affected = true;
+        }
+    } else if (name == "id") {
+        affected = m_invalidationSet.dependsOnId(oldValue) || m_invalidationSet.dependsOnId(newValue);
+    }
+    if (affected) scheduleRestyle(*styled);
+}
+
+void Document::scheduleRestyle(StyledNode& node) {
+    if (node.dirty & STYLE_DIRTY_STYLE) return;
+    node.dirty |= STYLE_DIRTY_STYLE;
+    m_pendingRestyle.push_back(&node);
+}
+
+void Document::registerSubtree(StyledNode& node) {
+    m_styledNodes[&node.domNode] = &node;
+    for (auto& child : node.children) registerSubtree(*child);
+}
+
+void Document::unregisterSubtree(const StyledNode& node) {
+    m_styledNodes.erase(&node.domNode);
+    for (const auto& child : node.children) unregisterSubtree(*child);
+}
@@ -0,0 +1,255 @@
+#include "document/DocumentWorker.hpp"
+#include "document/Document.hpp"
+#include "document/PointerDispatcher.hpp"
+#include "layout/LayoutEngine.hpp"
+#include "layout/SpatialIndex.hpp"
+#include "utils/StartupTimeline.hpp"
+#include "utils/ThreadPool.hpp"
+#include "utils/Trace.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+DocumentWorker::DocumentWorker(std::string htmlContent, std::string cssContent, float width, float height)
+    : m_width(width), m_height(height) {
+    m_thread = std::thread([this, html = std::move(htmlContent), css = std::move(cssContent)] { run(html, css); });
+}
+
+DocumentWorker::~DocumentWorker() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+    // Указатель ссылается на документ и индекс — уходит первым
+    m_pointer.reset();
+    m_layers.reset();
+    m_spatialIndex.reset();
+    m_layoutEngine.reset();
+    m_threadPool.reset();
+    m_document.reset();
+}
+
+void DocumentWorker::post(DocumentTask task) {
+    Command command{Command::Kind::TASK};
+    command.task = std::move(task);
+    push(std::move(command));
+}
+
+void DocumentWorker::scrollTo(float y, float scrollAnchor) {
+    Command command{Command::Kind::SCROLL};
+    command.y = y;
+    command.scrollAnchor = scrollAnchor;
+    push(std::move(command));
+}
+
+void DocumentWorker::pointerMoved(float x, float y) {
+    Command command{Command::Kind::POINTER_MOVE};
+    command.x = x;
+    command.y = y;
+    push(std::move(command));
+}
+
+void DocumentWorker::pointerButton(int button, bool pressed) {
+    Command command{Command::Kind::POINTER_BUTTON};
+    command.button = button;
+    command.pressed = pressed;
+    push(std::move(command));
+}
+
+void DocumentWorker::pointerLeft() {
+    push(Command{Command::Kind::POINTER_LEAVE});
+}
+
+void DocumentWorker::push(Command command) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.push_back(std::move(command));
+    }
+    m_condition.notify_one();
+}
+
+void DocumentWorker::checkFailure() {
+    if (!m_failed.load(std::memory_order_acquire)) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    throw std::runtime_error("document worker failed: " + m_failure);
+}
+
+void DocumentWorker::waitIdle() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [&] { return (!m_busy && m_commands.empty()) || !m_failure.empty(); });
+}
+
+void DocumentWorker::run(const std::string& htmlContent, const std::string& cssContent) {
+    TRACE_THREAD("document");
+    try {
+        build(htmlContent, cssContent);
+        bool pending = false;
+        while (true) {
+            std::vector<Command> commands;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_busy = false;
+                m_idleCondition.notify_all();
+                // Слушатели событий могли снова изменить документ — тогда не ждём новых команд
+                m_condition.wait(lock, [&] { return m_stopping || pending || !m_commands.empty(); });
+                if (m_stopping) return;
+                commands.swap(m_commands);
+                m_busy = true;
+            }
+            // Пачка команд превращается в один снимок: промежуточные состояния отрисовке не нужны
+            TRACE_ZONE("document update");
+            for (Command& command : commands) apply(command);
+            update();
+            pending = m_document->hasPendingChanges();
+        }
+    } catch (const std::exception& e) {
+        Log::error(std::string("Document worker stopped: ") + e.what());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_failure = e.what();
+        m_failed.store(true, std::memory_order_release);
+        m_idleCondition.notify_all();
+    }
+}
+
+void DocumentWorker::build(const std::string& htmlContent, const std::string& cssContent) {
+    Log::info("--- Building document ---");
+    m_document = std::make_unique<Document>(htmlContent, cssContent);
+    m_threadPool = std::make_unique<ThreadPool>();
+    m_layoutEngine = std::make_unique<LayoutEngine>();
+    m_layoutEngine->setThreadPool(m_threadPool.get());
+    m_layoutEngine->setViewport(m_width, m_height);
+    // Длинные документы компонуются лениво: детально только видимая область и запас вокруг.
+    // Растр слоя заходит за экран на его высоту — запас компоновки не меньше
+    m_layoutEngine->setLazyLayout(true, std::max(1000.0f, m_height));
+    m_spatialIndex = std::make_unique<SpatialIndex>();
+    m_pointer = std::make_unique<PointerDispatcher>(*m_document, *m_spatialIndex);
+    m_layers = std::make_unique<LayerTree>();
+    m_pointer->setLayers(m_layers.get());
+    {
+        StartupTimeline::Phase phase("document", "layout");
+        m_layoutEngine->build(m_document->styleRoot());
+        const LayoutStats& stats = m_layoutEngine->relayout();
+        Log::infof("Initial layout: %zu boxes laid out, %zu off-screen subtrees estimated.", stats.boxesLaidOut, stats.boxesEstimated);
+    }
+    {
+        StartupTimeline::Phase phase("document", "layers");
+        m_layers->update(m_layoutEngine->tree(), viewport());
+        const LayerPaintStats& paint = m_layers->paint(m_layoutEngine->tree(), viewport(), true);
+        Log::infof("Layers: %zu, display list %zu -> %zu rects after overdraw culling.", paint.layers, paint.commandsBefore,
+                   paint.commandsAfter);
+    }
+    StartupTimeline::Phase phase("document", "hit test index");
+    const Rect& hitArea = m_layers->layers().front().raster;
+    m_spatialIndex->update(buildDisplayList(m_layoutEngine->tree(), hitArea), hitArea);
+    publish();
+}
+
+void DocumentWorker::apply(Command& command) {
+    switch (command.kind) {
+        case Command::Kind::TASK:
+            command.task(*m_document);
+            break;
+        case Command::Kind::SCROLL: {
+            // Отрисовка могла ещё не учесть последние сдвиги якорения — добавляем недостающие
+            float y = std::max(0.0f, command.y + m_scrollAnchor - command.scrollAnchor);
+            if (y != m_scrollY) {
+                m_scrollY = y;
+                m_scrollChanged = true;
+                m_pointer->setScrollOffset(m_scrollY);
+            }
+            break;
+        }
+        case Command::Kind::POINTER_MOVE:   m_pointer->moved(command.x, command.y); break;
+        case Command::Kind::POINTER_BUTTON: m_pointer->button(command.button, command.pressed); break;
+        case Command::Kind::POINTER_LEAVE:  m_pointer->left(); break;
+    }
+}
+
+Rect DocumentWorker::viewport() const {
+    return {0.0f, m_scrollY, m_width, m_height};
+}
+
+namespace {
+
+float elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+void DocumentWorker::update() {
+    auto start = std::chrono::steady_clock::now();
+    StyleUpdate update = m_document->updateStyles();
+    if (!update.needsPaint() && !update.needsComposite() && !m_scrollChanged) return;
+    m_scrollChanged = false;
+    m_styleMs = elapsedMs(start);
+    m_layoutMs = m_paintMs = 0.0f;
+
+    // Сдвиг и прозрачность меняют только размещение изображения слоя; элементу без слоя он нужен
+    bool layersChanged = false;
+    for (StyledNode* node : update.compositeDirty) layersChanged |= !m_layers->ownsLayer(node);
+    if (update.needsComposite()) m_layers->updateProperties();
+
+    // Прокрутка в пределах растров слоёв обходится без снимка: слои сдвигает поток отрисовки
+    bool repaint = update.needsPaint() || layersChanged || m_layers->needsRaster(viewport());
+    if (repaint) {
+        // Изменения только цвета не требуют перекомпоновки — переиспользуем дерево боксов
+        for (StyledNode* node : update.paintDirty) m_layoutEngine->styleChanged(*node);
+        for (StyledNode* node : update.childrenChanged) m_layoutEngine->rebuildChildren(*node);
+        for (StyledNode* node : update.textChanged) m_layoutEngine->textChanged(*node);
+        for (StyledNode* node : update.layoutDirty) m_layoutEngine->styleChanged(*node);
+
+        // Досчитываются поддеревья, вошедшие в окно; без изменений проход почти бесплатен
+        auto layoutStart = std::chrono::steady_clock::now();
+        m_layoutEngine->setScrollOffset(m_scrollY);
+        const LayoutStats& stats = m_layoutEngine->relayout();
+        if (stats.scrollAnchorShift != 0.0f) {
+            // Контент над экраном сменил оценочную высоту на настоящую — держим видимое на месте
+            float scrollY = std::max(0.0f, m_scrollY + stats.scrollAnchorShift);
+            m_scrollAnchor += scrollY - m_scrollY;
+            m_scrollY = scrollY;
+            m_layoutEngine->setScrollOffset(m_scrollY);
+            m_pointer->setScrollOffset(m_scrollY);
+        }
+        // Строки на каждое обновление — только в отладочном журнале
+        if (update.needsLayout()) {
+            Log::debugf("Relayout: %zu boxes laid out, %zu subtrees reused.", stats.boxesLaidOut, stats.subtreesReused);
+        }
+        bool contentChanged = update.needsPaint() || layersChanged || stats.boxesLaidOut > 0 || stats.scrollAnchorShift != 0.0f;
+        m_layoutMs = elapsedMs(layoutStart);
+        auto paintStart = std::chrono::steady_clock::now();
+        m_layers->update(m_layoutEngine->tree(), viewport());
+        const LayerPaintStats& paint = m_layers->paint(m_layoutEngine->tree(), viewport(), contentChanged);
+        m_paintMs = elapsedMs(paintStart);
+        if (update.needsPaint()) {
+            Log::debugf("Layers: %zu of %zu repainted.", paint.repainted, paint.layers);
+        }
+
+        // Индекс попаданий видит все боксы растра корневого слоя: прокрутка до следующей перерисовки остаётся в нём
+        TRACE_ZONE("hit test index");
+        const Rect& hitArea = m_layers->layers().front().raster;
+        m_spatialIndex->update(buildDisplayList(m_layoutEngine->tree(), hitArea), hitArea);
+    }
+    if (repaint || update.needsComposite()) publish();
+    // Под неподвижным указателем мог оказаться другой элемент
+    m_pointer->refresh();
+}
+
+void DocumentWorker::publish() {
+    TRACE_ZONE("publish");
+    DocumentSnapshot& snapshot = m_snapshots.back();
+    snapshot.version = ++m_version;
+    snapshot.scrollY = m_scrollY;
+    snapshot.scrollAnchor = m_scrollAnchor;
+    snapshot.documentHeight = m_layoutEngine->documentHeight();
+    snapshot.layers = m_layers->layers();
+    snapshot.styleMs = m_styleMs;
+    snapshot.layoutMs = m_layoutMs;
+    snapshot.paintMs = m_paintMs;
+    m_snapshots.publish();
+}
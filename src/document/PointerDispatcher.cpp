@@ -0,0 +1,76 @@
+#include "document/PointerDispatcher.hpp"
+#include "document/Document.hpp"
+#include "layout/SpatialIndex.hpp"
+#include "render/LayerTree.hpp"
+
+DomNode* PointerDispatcher::elementAt(float x, float y) {
+    if (!m_layers || m_layers->layers().size() < 2) {
+        m_index.hitTest(x, y + m_scrollY, m_hits);
+        return firstHit(0);
+    }
+    // Слои композитятся от заднего к переднему: первым спрашиваем верхний, точку сдвигаем
+    // в координаты его содержимого
+    const std::vector<Layer>& layers = m_layers->layers();
+    for (size_t i = layers.size(); i-- > 0;) {
+        m_index.hitTest(x - layers[i].composed.translateX, y + m_scrollY - layers[i].composed.translateY, m_hits);
+        if (DomNode* element = firstHit(i)) return element;
+    }
+    return nullptr;
+}
+
+DomNode* PointerDispatcher::firstHit(size_t layer) const {
+    for (const DisplayKey& key : m_hits) {
+        // Индекс построен в прошлом кадре: узел с тех пор мог быть удалён из документа
+        const DomNode& node = key.node->domNode;
+        if (m_document.styledNodeFor(node) != key.node) continue;
+        if (m_layers && m_layers->layerOf(key.node) != layer) continue;
+        // Строка текста адресует событие своему элементу
+        const DomNode* element = node.type == NodeType::TEXT_NODE ? node.parent : &node;
+        if (element) return const_cast<DomNode*>(element); // Документ владеет узлами как изменяемыми
+    }
+    return nullptr;
+}
+
+void PointerDispatcher::dispatch(EventType type, DomNode* target, int button) {
+    if (!target) return;
+    Event event{type};
+    event.target = target;
+    event.x = m_x;
+    event.y = m_y + m_scrollY;
+    event.button = button;
+    m_document.dispatchEvent(event);
+}
+
+void PointerDispatcher::refresh() {
+    DomNode* target = m_inside ? elementAt(m_x, m_y) : nullptr;
+    if (target == m_hovered) return;
+    if (m_hovered && m_document.styledNodeFor(*m_hovered)) dispatch(EventType::MOUSE_OUT, m_hovered);
+    m_hovered = target;
+    dispatch(EventType::MOUSE_OVER, m_hovered);
+}
+
+void PointerDispatcher::moved(float x, float y) {
+    m_x = x;
+    m_y = y;
+    m_inside = true;
+    refresh();
+    dispatch(EventType::MOUSE_MOVE, m_hovered);
+}
+
+void PointerDispatcher::left() {
+    m_inside = false;
+    m_pressed = nullptr;
+    refresh();
+}
+
+void PointerDispatcher::button(int button, bool pressed) {
+    DomNode* target = m_inside ? elementAt(m_x, m_y) : nullptr;
+    if (pressed) {
+        dispatch(EventType::MOUSE_DOWN, target, button);
+        m_pressed = target;
+        return;
+    }
+    dispatch(EventType::MOUSE_UP, target, button);
+    if (target && target == m_pressed) dispatch(EventType::CLICK, target, button);
+    m_pressed = nullptr;
+}
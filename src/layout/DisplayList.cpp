@@ -1,25 +1,77 @@
 #include "layout/DisplayList.hpp"
+#include "utils/MemoryTracker.hpp"
+#include "utils/Trace.hpp"
 #include <iostream>
 
-void buildListRecursive(DisplayList& list, const LayoutBox& layoutBox) {
-    if (layoutBox.styledNode.domNode.type == NodeType::ELEMENT_NODE) {
-        Color color; // Цвет по умолчанию - черный
-        auto it = layoutBox.styledNode.specifiedValues.find("background");
-        if (it != layoutBox.styledNode.specifiedValues.end()) {
-            // Если нашли свойство background, парсим его
-            color = parseHexColor(it->second);
+static bool intersects(const Rect& a, const Rect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static DisplayList buildList(const LayoutTree& layoutTree, const Rect* clip) {
+    TRACE_ZONE("display list");
+    MemoryTracker::Scope memory(MemoryStage::DISPLAY_LIST);
+    DisplayList list;
+    list.rects.reserve(clip ? 1024 : layoutTree.size());
+
+    // Предварительный порядок гарантирует, что родитель обработан раньше детей, поэтому
+    // абсолютные координаты берутся из стека предков за один линейный проход.
+    struct Origin { BoxIndex end; float x, y; };
+    std::vector<Origin> ancestors;
+    for (size_t i = 0; i < layoutTree.size();) {
+        while (!ancestors.empty() && ancestors.back().end <= i) ancestors.pop_back();
+        Rect rect = layoutTree.geometry[i];
+        if (!ancestors.empty()) {
+            rect.x += ancestors.back().x;
+            rect.y += ancestors.back().y;
+        }
+
+        if (clip) {
+            // Оценочные поддеревья не скомпонованы; поддерево, не вылезающее за свой бокс,
+            // можно пропустить одним прыжком.
+            bool visible = intersects(rect, *clip);
+            bool contained = !(layoutTree.flags[i] & LAYOUT_OVERFLOWS);
+            if ((layoutTree.flags[i] & LAYOUT_ESTIMATED) || (!visible && contained)) {
+                // Если дети уложены сверху вниз и не вылезают из своих боксов, то после
+                // первого ребёнка ниже окна все последующие братья тоже невидимы.
+                BoxIndex parent = layoutTree.parents[i];
+                bool belowClip = rect.y >= clip->y + clip->height;
+                bool ordered = parent != NO_BOX && !(layoutTree.flags[parent] & LAYOUT_UNORDERED_CHILDREN);
+                i = (belowClip && ordered && !ancestors.empty()) ? ancestors.back().end : layoutTree.subtreeEnd[i];
+                continue;
+            }
+            if (!visible) {
+                if (layoutTree.subtreeEnd[i] > i + 1) ancestors.push_back({layoutTree.subtreeEnd[i], rect.x, rect.y});
+                ++i;
+                continue;
+            }
         }
-        
-        list.push_back({layoutBox.dimensions, color});
-    }
 
-    for (const auto& child : layoutBox.children) {
-        buildListRecursive(list, *child);
+        if (layoutTree.isElement(static_cast<BoxIndex>(i))) {
+            list.rects.push_back({rect, layoutTree.backgrounds[i], {layoutTree.styledNodes[i]}});
+        } else {
+            // Каждая строка текстового бокса — отдельная команда со своим куском текста
+            const InlineText& text = *layoutTree.texts[i];
+            const std::string& source = layoutTree.styledNodes[i]->domNode.value;
+            for (size_t n = 0; n < text.lines.size(); ++n) {
+                const TextLine& line = text.lines[n];
+                Rect lineRect = {rect.x + line.rect.x, rect.y + line.rect.y, line.rect.width, line.rect.height};
+                if (clip && !intersects(lineRect, *clip)) continue;
+                uint32_t begin = text.metrics.words[line.firstWord].begin;
+                uint32_t end = text.metrics.words[line.endWord - 1].end;
+                list.texts.push_back({lineRect, layoutTree.foregrounds[i], layoutTree.fontSizes[i],
+                                      source.substr(begin, end - begin), {layoutTree.styledNodes[i], static_cast<uint32_t>(n)}});
+            }
+        }
+        if (layoutTree.subtreeEnd[i] > i + 1) ancestors.push_back({layoutTree.subtreeEnd[i], rect.x, rect.y});
+        ++i;
     }
+    return list;
 }
 
-DisplayList buildDisplayList(const LayoutBox& layoutRoot) {
-    DisplayList list;
-    buildListRecursive(list, layoutRoot);
-    return list;
+DisplayList buildDisplayList(const LayoutTree& layoutTree) {
+    return buildList(layoutTree, nullptr);
+}
+
+DisplayList buildDisplayList(const LayoutTree& layoutTree, const Rect& clip) {
+    return buildList(layoutTree, &clip);
 }
@@ -0,0 +1,191 @@
+#include "layout/DisplayListOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Сетка покрытия ограничена по числу тайлов, чтобы проход по огромному списку без
+// отсечения по экрану не съедал память; на экранных списках тайл 8x8 пикселей.
+static constexpr float MIN_TILE = 8.0f;
+static constexpr double MAX_TILES = 1 << 20;
+static constexpr int CELLS = 8; // Тайл делится на 8x8 ячеек, по биту на ячейку
+
+static double area(const Rect& r) {
+    return static_cast<double>(r.width) * r.height;
+}
+
+static bool clipTo(Rect& r, const Rect& target) {
+    float left = std::max(r.x, target.x);
+    float top = std::max(r.y, target.y);
+    float right = std::min(r.x + r.width, target.x + target.width);
+    float bottom = std::min(r.y + r.height, target.y + target.height);
+    if (right <= left || bottom <= top) return false;
+    r = {left, top, right - left, bottom - top};
+    return true;
+}
+
+namespace {
+
+// Покрытие непрозрачными прямоугольниками, нарисованными позже: по 64-битной маске на тайл,
+// поэтому тайл закрывается и объединением нескольких прямоугольников.
+class CoverageGrid {
+public:
+    CoverageGrid(const Rect& target) : m_origin(target) {
+        m_tile = std::max(MIN_TILE, static_cast<float>(std::ceil(std::sqrt(area(target) / MAX_TILES))));
+        m_cell = m_tile / CELLS;
+        m_columns = std::max(1, static_cast<int>(std::ceil(target.width / m_tile)));
+        m_rows = std::max(1, static_cast<int>(std::ceil(target.height / m_tile)));
+        m_masks.assign(static_cast<size_t>(m_columns) * m_rows, 0);
+    }
+
+    // Диапазон тайлов, задетых прямоугольником (включительно)
+    void touched(const Rect& r, int& c0, int& r0, int& c1, int& r1) const {
+        c0 = std::clamp(static_cast<int>((r.x - m_origin.x) / m_tile), 0, m_columns - 1);
+        r0 = std::clamp(static_cast<int>((r.y - m_origin.y) / m_tile), 0, m_rows - 1);
+        c1 = std::clamp(static_cast<int>(std::ceil((r.x + r.width - m_origin.x) / m_tile)) - 1, 0, m_columns - 1);
+        r1 = std::clamp(static_cast<int>(std::ceil((r.y + r.height - m_origin.y) / m_tile)) - 1, 0, m_rows - 1);
+    }
+
+    // Задетые прямоугольником ячейки тайла закрыты?
+    bool hidden(const Rect& r, int column, int row) const {
+        uint64_t mask = cellMask(r, column, row, false);
+        return (mask & ~m_masks[static_cast<size_t>(row) * m_columns + column]) == 0;
+    }
+    bool rowHidden(const Rect& r, int row, int c0, int c1) const {
+        for (int c = c0; c <= c1; ++c) if (!hidden(r, c, row)) return false;
+        return true;
+    }
+    bool columnHidden(const Rect& r, int column, int r0, int r1) const {
+        for (int row = r0; row <= r1; ++row) if (!hidden(r, column, row)) return false;
+        return true;
+    }
+
+    // Помечает ячейки, которые прямоугольник закрывает целиком
+    void cover(const Rect& r) {
+        int c0, r0, c1, r1;
+        touched(r, c0, r0, c1, r1);
+        for (int row = r0; row <= r1; ++row) {
+            for (int column = c0; column <= c1; ++column) {
+                m_masks[static_cast<size_t>(row) * m_columns + column] |= cellMask(r, column, row, true);
+            }
+        }
+    }
+
+    float columnLeft(int c) const { return m_origin.x + c * m_tile; }
+    float rowTop(int r) const { return m_origin.y + r * m_tile; }
+
+private:
+    // inner: только ячейки целиком внутри прямоугольника; иначе все, которых он касается.
+    // Ячейки за границей цели считаются закрытыми — там ничего не рисуется.
+    uint64_t cellMask(const Rect& r, int column, int row, bool inner) const {
+        float left = columnLeft(column), top = rowTop(row);
+        // Внутренние тайлы большого прямоугольника — самый частый случай
+        if (r.x <= left && r.y <= top && r.x + r.width >= left + m_tile && r.y + r.height >= top + m_tile) return ~0ull;
+        float right = m_origin.x + m_origin.width, bottom = m_origin.y + m_origin.height;
+        auto span = [&](float from, float to, float origin, float limit, int& first, int& last) {
+            float a = (from - origin) / m_cell, b = (to - origin) / m_cell;
+            if (inner && to >= limit) b = CELLS;
+            first = std::clamp(static_cast<int>(inner ? std::ceil(a) : std::floor(a)), 0, CELLS);
+            last = std::clamp(static_cast<int>(inner ? std::floor(b) : std::ceil(b)), 0, CELLS);
+        };
+        int x0, x1, y0, y1;
+        span(r.x, r.x + r.width, left, right, x0, x1);
+        span(r.y, r.y + r.height, top, bottom, y0, y1);
+        if (x1 <= x0 || y1 <= y0) return 0;
+        uint64_t rowBits = ((1ull << (x1 - x0)) - 1) << x0;
+        uint64_t mask = 0;
+        for (int y = y0; y < y1; ++y) mask |= rowBits << (CELLS * y);
+        return mask;
+    }
+
+    Rect m_origin;
+    float m_tile, m_cell;
+    int m_columns, m_rows;
+    std::vector<uint64_t> m_masks;
+};
+
+} // namespace
+
+OverdrawStats optimizeDisplayList(DisplayList& list, const Rect& target) {
+    OverdrawStats stats;
+    stats.commandsBefore = list.rects.size();
+    stats.targetPixels = area(target);
+    for (const auto& command : list.rects) {
+        Rect r = command.rect;
+        if (clipTo(r, target)) stats.pixelsBefore += area(r);
+    }
+
+    // 1. Отбрасываем невидимое и обрезаем по цели
+    std::vector<SolidRectCommand> visible;
+    visible.reserve(list.rects.size());
+    for (const auto& command : list.rects) {
+        SolidRectCommand clipped = command;
+        if (command.color.a == 0 || !clipTo(clipped.rect, target)) {
+            stats.invisibleDropped++;
+            continue;
+        }
+        visible.push_back(clipped);
+    }
+
+    // 2. Идём от верхних к нижним: то, что закрыто позже нарисованным, не рисуем
+    CoverageGrid grid(target);
+    std::vector<uint8_t> keep(visible.size(), 1);
+    for (size_t k = visible.size(); k-- > 0;) {
+        Rect& r = visible[k].rect;
+        int c0, r0, c1, r1;
+        grid.touched(r, c0, r0, c1, r1);
+
+        // Срезаем полностью закрытые ряды и столбцы тайлов по краям
+        bool trimmed = false;
+        while (r0 <= r1 && grid.rowHidden(r, r0, c0, c1)) r0++;
+        while (r1 >= r0 && grid.rowHidden(r, r1, c0, c1)) r1--;
+        if (r0 > r1) {
+            keep[k] = 0;
+            stats.occludedDropped++;
+            continue;
+        }
+        while (c0 <= c1 && grid.columnHidden(r, c0, r0, r1)) c0++;
+        while (c1 >= c0 && grid.columnHidden(r, c1, r0, r1)) c1--;
+
+        float top = std::max(r.y, grid.rowTop(r0));
+        float bottom = std::min(r.y + r.height, grid.rowTop(r1 + 1));
+        float left = std::max(r.x, grid.columnLeft(c0));
+        float right = std::min(r.x + r.width, grid.columnLeft(c1 + 1));
+        if (top != r.y || bottom != r.y + r.height || left != r.x || right != r.x + r.width) trimmed = true;
+        Rect original = r;
+        r = {left, top, right - left, bottom - top};
+        if (trimmed) stats.clipped++;
+
+        if (visible[k].color.a == 255) grid.cover(original);
+    }
+
+    // 3. Сливаем соседние по порядку прямоугольники одного цвета с общей стороной;
+    // слитый прямоугольник сохраняет ключ первого
+    list.rects.clear();
+    for (size_t k = 0; k < visible.size(); ++k) {
+        if (!keep[k]) continue;
+        const SolidRectCommand& command = visible[k];
+        if (!list.rects.empty()) {
+            SolidRectCommand& last = list.rects.back();
+            const Rect& a = last.rect;
+            const Rect& b = command.rect;
+            if (last.color == command.color) {
+                if (a.x == b.x && a.width == b.width && a.y + a.height == b.y) {
+                    last.rect.height += b.height;
+                    stats.merged++;
+                    continue;
+                }
+                if (a.y == b.y && a.height == b.height && a.x + a.width == b.x) {
+                    last.rect.width += b.width;
+                    stats.merged++;
+                    continue;
+                }
+            }
+        }
+        list.rects.push_back(command);
+    }
+
+    stats.commandsAfter = list.rects.size();
+    for (const auto& command : list.rects) stats.pixelsAfter += area(command.rect);
+    return stats;
+}
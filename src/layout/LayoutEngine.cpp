@@ -1,77 +1,498 @@
 #include "layout/LayoutEngine.hpp"
 #include "parser/StyledNode.hpp"
+#include "utils/ThreadPool.hpp"
+#include "text/Font.hpp"
+#include "utils/MemoryTracker.hpp"
+#include "utils/Trace.hpp"
 #include <string>
 #include <algorithm>
+#include <limits>
 
-float get_px_value(const PropertyMap& values, const std::string& name, float fallback) {
-    auto it = values.find(name);
-    if (it != values.end()) {
-        try {
-            std::string val_str = it->second;
-            size_t px_pos = val_str.find("px");
-            if (px_pos != std::string::npos) val_str.erase(px_pos, 2);
-            return std::stof(val_str);
-        } catch (...) { return fallback; }
+// Subtrees smaller than this are not worth the scheduling overhead
+static constexpr size_t PARALLEL_MIN_BOXES = 16384;
+// Children are grouped into chunks of roughly this many boxes per task
+static constexpr size_t PARALLEL_CHUNK_BOXES = 4096;
+// Pending index shifts before the whole index is rewritten (amortizes lookups)
+static constexpr size_t MAX_INDEX_SHIFTS = 256;
+// Float error tolerated before a child counts as reaching outside its parent
+static constexpr float OVERFLOW_SLACK = 0.01f;
+
+LayoutTree LayoutEngine::buildLayoutTree(const StyledNode& styledRoot) {
+    LayoutEngine engine;
+    engine.build(styledRoot);
+    engine.relayout();
+    return std::move(engine.m_tree);
+}
+
+void LayoutEngine::build(const StyledNode& styledRoot) {
+    TRACE_ZONE("layout build");
+    MemoryTracker::Scope memory(MemoryStage::LAYOUT);
+    m_tree.clear();
+    m_tree.appendStyledSubtree(styledRoot, NO_BOX);
+    m_indices.clear();
+    m_shifts.clear();
+    reindex(0, static_cast<BoxIndex>(m_tree.size()));
+}
+
+void LayoutEngine::setViewport(float width, float height) {
+    m_viewport.width = width;
+    m_viewport.height = height;
+}
+
+void LayoutEngine::reindex(BoxIndex begin, BoxIndex end) {
+    uint32_t edits = static_cast<uint32_t>(m_shifts.size());
+    for (BoxIndex i = begin; i < end; ++i) m_indices[m_tree.styledNodes[i]] = {i, edits};
+}
+
+BoxIndex LayoutEngine::indexOf(const StyledNode& node) const {
+    auto it = m_indices.find(&node);
+    if (it == m_indices.end()) return NO_BOX;
+    // Досдвигаем индекс правками, сделанными после его записи
+    int64_t box = it->second.box;
+    for (size_t i = it->second.edits; i < m_shifts.size(); ++i) {
+        if (box >= m_shifts[i].from) box += m_shifts[i].delta;
     }
-    return fallback;
+    return static_cast<BoxIndex>(box);
 }
 
-static std::unique_ptr<LayoutBox> build_box_tree(const StyledNode& styledRoot) {
-    auto box = std::make_unique<LayoutBox>(styledRoot);
-    for (const auto& child_node : styledRoot.children) {
-        if (child_node->domNode.type == NodeType::TEXT_NODE && 
-            child_node->domNode.value.find_first_not_of(" \t\n\r") == std::string::npos) {
-            continue;
+void LayoutEngine::styleChanged(const StyledNode& node) {
+    BoxIndex box = indexOf(node);
+    if (box == NO_BOX) return;
+    Color oldForeground = m_tree.foregrounds[box];
+    float oldFontSize = m_tree.fontSizes[box];
+    if (m_tree.resolveStyle(box)) markNeedsLayout(box);
+
+    // Цвет и размер шрифта наследуются — пересчитываем потомков в прямом порядке
+    if (m_tree.foregrounds[box] != oldForeground || m_tree.fontSizes[box] != oldFontSize) {
+        for (BoxIndex k = box + 1; k < m_tree.subtreeEnd[box]; ++k) {
+            if (m_tree.resolveStyle(k)) markNeedsLayout(k);
         }
-        box->children.push_back(build_box_tree(*child_node));
     }
-    return box;
 }
 
-std::unique_ptr<LayoutBox> LayoutEngine::buildLayoutTree(const StyledNode& styledRoot) {
-    auto layoutRoot = build_box_tree(styledRoot);
-    if (layoutRoot) {
-        LayoutEngine engine;
-        Rect initialContainingBlock = {0.0f, 0.0f, 800.0f, 600.0f};
-        engine.layout(*layoutRoot, initialContainingBlock);
+void LayoutEngine::markNeedsLayout(const StyledNode& node) {
+    BoxIndex box = indexOf(node);
+    if (box != NO_BOX) markNeedsLayout(box);
+}
+
+void LayoutEngine::markNeedsLayout(BoxIndex box) {
+    m_tree.flags[box] |= LAYOUT_NEEDS_LAYOUT;
+    for (BoxIndex ancestor = m_tree.parents[box];
+         ancestor != NO_BOX && !(m_tree.flags[ancestor] & LAYOUT_CHILD_NEEDS_LAYOUT);
+         ancestor = m_tree.parents[ancestor]) {
+        m_tree.flags[ancestor] |= LAYOUT_CHILD_NEEDS_LAYOUT;
     }
-    return layoutRoot;
 }
 
-void LayoutEngine::layout(LayoutBox& box, const Rect& containingBlock) {
-    if (box.styledNode.domNode.type != NodeType::ELEMENT_NODE) return;
-    auto& values = box.styledNode.specifiedValues;
+void LayoutEngine::rebuildChildren(const StyledNode& node) {
+    BoxIndex box = indexOf(node);
+    if (box == NO_BOX) return;
 
-    // Сначала определяем ширину блока. Либо из CSS, либо от родителя.
-    float specifiedWidth = get_px_value(values, "width", 0.0f);
-    if (specifiedWidth > 0) {
-        box.dimensions.width = specifiedWidth;
+    // Переиспользуем поддеревья детей, которые остались на месте, вместе с их кэшем
+    std::unordered_map<const StyledNode*, BoxIndex> previous;
+    for (BoxIndex child = box + 1; child < m_tree.subtreeEnd[box]; child = m_tree.subtreeEnd[child]) {
+        previous[m_tree.styledNodes[child]] = child;
+    }
+
+    LayoutTree fragment;
+    for (const auto& child_node : node.children) {
+        if (!LayoutTree::generatesBox(*child_node)) continue;
+        auto reused = previous.find(child_node.get());
+        if (reused != previous.end()) {
+            fragment.appendRange(m_tree, reused->second, m_tree.subtreeEnd[reused->second], NO_BOX);
+            previous.erase(reused);
+        } else {
+            fragment.appendStyledSubtree(*child_node, NO_BOX);
+        }
+    }
+    // Стилизованные узлы удалённых детей могут быть уже уничтожены — используем только адреса
+    for (const auto& [styledNode, child] : previous) {
+        for (BoxIndex k = child; k < m_tree.subtreeEnd[child]; ++k) m_indices.erase(m_tree.styledNodes[k]);
+    }
+
+    BoxIndex oldEnd = m_tree.subtreeEnd[box];
+    m_tree.replaceDescendants(box, std::move(fragment));
+    int64_t delta = static_cast<int64_t>(m_tree.subtreeEnd[box]) - oldEnd;
+    if (delta != 0 && m_shifts.size() >= MAX_INDEX_SHIFTS) {
+        // Журнал сдвигов разросся — переписываем индекс целиком, раз в MAX_INDEX_SHIFTS правок
+        m_shifts.clear();
+        reindex(0, static_cast<BoxIndex>(m_tree.size()));
     } else {
-        box.dimensions.width = containingBlock.width;
+        // Боксы после старого конца диапазона сдвинутся при поиске; сам диапазон пишем заново
+        if (delta != 0) m_shifts.push_back({oldEnd, delta});
+        reindex(box + 1, m_tree.subtreeEnd[box]);
+    }
+    markNeedsLayout(box);
+}
+
+void LayoutEngine::textChanged(const StyledNode& node) {
+    BoxIndex box = indexOf(node);
+    if (box == NO_BOX || m_tree.isElement(box)) return;
+    m_tree.texts[box]->metrics.invalidate();
+    markNeedsLayout(box);
+}
+
+void LayoutEngine::setLazyLayout(bool enabled, float prefetchMargin) {
+    m_lazy = enabled;
+    m_prefetchMargin = prefetchMargin;
+}
+
+float LayoutEngine::documentHeight() const {
+    if (m_tree.size() == 0) return 0.0f;
+    return m_tree.geometry[0].y + m_tree.geometry[0].height + m_tree.boxModels[0].marginBottom;
+}
+
+const LayoutStats& LayoutEngine::relayout() {
+    TRACE_ZONE("layout");
+    MemoryTracker::Scope memory(MemoryStage::LAYOUT);
+    m_stats = LayoutStats{};
+    if (m_tree.size() > 0) {
+        float rootY = m_viewport.y + m_tree.boxModels[0].marginTop;
+        layout(0, m_viewport.width, rootY, m_stats, m_threadPool != nullptr);
+        m_tree.geometry[0].x = m_viewport.x + m_tree.boxModels[0].marginLeft;
+        m_tree.geometry[0].y = rootY;
+    }
+    m_measuredHeight += m_stats.measuredHeight;
+    m_measuredBoxes += m_stats.measuredBoxes;
+    return m_stats;
+}
+
+float LayoutEngine::estimateHeight(BoxIndex box, const LayoutStats& stats) const {
+    const BoxModel& model = m_tree.boxModels[box];
+    if (model.height > 0) return model.height;
+    // Уже компоновавшийся бокс помнит свою прошлую высоту — она лучше любой оценки
+    if (m_tree.cachedContainingWidth[box] >= 0.0f || (m_tree.flags[box] & LAYOUT_ESTIMATED)) {
+        return m_tree.geometry[box].height;
+    }
+    // Прошлые проходы плюс то, что уже скомпоновано в этом (у задачи пула — в её части)
+    size_t measuredBoxes = m_measuredBoxes + stats.measuredBoxes;
+    double perBox = measuredBoxes > 0 ? (m_measuredHeight + stats.measuredHeight) / measuredBoxes : 20.0;
+    size_t descendants = m_tree.subtreeEnd[box] - box - 1;
+    return static_cast<float>(2 * model.padding + descendants * perBox);
+}
+
+bool LayoutEngine::isClean(BoxIndex box, float containingWidth) const {
+    return !(m_tree.flags[box] & (LAYOUT_NEEDS_LAYOUT | LAYOUT_CHILD_NEEDS_LAYOUT)) &&
+           m_tree.cachedContainingWidth[box] == containingWidth;
+}
+
+bool LayoutEngine::inWindow(float top, float height) const {
+    float windowTop = m_scrollY - m_prefetchMargin;
+    float windowBottom = m_scrollY + m_viewport.height + m_prefetchMargin;
+    return top <= windowBottom && top + height >= windowTop;
+}
+
+bool LayoutEngine::deferOffscreen(BoxIndex box, float containingWidth, float top, LayoutStats& stats) {
+    if (isClean(box, containingWidth)) return false;
+
+    float height = estimateHeight(box, stats);
+    if (inWindow(top, height)) return false;
+
+    // Поддерево вне окна: ставим оценочную высоту и оставляем его грязным до появления в окне
+    Rect& dimensions = m_tree.geometry[box];
+    dimensions.width = m_tree.boxModels[box].width > 0 ? m_tree.boxModels[box].width : containingWidth;
+    dimensions.height = height;
+    m_tree.flags[box] |= LAYOUT_ESTIMATED | LAYOUT_NEEDS_LAYOUT;
+    stats.boxesEstimated++;
+    return true;
+}
+
+void LayoutEngine::layout(BoxIndex box, float containingWidth, float originY, LayoutStats& stats, bool allowParallel) {
+    uint8_t& flags = m_tree.flags[box];
+    // Чистое поддерево с тем же ограничением по ширине можно не трогать
+    if (isClean(box, containingWidth)) {
+        stats.subtreesReused++;
+        return;
+    }
+    // Строчный бокс вне блочного контейнера (корень документа) — сам себе строковый контекст
+    if (m_tree.isInline(box)) {
+        layoutInlineRun(box, m_tree.subtreeEnd[box], 0.0f, 0.0f, containingWidth, stats);
+        return;
     }
+    stats.boxesLaidOut++;
+    flags &= ~(LAYOUT_NEEDS_LAYOUT | LAYOUT_CHILD_NEEDS_LAYOUT | LAYOUT_ESTIMATED | LAYOUT_UNORDERED_CHILDREN | LAYOUT_OVERFLOWS);
+    m_tree.cachedContainingWidth[box] = containingWidth;
 
-    // Позиционируем блок
-    box.dimensions.x = containingBlock.x + get_px_value(values, "margin-left", 0.0f);
-    box.dimensions.y = containingBlock.y + get_px_value(values, "margin-top", 0.0f);
+    Rect& dimensions = m_tree.geometry[box];
+    const BoxModel& model = m_tree.boxModels[box];
+
+    // Сначала определяем ширину блока. Либо из CSS, либо от родителя.
+    dimensions.width = model.width > 0 ? model.width : containingWidth;
 
-    // Рассчитываем область для контента (с учетом padding)
-    float padding = get_px_value(values, "padding", 0.0f);
-    float contentX = box.dimensions.x + padding;
-    float contentY = box.dimensions.y + padding;
     // Ширина контента - это ширина нашего блока минус паддинги
-    float contentWidth = box.dimensions.width - 2 * padding;
+    float padding = model.padding;
+    float contentWidth = dimensions.width - 2 * padding;
+
+    // Дети блочного бокса зависят только от contentWidth, поэтому большие поддеревья
+    // можно компоновать независимо, а вертикальные позиции расставить потом.
+    size_t subtreeSize = m_tree.subtreeEnd[box] - box;
+    bool parallel = allowParallel && subtreeSize >= PARALLEL_MIN_BOXES;
+    std::vector<ParallelChild> parallelChildren;
+    if (parallel) {
+        layoutChildrenParallel(box, contentWidth, originY + padding, stats, parallelChildren);
+    }
+    size_t nextParallel = 0;
 
-    // Компонуем дочерние элементы внутри области контента
+    // Компонуем дочерние элементы внутри области контента. Позиции детей задаются
+    // относительно нашего бокса, поэтому их поддеревья не нужно сдвигать.
     float contentHeight = 0.0f;
-    for (auto& child : box.children) {
-        Rect childContainingBlock = { contentX, contentY + contentHeight, contentWidth, 0 };
-        layout(*child, childContainingBlock);
-        contentHeight += get_px_value(child->styledNode.specifiedValues, "margin-top", 0.0f)
-                       + child->dimensions.height
-                       + get_px_value(child->styledNode.specifiedValues, "margin-bottom", 0.0f);
+    bool childrenPending = false;
+
+    // Список отображения пропускает поддеревья, полагаясь на порядок детей сверху вниз и на то,
+    // что они не вылезают за бокс. Отрицательные поля, фиксированные размеры и длинные слова
+    // это нарушают — отмечаем такие боксы флагами
+    float previousY = std::numeric_limits<float>::lowest(), childrenBottom = 0.0f;
+    auto checkPlacement = [&](BoxIndex child) {
+        const Rect& r = m_tree.geometry[child];
+        // Содержимое вылезающего ребёнка может оказаться выше предыдущих братьев
+        bool childOverflows = (m_tree.flags[child] & LAYOUT_OVERFLOWS) && !(m_tree.flags[child] & LAYOUT_ESTIMATED);
+        if (r.y < previousY || childOverflows) flags |= LAYOUT_UNORDERED_CHILDREN;
+        if (childOverflows || r.x < -OVERFLOW_SLACK || r.y < -OVERFLOW_SLACK || r.x + r.width > dimensions.width + OVERFLOW_SLACK) {
+            flags |= LAYOUT_OVERFLOWS;
+        }
+        previousY = r.y;
+        childrenBottom = std::max(childrenBottom, r.y + r.height);
+    };
+
+    for (BoxIndex child = box + 1; child < m_tree.subtreeEnd[box];) {
+        // Подряд идущие строчные дети образуют один строковый контекст (анонимный блок)
+        if (m_tree.isInline(child)) {
+            BoxIndex runEnd = child;
+            while (runEnd < m_tree.subtreeEnd[box] && m_tree.isInline(runEnd)) runEnd = m_tree.subtreeEnd[runEnd];
+            float runHeight = layoutInlineRun(child, runEnd, padding, padding + contentHeight, contentWidth, stats);
+            if (m_lazy) {
+                stats.measuredHeight += runHeight;
+                stats.measuredBoxes += runEnd - child;
+            }
+            contentHeight += runHeight;
+            for (; child < runEnd; child = m_tree.subtreeEnd[child]) checkPlacement(child);
+            continue;
+        }
+
+        const BoxModel& childModel = m_tree.boxModels[child];
+        Rect& childRect = m_tree.geometry[child];
+        float childTop = originY + padding + contentHeight + childModel.marginTop;
+        float oldHeight = childRect.height;
+        float shiftBefore = stats.scrollAnchorShift;
+        bool laidOut = false;
+        if (parallel) {
+            const ParallelChild& record = parallelChildren[nextParallel++];
+            oldHeight = record.oldHeight;
+            stats.scrollAnchorShift += record.nestedShift;
+            laidOut = !record.deferred;
+            // Пропущенный пулом ребёнок решается здесь, как в последовательном проходе: к этому
+            // моменту оценка учитывает всё скомпонованное выше, а прикидка могла промахнуться
+            if (record.deferred && !deferOffscreen(child, contentWidth, childTop, stats)) {
+                layout(child, contentWidth, childTop, stats, allowParallel);
+                laidOut = true;
+            }
+        } else if (!(m_lazy && deferOffscreen(child, contentWidth, childTop, stats))) {
+            layout(child, contentWidth, childTop, stats, allowParallel);
+            laidOut = true;
+        }
+        // Изменение высоты контента целиком над экраном компенсируем прокруткой
+        if (laidOut && m_lazy && childTop + childRect.height <= m_scrollY) {
+            stats.scrollAnchorShift = shiftBefore + (childRect.height - oldHeight);
+        }
+        if (m_tree.flags[child] & (LAYOUT_NEEDS_LAYOUT | LAYOUT_CHILD_NEEDS_LAYOUT)) childrenPending = true;
+        childRect.x = padding + childModel.marginLeft;
+        childRect.y = padding + contentHeight + childModel.marginTop;
+        checkPlacement(child);
+        contentHeight += childModel.marginTop + childRect.height + childModel.marginBottom;
+        child = m_tree.subtreeEnd[child];
     }
+    // Отложенные потомки должны быть найдены следующим проходом
+    if (childrenPending) flags |= LAYOUT_CHILD_NEEDS_LAYOUT;
 
     // Рассчитываем финальную высоту блока
-    float specifiedHeight = get_px_value(values, "height", 0.0f);
-    box.dimensions.height = (specifiedHeight > 0) ? specifiedHeight : (contentHeight + 2 * padding);
+    dimensions.height = (model.height > 0) ? model.height : (contentHeight + 2 * padding);
+    if (childrenBottom > dimensions.height + OVERFLOW_SLACK) flags |= LAYOUT_OVERFLOWS;
+
+    // Листья дают статистику для оценки высоты ещё не скомпонованных поддеревьев
+    if (m_lazy && box + 1 == m_tree.subtreeEnd[box]) {
+        stats.measuredHeight += dimensions.height + model.marginTop + model.marginBottom;
+        stats.measuredBoxes++;
+    }
+}
+
+void LayoutEngine::layoutChildrenParallel(BoxIndex box, float contentWidth, float contentTop, LayoutStats& stats,
+                                          std::vector<ParallelChild>& children) {
+    // Ленивый режим: положение детей прикидываем по прошлым высотам и оценкам, и тех, кто
+    // вне окна, пулу не отдаём. Оценку им поставит проход расстановки.
+    struct Work {
+        BoxIndex child;
+        float top;
+        size_t record;
+    };
+    std::vector<Work> work;
+    float y = contentTop;
+    for (BoxIndex child = box + 1; child < m_tree.subtreeEnd[box]; child = m_tree.subtreeEnd[child]) {
+        // Строчных детей раскладывает сам контейнер, когда расставляет строки
+        if (m_tree.isInline(child)) continue;
+        const BoxModel& childModel = m_tree.boxModels[child];
+        float top = y + childModel.marginTop;
+        float height = m_lazy ? estimateHeight(child, stats) : 0.0f;
+        bool deferred = m_lazy && !isClean(child, contentWidth) && !inWindow(top, height);
+        if (!deferred) work.push_back({child, top, children.size()});
+        children.push_back({m_tree.geometry[child].height, 0.0f, deferred});
+        y = top + height + childModel.marginBottom;
+    }
+
+    // Режем оставшихся детей на непрерывные группы примерно равного объёма работы
+    std::vector<std::pair<size_t, size_t>> chunks;
+    size_t chunkBegin = 0;
+    size_t chunkBoxes = 0;
+    for (size_t i = 0; i < work.size(); ++i) {
+        chunkBoxes += m_tree.subtreeEnd[work[i].child] - work[i].child;
+        if (chunkBoxes >= PARALLEL_CHUNK_BOXES) {
+            chunks.emplace_back(chunkBegin, i + 1);
+            chunkBegin = i + 1;
+            chunkBoxes = 0;
+        }
+    }
+    if (chunkBegin < work.size()) chunks.emplace_back(chunkBegin, work.size());
+
+    // Каждая задача пишет только в свои диапазоны массивов и в свои счётчики,
+    // поэтому результат не зависит от порядка выполнения задач.
+    std::vector<LayoutStats> chunkStats(chunks.size());
+    auto layoutChunk = [&](size_t i, bool allowParallel) {
+        LayoutStats& local = chunkStats[i];
+        for (size_t w = chunks[i].first; w < chunks[i].second; ++w) {
+            float shiftBefore = local.scrollAnchorShift;
+            layout(work[w].child, contentWidth, work[w].top, local, allowParallel);
+            children[work[w].record].nestedShift = local.scrollAnchorShift - shiftBefore;
+        }
+    };
+    // Единственный крупный кусок — делим работу уровнем ниже
+    if (chunks.size() < 2) {
+        for (size_t i = 0; i < chunks.size(); ++i) layoutChunk(i, true);
+    } else {
+        m_threadPool->parallelFor(chunks.size(), [&](size_t i) {
+            MemoryTracker::Scope memory(MemoryStage::LAYOUT);
+            layoutChunk(i, false);
+        });
+    }
+    for (const auto& chunk : chunkStats) {
+        stats.boxesLaidOut += chunk.boxesLaidOut;
+        stats.subtreesReused += chunk.subtreesReused;
+        stats.boxesEstimated += chunk.boxesEstimated;
+        stats.textsMeasured += chunk.textsMeasured;
+        stats.measuredHeight += chunk.measuredHeight;
+        stats.measuredBoxes += chunk.measuredBoxes;
+    }
+}
+
+float LayoutEngine::layoutInlineRun(BoxIndex first, BoxIndex end, float originX, float originY, float width, LayoutStats& stats) {
+    // Кусок строки: подряд идущие слова одного текстового бокса
+    struct Fragment {
+        BoxIndex box;
+        uint32_t firstWord, endWord;
+        float x, width;
+    };
+    std::vector<Fragment> line;
+    float penX = 0.0f, lineTop = 0.0f;
+    bool spacePending = false;
+
+    // Строка выравнивается по общей базовой линии самого крупного шрифта
+    auto finishLine = [&]() {
+        if (line.empty()) return;
+        float above = 0.0f, below = 0.0f;
+        for (const Fragment& f : line) {
+            float fontSize = m_tree.fontSizes[f.box];
+            float baseline = Font::cellTop(fontSize) + Font::ascent(fontSize);
+            above = std::max(above, baseline);
+            below = std::max(below, Font::lineHeight(fontSize) - baseline);
+        }
+        for (const Fragment& f : line) {
+            float fontSize = m_tree.fontSizes[f.box];
+            float top = lineTop + above - (Font::cellTop(fontSize) + Font::ascent(fontSize));
+            m_tree.texts[f.box]->lines.push_back({f.firstWord, f.endWord, {f.x, top, f.width, Font::lineHeight(fontSize)}});
+        }
+        lineTop += above + below;
+        penX = 0.0f;
+        line.clear();
+    };
+
+    for (BoxIndex k = first; k < end; ++k) {
+        stats.boxesLaidOut++;
+        m_tree.flags[k] &= ~(LAYOUT_NEEDS_LAYOUT | LAYOUT_CHILD_NEEDS_LAYOUT | LAYOUT_ESTIMATED | LAYOUT_OVERFLOWS);
+        m_tree.cachedContainingWidth[k] = width;
+        // Строчный элемент: только объединяет куски потомков. Рамка охватывает их целиком,
+        // но на одной строке потомок с крупным шрифтом начинается выше соседа с мелким
+        if (m_tree.isElement(k)) {
+            m_tree.flags[k] |= LAYOUT_UNORDERED_CHILDREN;
+            continue;
+        }
+
+        InlineText& text = *m_tree.texts[k];
+        float fontSize = m_tree.fontSizes[k];
+        // Слова замеряются один раз; при смене ширины строки только перестраиваются
+        if (!text.metrics.isMeasured(fontSize)) {
+            text.metrics.measure(m_tree.styledNodes[k]->domNode.value, fontSize);
+            stats.textsMeasured++;
+        }
+        text.lines.clear();
+        spacePending = spacePending || text.metrics.leadingSpace;
+
+        const auto& words = text.metrics.words;
+        for (uint32_t w = 0; w < words.size(); ++w) {
+            float space = (spacePending && penX > 0.0f) ? text.metrics.spaceWidth : 0.0f;
+            if (penX > 0.0f && penX + space + words[w].width > width) {
+                finishLine();
+                space = 0.0f;
+            }
+            if (!line.empty() && line.back().box == k) {
+                line.back().endWord = w + 1;
+                line.back().width = penX + space + words[w].width - line.back().x;
+            } else {
+                line.push_back({k, w, w + 1, penX + space, words[w].width});
+            }
+            penX += space + words[w].width;
+            spacePending = true;
+        }
+        spacePending = text.metrics.trailingSpace || (words.empty() && spacePending);
+    }
+    finishLine();
+
+    // Рамки боксов: объединение их кусков, от потомков к предкам (координаты контекста)
+    std::vector<Rect> bounds(end - first);
+    for (BoxIndex k = end; k-- > first;) {
+        Rect united;
+        bool empty = true;
+        auto unite = [&](const Rect& r) {
+            if (empty) {
+                united = r;
+                empty = false;
+                return;
+            }
+            float right = std::max(united.x + united.width, r.x + r.width);
+            float bottom = std::max(united.y + united.height, r.y + r.height);
+            united.x = std::min(united.x, r.x);
+            united.y = std::min(united.y, r.y);
+            united.width = right - united.x;
+            united.height = bottom - united.y;
+        };
+        if (m_tree.isElement(k)) {
+            for (BoxIndex c = k + 1; c < m_tree.subtreeEnd[k]; c = m_tree.subtreeEnd[c]) unite(bounds[c - first]);
+        } else {
+            for (const TextLine& l : m_tree.texts[k]->lines) unite(l.rect);
+        }
+        bounds[k - first] = united;
+    }
+    // Переводим в координаты родителя; строки текста — в координаты своего бокса
+    for (BoxIndex k = first; k < end; ++k) {
+        const Rect& b = bounds[k - first];
+        BoxIndex parent = m_tree.parents[k];
+        bool topLevel = parent == NO_BOX || parent < first;
+        float parentX = topLevel ? -originX : bounds[parent - first].x;
+        float parentY = topLevel ? -originY : bounds[parent - first].y;
+        m_tree.geometry[k] = {b.x - parentX, b.y - parentY, b.width, b.height};
+        if (!m_tree.isElement(k)) {
+            for (TextLine& l : m_tree.texts[k]->lines) {
+                l.rect.x -= b.x;
+                l.rect.y -= b.y;
+            }
+        }
+    }
+    return lineTop;
 }
@@ -0,0 +1,199 @@
+#include "layout/LayoutTree.hpp"
+#include <algorithm>
+#include <string>
+
+float parse_px(const std::string& value, float fallback) {
+    try {
+        std::string val_str = value;
+        size_t px_pos = val_str.find("px");
+        if (px_pos != std::string::npos) val_str.erase(px_pos, 2);
+        return std::stof(val_str);
+    } catch (...) { return fallback; }
+}
+
+float get_px_value(const PropertyMap& values, const std::string& name, float fallback) {
+    auto it = values.find(name);
+    return it != values.end() ? parse_px(it->second, fallback) : fallback;
+}
+
+BoxModel resolveBoxModel(const PropertyMap& values) {
+    BoxModel model;
+    model.width = get_px_value(values, "width", 0.0f);
+    model.height = get_px_value(values, "height", 0.0f);
+    model.marginTop = get_px_value(values, "margin-top", 0.0f);
+    model.marginBottom = get_px_value(values, "margin-bottom", 0.0f);
+    model.marginLeft = get_px_value(values, "margin-left", 0.0f);
+    model.padding = get_px_value(values, "padding", 0.0f);
+    auto display = values.find("display");
+    if (display != values.end() && display->second == "inline") model.display = DisplayType::INLINE;
+    return model;
+}
+
+// Пробельные текстовые узлы не порождают боксов
+bool LayoutTree::generatesBox(const StyledNode& node) {
+    return !(node.domNode.type == NodeType::TEXT_NODE &&
+             node.domNode.value.find_first_not_of(" \t\n\r") == std::string::npos);
+}
+
+void LayoutTree::clear() {
+    styledNodes.clear();
+    parents.clear();
+    subtreeEnd.clear();
+    boxModels.clear();
+    backgrounds.clear();
+    foregrounds.clear();
+    fontSizes.clear();
+    geometry.clear();
+    flags.clear();
+    cachedContainingWidth.clear();
+    texts.clear();
+}
+
+void LayoutTree::reserve(size_t count) {
+    styledNodes.reserve(count);
+    parents.reserve(count);
+    subtreeEnd.reserve(count);
+    boxModels.reserve(count);
+    backgrounds.reserve(count);
+    foregrounds.reserve(count);
+    fontSizes.reserve(count);
+    geometry.reserve(count);
+    flags.reserve(count);
+    cachedContainingWidth.reserve(count);
+    texts.reserve(count);
+}
+
+void LayoutTree::appendStyledSubtree(const StyledNode& styledNode, BoxIndex parent) {
+    BoxIndex index = static_cast<BoxIndex>(size());
+    styledNodes.push_back(&styledNode);
+    parents.push_back(parent);
+    subtreeEnd.push_back(index + 1);
+    boxModels.emplace_back();
+    backgrounds.emplace_back();
+    foregrounds.emplace_back();
+    fontSizes.push_back(0.0f);
+    geometry.emplace_back();
+    bool element = styledNode.domNode.type == NodeType::ELEMENT_NODE;
+    flags.push_back(LAYOUT_NEEDS_LAYOUT | LAYOUT_CHILD_NEEDS_LAYOUT | (element ? LAYOUT_IS_ELEMENT : 0));
+    cachedContainingWidth.push_back(-1.0f);
+    texts.push_back(element ? nullptr : std::make_unique<InlineText>());
+    resolveStyle(index);
+
+    for (const auto& child : styledNode.children) {
+        if (generatesBox(*child)) appendStyledSubtree(*child, index);
+    }
+    subtreeEnd[index] = static_cast<BoxIndex>(size());
+}
+
+void LayoutTree::appendRange(const LayoutTree& source, BoxIndex begin, BoxIndex end, BoxIndex parent) {
+    BoxIndex offset = static_cast<BoxIndex>(size());
+    styledNodes.insert(styledNodes.end(), source.styledNodes.begin() + begin, source.styledNodes.begin() + end);
+    boxModels.insert(boxModels.end(), source.boxModels.begin() + begin, source.boxModels.begin() + end);
+    backgrounds.insert(backgrounds.end(), source.backgrounds.begin() + begin, source.backgrounds.begin() + end);
+    foregrounds.insert(foregrounds.end(), source.foregrounds.begin() + begin, source.foregrounds.begin() + end);
+    fontSizes.insert(fontSizes.end(), source.fontSizes.begin() + begin, source.fontSizes.begin() + end);
+    geometry.insert(geometry.end(), source.geometry.begin() + begin, source.geometry.begin() + end);
+    flags.insert(flags.end(), source.flags.begin() + begin, source.flags.begin() + end);
+    cachedContainingWidth.insert(cachedContainingWidth.end(), source.cachedContainingWidth.begin() + begin, source.cachedContainingWidth.begin() + end);
+    for (BoxIndex k = begin; k < end; ++k) {
+        texts.push_back(source.texts[k] ? std::make_unique<InlineText>(*source.texts[k]) : nullptr);
+        // Корни диапазона подвешиваем к новому родителю, остальные индексы сдвигаем
+        bool isRangeRoot = source.parents[k] == NO_BOX || source.parents[k] < begin;
+        parents.push_back(isRangeRoot ? parent : source.parents[k] - begin + offset);
+        subtreeEnd.push_back(source.subtreeEnd[k] - begin + offset);
+    }
+}
+
+void LayoutTree::replaceDescendants(BoxIndex box, LayoutTree&& fragment) {
+    BoxIndex begin = box + 1;
+    BoxIndex end = subtreeEnd[box];
+    int64_t delta = static_cast<int64_t>(fragment.size()) - static_cast<int64_t>(end - begin);
+
+    // Боксы после заменяемого диапазона сдвигаются на delta; при том же размере никто не двигается
+    if (delta != 0) {
+        for (size_t k = end; k < size(); ++k) {
+            if (parents[k] != NO_BOX && parents[k] >= end) parents[k] = static_cast<BoxIndex>(parents[k] + delta);
+            subtreeEnd[k] = static_cast<BoxIndex>(subtreeEnd[k] + delta);
+        }
+        for (BoxIndex ancestor = box; ancestor != NO_BOX; ancestor = parents[ancestor]) {
+            subtreeEnd[ancestor] = static_cast<BoxIndex>(subtreeEnd[ancestor] + delta);
+        }
+    }
+
+    std::vector<BoxIndex> fragmentParents(fragment.size());
+    std::vector<BoxIndex> fragmentEnds(fragment.size());
+    for (size_t k = 0; k < fragment.size(); ++k) {
+        fragmentParents[k] = fragment.parents[k] == NO_BOX ? box : fragment.parents[k] + begin;
+        fragmentEnds[k] = fragment.subtreeEnd[k] + begin;
+    }
+
+    auto splice = [&](auto& target, const auto& replacement) {
+        if (delta == 0) {
+            std::copy(replacement.begin(), replacement.end(), target.begin() + begin);
+            return;
+        }
+        target.erase(target.begin() + begin, target.begin() + end);
+        target.insert(target.begin() + begin, replacement.begin(), replacement.end());
+    };
+    splice(styledNodes, fragment.styledNodes);
+    splice(parents, fragmentParents);
+    splice(subtreeEnd, fragmentEnds);
+    splice(boxModels, fragment.boxModels);
+    splice(backgrounds, fragment.backgrounds);
+    splice(foregrounds, fragment.foregrounds);
+    splice(fontSizes, fragment.fontSizes);
+    splice(geometry, fragment.geometry);
+    splice(flags, fragment.flags);
+    splice(cachedContainingWidth, fragment.cachedContainingWidth);
+
+    // Текстовые данные принадлежат боксам единолично — забираем их из фрагмента
+    if (delta == 0) {
+        std::move(fragment.texts.begin(), fragment.texts.end(), texts.begin() + begin);
+        return;
+    }
+    texts.erase(texts.begin() + begin, texts.begin() + end);
+    texts.insert(texts.begin() + begin, std::make_move_iterator(fragment.texts.begin()), std::make_move_iterator(fragment.texts.end()));
+}
+
+// Наследуемое значение: от ближайшего предка, где оно задано
+static const std::string* findInherited(const StyledNode* node, const char* name) {
+    for (; node; node = node->parent) {
+        auto it = node->specifiedValues.find(name);
+        if (it != node->specifiedValues.end()) return &it->second;
+    }
+    return nullptr;
+}
+
+bool LayoutTree::resolveStyle(BoxIndex i) {
+    const PropertyMap& values = styledNodes[i]->specifiedValues;
+    BoxModel model = isElement(i) ? resolveBoxModel(values) : BoxModel{};
+    if (!isElement(i)) model.display = DisplayType::INLINE; // Текст всегда строчный
+    Color background;
+    background.a = 0; // Без background бокс прозрачен и ничего не рисует
+    auto it = values.find("background");
+    if (it != values.end()) background = parseColor(it->second);
+    backgrounds[i] = background;
+
+    // Корни фрагментов ещё не подвешены к родителю — тогда идём по стилизованным предкам
+    BoxIndex parent = parents[i];
+    Color foreground;
+    float fontSize = DEFAULT_FONT_SIZE;
+    if (parent != NO_BOX) {
+        foreground = foregrounds[parent];
+        fontSize = fontSizes[parent];
+    } else if (styledNodes[i]->parent) {
+        if (const std::string* color = findInherited(styledNodes[i]->parent, "color")) foreground = parseColor(*color);
+        if (const std::string* size = findInherited(styledNodes[i]->parent, "font-size")) {
+            fontSize = parse_px(*size, DEFAULT_FONT_SIZE);
+        }
+    }
+    it = values.find("color");
+    if (it != values.end()) foreground = parseColor(it->second);
+    fontSize = get_px_value(values, "font-size", fontSize);
+    foregrounds[i] = foreground;
+
+    bool changed = model != boxModels[i] || fontSize != fontSizes[i];
+    boxModels[i] = model;
+    fontSizes[i] = fontSize;
+    return changed;
+}
@@ -0,0 +1,255 @@
+#include "layout/SpatialIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static bool sameRect(const Rect& a, const Rect& b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+static bool intersects(const Rect& a, const Rect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static bool contains(const Rect& rect, float x, float y) {
+    return x >= rect.x && x < rect.x + rect.width && y >= rect.y && y < rect.y + rect.height;
+}
+
+const SpatialIndexStats& SpatialIndex::update(const DisplayList& list) {
+    return synchronize(list, nullptr);
+}
+
+const SpatialIndexStats& SpatialIndex::update(const DisplayList& list, const Rect& area) {
+    return synchronize(list, &area);
+}
+
+const SpatialIndexStats& SpatialIndex::synchronize(const DisplayList& list, const Rect* area) {
+    m_frame++;
+    m_stats = SpatialIndexStats{};
+    m_previousOrder.swap(m_order);
+    m_order.clear();
+    m_previousPosition.assign(m_entries.size(), UINT32_MAX);
+    for (size_t i = 0; i < m_previousOrder.size(); ++i) m_previousPosition[m_previousOrder[i]] = static_cast<uint32_t>(i);
+    m_cursor = 0;
+
+    Rect bounds;
+    if (area) {
+        bounds = *area;
+    } else if (list.size() > 0) {
+        float x0 = INFINITY, y0 = INFINITY, x1 = -INFINITY, y1 = -INFINITY;
+        auto grow = [&](const Rect& r) {
+            x0 = std::min(x0, r.x);
+            y0 = std::min(y0, r.y);
+            x1 = std::max(x1, r.x + r.width);
+            y1 = std::max(y1, r.y + r.height);
+        };
+        for (const auto& command : list.rects) grow(command.rect);
+        for (const auto& command : list.texts) grow(command.rect);
+        bounds = {x0, y0, x1 - x0, y1 - y0};
+    }
+    // Сетка пересоздаётся, только когда область вышла за её пределы; запас по вертикали
+    // растягивает это на много кадров прокрутки или роста документа
+    if (m_cells.empty() || !covers(bounds)) {
+        resize(bounds);
+        m_relink = true;
+        m_stats.rebuilt = true;
+    }
+
+    m_ids.reserve(list.size());
+    uint32_t order = 0;
+    for (const auto& command : list.rects) add(command.key, command.rect, order++);
+    for (const auto& command : list.texts) add(command.key, command.rect, order++);
+
+    for (uint32_t id = 0; id < m_entries.size(); ++id) {
+        Entry& entry = m_entries[id];
+        if (entry.frame == 0 || entry.frame == m_frame) continue;
+        if (!m_relink) unlink(id);
+        m_ids.erase(entry.key);
+        entry.frame = 0;
+        entry.placement = Placement::NONE;
+        m_free.push_back(id);
+        m_stats.removed++;
+    }
+    if (m_relink) {
+        // Сначала считаем заполнение ячеек, чтобы каждая выделила память один раз
+        std::vector<uint32_t> counts(m_cells.size(), 0);
+        for (const Entry& entry : m_entries) {
+            CellRange range;
+            if (entry.frame == 0 || !cells(entry.rect, range)) continue;
+            if (static_cast<size_t>(range.c1 - range.c0 + 1) * (range.r1 - range.r0 + 1) > MAX_CELLS_PER_BOX) continue;
+            for (int row = range.r0; row <= range.r1; ++row) {
+                for (int column = range.c0; column <= range.c1; ++column) counts[static_cast<size_t>(row) * m_columns + column]++;
+            }
+        }
+        for (size_t i = 0; i < m_cells.size(); ++i) m_cells[i].reserve(counts[i]);
+        for (uint32_t id = 0; id < m_entries.size(); ++id) {
+            if (m_entries[id].frame != 0) link(id);
+        }
+        m_relink = false;
+    }
+    m_visited.resize(m_entries.size(), 0);
+    return m_stats;
+}
+
+void SpatialIndex::add(const DisplayKey& key, const Rect& rect, uint32_t order) {
+    // Как и в кэше экземпляров: следующий ключ обычно стоит сразу за предыдущим в прошлом порядке
+    uint32_t id;
+    if (m_cursor < m_previousOrder.size() && m_entries[m_previousOrder[m_cursor]].key == key) {
+        id = m_previousOrder[m_cursor];
+    } else {
+        auto [it, inserted] = m_ids.try_emplace(key, 0);
+        if (inserted) {
+            id = it->second = allocate();
+            Entry& entry = m_entries[id];
+            entry.key = key;
+            entry.rect = rect;
+            entry.order = order;
+            entry.frame = m_frame;
+            if (!m_relink) link(id);
+            m_order.push_back(id);
+            m_stats.inserted++;
+            return;
+        }
+        id = it->second;
+    }
+
+    Entry& entry = m_entries[id];
+    if (entry.frame == m_frame) return; // Повтор ключа в кадре: индексируем первый
+    if (m_previousPosition[id] != UINT32_MAX) m_cursor = m_previousPosition[id] + 1;
+    if (!sameRect(entry.rect, rect)) {
+        if (!m_relink) unlink(id);
+        entry.rect = rect;
+        if (!m_relink) link(id);
+        m_stats.moved++;
+    } else {
+        m_stats.unchanged++;
+    }
+    entry.order = order;
+    entry.frame = m_frame;
+    m_order.push_back(id);
+}
+
+uint32_t SpatialIndex::allocate() {
+    if (!m_free.empty()) {
+        uint32_t id = m_free.back();
+        m_free.pop_back();
+        return id;
+    }
+    m_entries.emplace_back();
+    m_previousPosition.push_back(UINT32_MAX);
+    return static_cast<uint32_t>(m_entries.size() - 1);
+}
+
+bool SpatialIndex::cells(const Rect& rect, CellRange& range) const {
+    float x0 = (rect.x - m_originX) / m_cellSize, y0 = (rect.y - m_originY) / m_cellSize;
+    float x1 = (rect.x + rect.width - m_originX) / m_cellSize, y1 = (rect.y + rect.height - m_originY) / m_cellSize;
+    if (x1 < 0.0f || y1 < 0.0f || x0 >= m_columns || y0 >= m_rows) return false;
+    range.c0 = std::max(0, static_cast<int>(x0));
+    range.r0 = std::max(0, static_cast<int>(y0));
+    range.c1 = std::min(m_columns - 1, static_cast<int>(x1));
+    range.r1 = std::min(m_rows - 1, static_cast<int>(y1));
+    return true;
+}
+
+void SpatialIndex::link(uint32_t id) {
+    Entry& entry = m_entries[id];
+    CellRange range;
+    if (!cells(entry.rect, range)) {
+        entry.placement = Placement::NONE; // Вне области запросов
+        return;
+    }
+    size_t count = static_cast<size_t>(range.c1 - range.c0 + 1) * (range.r1 - range.r0 + 1);
+    if (count > MAX_CELLS_PER_BOX) {
+        entry.placement = Placement::OVERSIZED;
+        m_oversized.push_back(id);
+        return;
+    }
+    entry.placement = Placement::CELLS;
+    for (int row = range.r0; row <= range.r1; ++row) {
+        for (int column = range.c0; column <= range.c1; ++column) {
+            m_cells[static_cast<size_t>(row) * m_columns + column].push_back({entry.rect, id});
+        }
+    }
+}
+
+void SpatialIndex::unlink(uint32_t id) {
+    Entry& entry = m_entries[id];
+    if (entry.placement == Placement::OVERSIZED) {
+        *std::find(m_oversized.begin(), m_oversized.end(), id) = m_oversized.back();
+        m_oversized.pop_back();
+    } else if (entry.placement == Placement::CELLS) {
+        CellRange range;
+        cells(entry.rect, range);
+        for (int row = range.r0; row <= range.r1; ++row) {
+            for (int column = range.c0; column <= range.c1; ++column) {
+                auto& items = m_cells[static_cast<size_t>(row) * m_columns + column];
+                *std::find_if(items.begin(), items.end(), [id](const CellItem& item) { return item.id == id; }) = items.back();
+                items.pop_back();
+            }
+        }
+    }
+    entry.placement = Placement::NONE;
+}
+
+bool SpatialIndex::covers(const Rect& area) const {
+    return area.x >= m_originX && area.y >= m_originY && area.x + area.width <= m_originX + m_columns * m_cellSize &&
+           area.y + area.height <= m_originY + m_rows * m_cellSize;
+}
+
+void SpatialIndex::resize(const Rect& area) {
+    // Четверть высоты области сверху и снизу про запас
+    m_originX = area.x;
+    m_originY = area.y - area.height * 0.25f;
+    float width = std::max(area.width, 1.0f);
+    float height = std::max(area.height * 1.5f, 1.0f);
+    m_cellSize = CELL_SIZE;
+    auto columns = [&] { return static_cast<size_t>(std::ceil(width / m_cellSize)); };
+    auto rows = [&] { return static_cast<size_t>(std::ceil(height / m_cellSize)); };
+    while (columns() * rows() > MAX_CELLS) m_cellSize *= 2.0f;
+    m_columns = static_cast<int>(columns());
+    m_rows = static_cast<int>(rows());
+    m_cells.assign(static_cast<size_t>(m_columns) * m_rows, {});
+    m_oversized.clear();
+}
+
+void SpatialIndex::hitTest(float x, float y, std::vector<DisplayKey>& hits) const {
+    hits.clear();
+    m_candidates.clear();
+    float column = (x - m_originX) / m_cellSize, row = (y - m_originY) / m_cellSize;
+    if (column >= 0.0f && row >= 0.0f && column < m_columns && row < m_rows) {
+        for (const CellItem& item : m_cells[static_cast<size_t>(row) * m_columns + static_cast<size_t>(column)]) {
+            if (contains(item.rect, x, y)) m_candidates.push_back(item.id);
+        }
+    }
+    for (uint32_t id : m_oversized) {
+        if (contains(m_entries[id].rect, x, y)) m_candidates.push_back(id);
+    }
+    std::sort(m_candidates.begin(), m_candidates.end(),
+              [&](uint32_t a, uint32_t b) { return m_entries[a].order > m_entries[b].order; });
+    for (uint32_t id : m_candidates) hits.push_back(m_entries[id].key);
+}
+
+void SpatialIndex::query(const Rect& region, std::vector<DisplayKey>& result) const {
+    result.clear();
+    m_candidates.clear();
+    // Бокс лежит в нескольких ячейках — метка визита не даёт вернуть его дважды
+    m_visit++;
+    CellRange range;
+    if (cells(region, range)) {
+        for (int row = range.r0; row <= range.r1; ++row) {
+            for (int column = range.c0; column <= range.c1; ++column) {
+                for (const CellItem& item : m_cells[static_cast<size_t>(row) * m_columns + column]) {
+                    if (!intersects(item.rect, region) || m_visited[item.id] == m_visit) continue;
+                    m_visited[item.id] = m_visit;
+                    m_candidates.push_back(item.id);
+                }
+            }
+        }
+    }
+    for (uint32_t id : m_oversized) {
+        if (intersects(m_entries[id].rect, region)) m_candidates.push_back(id);
+    }
+    std::sort(m_candidates.begin(), m_candidates.end(),
+              [&](uint32_t a, uint32_t b) { return m_entries[a].order < m_entries[b].order; });
+    for (uint32_t id : m_candidates) result.push_back(m_entries[id].key);
+}
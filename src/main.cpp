@@ -1,11 +1,18 @@
 #include "Application.hpp"
-#include "Logger.hpp"
+#include "utils/Logger.hpp"
+#include "SoftwareEngine.hpp"
+#include "VulkanEngine.hpp"
+#include "utils/MemoryTracker.hpp"
+#include "utils/StartupTimeline.hpp"
+#include "utils/Trace.hpp"
 
 #include <cstdlib>
 #include <stdexcept>
 #include <fstream>
 #include <sstream>
+#include <memory>
 #include <string>
+#include <utility>
 
 std::string readFileContents(const std::string& path) {
     std::ifstream fileStream(path);
@@ -17,13 +24,128 @@ std::string readFileContents(const std::string& path) {
     return buffer.str();
 }
 
-int main() {
+SimdLevel parseSimdLevel(const std::string& name) {
+    if (name == "scalar") return SimdLevel::SCALAR;
+    if (name == "sse2") return SimdLevel::SSE2;
+    if (name == "avx2") return SimdLevel::AVX2;
+    throw std::runtime_error("Unknown SIMD level: " + name);
+}
+
+VkPresentModeKHR parsePresentMode(const std::string& name) {
+    if (name == "fifo") return VK_PRESENT_MODE_FIFO_KHR;
+    if (name == "mailbox") return VK_PRESENT_MODE_MAILBOX_KHR;
+    if (name == "immediate") return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    throw std::runtime_error("Unknown present mode: " + name);
+}
+
+LogLevel parseLogLevel(const std::string& name) {
+    if (name == "debug") return LogLevel::DEBUG;
+    if (name == "info") return LogLevel::INFO;
+    if (name == "warn") return LogLevel::WARN;
+    if (name == "error") return LogLevel::ERROR;
+    throw std::runtime_error("Unknown log level: " + name);
+}
+
+uint32_t parseCount(const std::string& option, const std::string& value) {
+    try {
+        return static_cast<uint32_t>(std::stoul(value));
+    } catch (const std::exception&) {
+        throw std::runtime_error("Invalid value for " + option + ": " + value);
+    }
+}
+
+// Usage: vkui_app [--software[=scalar|sse2|avx2]] [--output frame.ppm]
+//                 [--frames-in-flight N] [--present-mode fifo|mailbox|immediate]
+//                 [--swapchain-images N] [--pace] [--latency-probe] [--hud] [--gpu-cull]
+//                 [--trace trace.json] [--log-level debug|info|warn|error]
+//   --software          draw with the CPU rasterizer instead of Vulkan
+//   --output            render one frame offscreen with the CPU rasterizer, save it and exit
+//   --frames-in-flight  frames recorded ahead of the GPU (1..4, default 2)
+//   --present-mode      swapchain present mode (default: mailbox when supported, else fifo)
+//   --swapchain-images  swapchain image count (default: surface minimum + 1)
+//   --pace              wait for the previous frame before polling input
+//   --latency-probe     log input-to-present latency
+//   --hud               start with the performance overlay shown (F3 toggles it)
+//   --gpu-cull          cull layer draws in a compute pass and draw them indirectly (experimental)
+//   --trace             record pipeline zones; written as Chrome trace JSON on F12 and at exit
+//   --log-level         lowest level logged (default info; debug needs a VKUI_LOG_LEVEL=0 build)
+int main(int argc, char** argv) {
+    StartupTimeline::instance(); // Отсчёт времени до первого кадра
     try {
-        std::string html = readFileContents("demo.html");
-        std::string css = readFileContents("demo.css");
-        
-        Application app{800, 600, "VkUI Engine", html, css};
+        bool software = false;
+        SimdLevel simdLevel = detectSimdLevel();
+        std::string output;
+        PresentConfig present;
+        std::string tracePath;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--software") {
+                software = true;
+            } else if (arg.rfind("--software=", 0) == 0) {
+                software = true;
+                simdLevel = parseSimdLevel(arg.substr(11));
+            } else if (arg == "--output" && i + 1 < argc) {
+                output = argv[++i];
+            } else if (arg == "--frames-in-flight" && i + 1 < argc) {
+                present.framesInFlight = parseCount(arg, argv[++i]);
+            } else if (arg == "--present-mode" && i + 1 < argc) {
+                present.presentMode = parsePresentMode(argv[++i]);
+            } else if (arg == "--swapchain-images" && i + 1 < argc) {
+                present.swapchainImages = parseCount(arg, argv[++i]);
+            } else if (arg == "--pace") {
+                present.paceFrames = true;
+            } else if (arg == "--latency-probe") {
+                present.latencyProbe = true;
+            } else if (arg == "--hud") {
+                present.hud = true;
+            } else if (arg == "--gpu-cull") {
+                present.gpuCulling = true;
+            } else if (arg == "--log-level" && i + 1 < argc) {
+                Log::setLevel(parseLogLevel(argv[++i]));
+            } else if (arg == "--trace" && i + 1 < argc) {
+                tracePath = argv[++i];
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+
+        if (!tracePath.empty()) {
+            TRACE_THREAD("main");
+            Trace::setOutputPath(tracePath);
+            Trace::start();
+        }
+
+        std::string html, css;
+        {
+            StartupTimeline::Phase phase("main", "file load");
+            html = readFileContents("demo.html");
+            css = readFileContents("demo.css");
+        }
+
+        if (!output.empty()) {
+            SoftwareEngine engine(simdLevel);
+            engine.initOffscreen(800, 600, html, css);
+            engine.drawFrame();
+            if (!writePpm(engine.framebuffer(), output)) throw std::runtime_error("Failed to write " + output);
+            Log::info("Frame written to " + output + ".");
+            if (Trace::enabled() && !Trace::flush()) throw std::runtime_error("Failed to write " + tracePath);
+            MemoryTracker::logSummary();
+            return EXIT_SUCCESS;
+        }
+
+        std::unique_ptr<RenderEngine> engine;
+        if (software) {
+            engine = std::make_unique<SoftwareEngine>(simdLevel);
+        } else {
+            engine = std::make_unique<VulkanEngine>(present);
+        }
+        Application app{800, 600, "VkUI Engine", html, css, std::move(engine)};
         app.run();
+        if (Trace::enabled()) {
+            if (!Trace::flush()) throw std::runtime_error("Failed to write " + tracePath);
+            Log::info("Trace written to " + tracePath + ".");
+        }
+        MemoryTracker::logSummary();
     } catch (const std::exception& e) {
         Log::error(e.what());
         return EXIT_FAILURE;
@@ -1,4 +1,6 @@
 #include "parser/CssParser.hpp"
+#include "utils/MemoryTracker.hpp"
+#include "utils/Trace.hpp"
 #include <cctype>
 #include <stdexcept>
 #include <algorithm>
@@ -6,6 +8,8 @@
 CssParser::CssParser(const std::string& source) : m_source(source), m_pos(0) {}
 
 Stylesheet CssParser::parse() {
+    TRACE_ZONE("parse css");
+    MemoryTracker::Scope memory(MemoryStage::STYLESHEET);
     Stylesheet sheet;
     while (!eof()) {
         consumeWhitespace();
@@ -41,14 +45,18 @@ std::vector<Selector> CssParser::parseSelectors() {
 Selector CssParser::parseSelector() {
     Selector selector;
     std::string raw_selector = consumeWhile([](char c) { return c != '{' && c != ',' && !isspace(c); });
-    
-    size_t class_pos = raw_selector.find('.');
-    if (class_pos != std::string::npos) {
-        selector.tagName = raw_selector.substr(0, class_pos);
-        if (selector.tagName.empty()) selector.tagName = "*"; // Handle selectors like .class
-        selector.classes.push_back(raw_selector.substr(class_pos + 1));
-    } else {
-        selector.tagName = raw_selector;
+
+    // Разбираем составной селектор вида tag#id.class1.class2
+    size_t part_end = raw_selector.find_first_of(".#");
+    selector.tagName = raw_selector.substr(0, part_end);
+    if (selector.tagName.empty()) selector.tagName = "*"; // Handle selectors like .class or #id
+    while (part_end != std::string::npos) {
+        char kind = raw_selector[part_end];
+        size_t next = raw_selector.find_first_of(".#", part_end + 1);
+        std::string name = raw_selector.substr(part_end + 1, next == std::string::npos ? std::string::npos : next - part_end - 1);
+        if (kind == '.') selector.classes.push_back(name);
+        else selector.id = name;
+        part_end = next;
     }
     return selector;
 }
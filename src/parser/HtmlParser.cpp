@@ -1,15 +1,20 @@
 #include "parser/HtmlParser.hpp"
-#include "Logger.hpp"
+#include "utils/Logger.hpp"
+#include "utils/MemoryTracker.hpp"
+#include "utils/Trace.hpp"
 
 HtmlParser::HtmlParser(const std::vector<Token>& tokens) : m_tokens(tokens) {}
 
 std::unique_ptr<DomNode> HtmlParser::parse() {
+    TRACE_ZONE("parse html");
+    MemoryTracker::Scope memory(MemoryStage::DOM);
     auto nodes = parseNodes();
     if (nodes.size() == 1) {
         return std::move(nodes[0]);
     } else {
         auto root = std::make_unique<DomNode>(NodeType::ELEMENT_NODE, "root");
         root->children = std::move(nodes);
+        for (auto& child : root->children) child->parent = root.get();
         return root;
     }
 }
@@ -42,10 +47,11 @@ std::unique_ptr<DomNode> HtmlParser::parseNode() {
 
     while (!eof() && (currentToken().type != TokenType::CLOSE_TAG || currentToken().value != tagName)) {
         node->children.push_back(parseNode());
+        node->children.back()->parent = node.get();
     }
 
     if (eof()) {
-        Log::warn("Parser warning: Unclosed tag '" + tagName + "'");
+        Log::warnf("Parser warning: Unclosed tag '%s'", tagName.c_str());
     } else {
         consumeToken();
     }
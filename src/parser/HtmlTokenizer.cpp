@@ -1,9 +1,13 @@
 #include "parser/HtmlTokenizer.hpp"
+#include "utils/MemoryTracker.hpp"
+#include "utils/Trace.hpp"
 #include <cctype>
 
 HtmlTokenizer::HtmlTokenizer(const std::string& source) : m_source(source) {}
 
 std::vector<Token> HtmlTokenizer::tokenize() {
+    TRACE_ZONE("tokenize");
+    MemoryTracker::Scope memory(MemoryStage::TOKENS);
     std::vector<Token> tokens;
     while (!eof()) {
         tokens.push_back(nextToken());
@@ -0,0 +1,68 @@
+#include "parser/InvalidationSet.hpp"
+#include "parser/StyleApplier.hpp"
+#include <algorithm>
+
+InvalidationSet::InvalidationSet(const Stylesheet& stylesheet) {
+    for (size_t ruleIndex = 0; ruleIndex < stylesheet.rules.size(); ++ruleIndex) {
+        for (const auto& selector : stylesheet.rules[ruleIndex].selectors) {
+            for (const auto& className : selector.classes) m_classDeps.insert(className);
+            if (!selector.id.empty()) m_idDeps.insert(selector.id);
+
+            // Каждый селектор попадает ровно в одну корзину — по самому избирательному ключу
+            if (!selector.id.empty()) {
+                m_byId[selector.id].push_back(ruleIndex);
+            } else if (!selector.classes.empty()) {
+                m_byClass[selector.classes.front()].push_back(ruleIndex);
+            } else if (selector.tagName != "*") {
+                m_byTag[selector.tagName].push_back(ruleIndex);
+            } else {
+                m_universal.push_back(ruleIndex);
+            }
+        }
+    }
+}
+
+void InvalidationSet::collectCandidates(const std::unordered_map<std::string, std::vector<size_t>>& buckets,
+                                        const std::string& key, std::vector<size_t>& out) const {
+    auto it = buckets.find(key);
+    if (it != buckets.end()) out.insert(out.end(), it->second.begin(), it->second.end());
+}
+
+PropertyMap InvalidationSet::computeStyle(const DomNode& node, const Stylesheet& stylesheet) const {
+    PropertyMap values;
+    if (node.type != NodeType::ELEMENT_NODE) return values;
+
+    std::vector<size_t> candidates(m_universal);
+    collectCandidates(m_byTag, node.value, candidates);
+    auto idIt = node.attributes.find("id");
+    if (idIt != node.attributes.end()) collectCandidates(m_byId, idIt->second, candidates);
+    auto classIt = node.attributes.find("class");
+    if (classIt != node.attributes.end()) {
+        for (const auto& className : splitClasses(classIt->second)) collectCandidates(m_byClass, className, candidates);
+    }
+
+    // Порядок правил важен для каскада
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (size_t ruleIndex : candidates) {
+        const auto& rule = stylesheet.rules[ruleIndex];
+        for (const auto& selector : rule.selectors) {
+            if (StyleApplier::matches(node, selector)) {
+                for (const auto& declaration : rule.declarations) {
+                    values[declaration.first] = declaration.second;
+                }
+            }
+        }
+    }
+    return values;
+}
+
+bool InvalidationSet::isPaintOnlyProperty(const std::string& name) {
+    // will-change меняет разбиение на слои, но не геометрию боксов
+    return name == "background" || name == "background-color" || name == "color" || name == "will-change";
+}
+
+bool InvalidationSet::isCompositeOnlyProperty(const std::string& name) {
+    return name == "transform" || name == "opacity";
+}
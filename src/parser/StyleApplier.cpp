@@ -24,6 +24,12 @@ bool StyleApplier::matches(const DomNode& node, const Selector& selector) {
         return false;
     }
 
+    // Проверка id
+    if (!selector.id.empty()) {
+        auto it = node.attributes.find("id");
+        if (it == node.attributes.end() || it->second != selector.id) return false;
+    }
+
     // Проверка классов
     if (!selector.classes.empty()) {
         auto it = node.attributes.find("class");
@@ -40,21 +46,27 @@ bool StyleApplier::matches(const DomNode& node, const Selector& selector) {
     return true;
 }
 
-std::unique_ptr<StyledNode> StyleApplier::applyStyles(const DomNode& root, const Stylesheet& stylesheet) {
-    auto styledNode = std::make_unique<StyledNode>(root);
-
+PropertyMap StyleApplier::computeStyle(const DomNode& node, const Stylesheet& stylesheet) {
+    PropertyMap values;
     for (const auto& rule : stylesheet.rules) {
         for (const auto& selector : rule.selectors) {
-            if (matches(root, selector)) {
+            if (matches(node, selector)) {
                 for (const auto& declaration : rule.declarations) {
-                    styledNode->specifiedValues[declaration.first] = declaration.second;
+                    values[declaration.first] = declaration.second;
                 }
             }
         }
     }
+    return values;
+}
+
+std::unique_ptr<StyledNode> StyleApplier::applyStyles(const DomNode& root, const Stylesheet& stylesheet) {
+    auto styledNode = std::make_unique<StyledNode>(root);
+    styledNode->specifiedValues = computeStyle(root, stylesheet);
 
     for (const auto& child : root.children) {
         styledNode->children.push_back(applyStyles(*child, stylesheet));
+        styledNode->children.back()->parent = styledNode.get();
     }
 
     return styledNode;
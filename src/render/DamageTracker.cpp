@@ -0,0 +1,105 @@
+#include "render/DamageTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void DamageTracker::reset(uint32_t width, uint32_t height, size_t imageCount) {
+    m_width = width;
+    m_height = height;
+    m_columns = static_cast<int>((width + TILE - 1) / TILE);
+    m_rows = static_cast<int>((height + TILE - 1) / TILE);
+    size_t tiles = static_cast<size_t>(m_columns) * m_rows;
+    m_pending.tiles.assign(tiles, 0);
+    m_pending.full = false;
+    m_images.assign(imageCount, Mask{std::vector<uint8_t>(tiles, 0), true});
+    m_frameRects.clear();
+    m_frameFull = true;
+}
+
+void DamageTracker::add(const Rect& rect) {
+    if (m_pending.full || rect.width <= 0.0f || rect.height <= 0.0f) return;
+    int c0 = std::max(0, static_cast<int>(std::floor(rect.x / TILE)));
+    int r0 = std::max(0, static_cast<int>(std::floor(rect.y / TILE)));
+    int c1 = std::min(m_columns, static_cast<int>(std::ceil((rect.x + rect.width) / TILE)));
+    int r1 = std::min(m_rows, static_cast<int>(std::ceil((rect.y + rect.height) / TILE)));
+    for (int row = r0; row < r1; ++row) {
+        for (int column = c0; column < c1; ++column) m_pending.tiles[static_cast<size_t>(row) * m_columns + column] = 1;
+    }
+}
+
+void DamageTracker::addFull() {
+    m_pending.full = true;
+}
+
+void DamageTracker::endFrame() {
+    m_frameFull = m_pending.full;
+    if (m_pending.full) {
+        m_frameRects = {{0, 0, m_width, m_height}};
+    } else {
+        toRects(m_pending, m_frameRects);
+    }
+    for (Mask& image : m_images) {
+        if (image.full) continue;
+        if (m_pending.full) {
+            image.full = true;
+            continue;
+        }
+        for (size_t i = 0; i < image.tiles.size(); ++i) image.tiles[i] |= m_pending.tiles[i];
+    }
+    std::fill(m_pending.tiles.begin(), m_pending.tiles.end(), 0);
+    m_pending.full = false;
+}
+
+std::vector<ScreenRect> DamageTracker::takeImageDamage(size_t image, bool& full) {
+    Mask& mask = m_images[image];
+    std::vector<ScreenRect> rects;
+    full = mask.full;
+    if (full) {
+        rects.push_back({0, 0, m_width, m_height});
+    } else {
+        toRects(mask, rects);
+    }
+    std::fill(mask.tiles.begin(), mask.tiles.end(), 0);
+    mask.full = false;
+    return rects;
+}
+
+uint64_t DamageTracker::area(const std::vector<ScreenRect>& rects) {
+    uint64_t pixels = 0;
+    for (const ScreenRect& rect : rects) pixels += static_cast<uint64_t>(rect.width) * rect.height;
+    return pixels;
+}
+
+void DamageTracker::toRects(const Mask& mask, std::vector<ScreenRect>& rects) const {
+    // Отрезки подряд идущих тайлов в строке; одинаковые отрезки соседних строк сливаются
+    // в один прямоугольник. Прямоугольники не пересекаются по построению.
+    struct Run { int c0, c1; size_t rect; };
+    std::vector<Run> previous, current;
+    rects.clear();
+    for (int row = 0; row < m_rows; ++row) {
+        current.clear();
+        const uint8_t* tiles = &mask.tiles[static_cast<size_t>(row) * m_columns];
+        for (int column = 0; column < m_columns;) {
+            if (!tiles[column]) {
+                ++column;
+                continue;
+            }
+            int c0 = column;
+            while (column < m_columns && tiles[column]) ++column;
+            auto above = std::find_if(previous.begin(), previous.end(), [&](const Run& run) { return run.c0 == c0 && run.c1 == column; });
+            if (above != previous.end()) {
+                rects[above->rect].height += TILE;
+                current.push_back({c0, column, above->rect});
+            } else {
+                rects.push_back({c0 * TILE, row * TILE, static_cast<uint32_t>((column - c0) * TILE), TILE});
+                current.push_back({c0, column, rects.size() - 1});
+            }
+        }
+        previous.swap(current);
+    }
+    // Крайние тайлы могут выходить за экран
+    for (ScreenRect& rect : rects) {
+        rect.width = std::min<uint32_t>(rect.width, m_width - rect.x);
+        rect.height = std::min<uint32_t>(rect.height, m_height - rect.y);
+    }
+}
@@ -0,0 +1,190 @@
+#include "render/InstanceCache.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+bool GpuInstance::operator==(const GpuInstance& other) const {
+    return std::memcmp(this, &other, sizeof(GpuInstance)) == 0;
+}
+
+GpuInstance makeInstance(const Rect& rect, const Color& color) {
+    return {{rect.x, rect.y, rect.width, rect.height},
+            {-1.0f, -1.0f, -1.0f, -1.0f},
+            {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f}};
+}
+
+GpuInstance makeInstance(const GlyphQuad& glyph) {
+    GpuInstance instance = makeInstance(glyph.rect, glyph.color);
+    instance.uv[0] = glyph.u0;
+    instance.uv[1] = glyph.v0;
+    instance.uv[2] = glyph.u1;
+    instance.uv[3] = glyph.v1;
+    return instance;
+}
+
+bool isOpaque(const GpuInstance& instance) {
+    return instance.uv[0] < 0.0f && instance.color[3] >= 1.0f;
+}
+
+static Rect bounds(const GpuInstance& instance) {
+    return {instance.rect[0], instance.rect[1], instance.rect[2], instance.rect[3]};
+}
+
+void InstanceCache::begin() {
+    m_frame++;
+    m_stats = InstanceUpdateStats{};
+    m_previousOrder.swap(m_order);
+    m_order.clear();
+    m_previousDraws.swap(m_draws);
+    m_touched.clear();
+    m_damage.clear();
+    m_previousPosition.assign(m_slots.size(), UINT32_MAX);
+    for (size_t i = 0; i < m_previousOrder.size(); ++i) m_previousPosition[m_previousOrder[i]] = static_cast<uint32_t>(i);
+    m_cursor = 0;
+}
+
+void InstanceCache::add(const InstanceKey& key, const GpuInstance& instance) {
+    // Обычно кадр повторяет прошлый: следующий ключ стоит сразу за предыдущим в прошлом порядке,
+    // и хеш-таблица не нужна. После вставки или удаления курсор выравнивается по найденному слоту.
+    uint32_t slot;
+    if (m_cursor < m_previousOrder.size() && m_slotKeys[m_previousOrder[m_cursor]] == key) {
+        slot = m_previousOrder[m_cursor];
+    } else {
+        auto [it, inserted] = m_entries.try_emplace(key, 0);
+        if (inserted) {
+            slot = it->second = allocate();
+            m_slotKeys[slot] = key;
+            write(slot, instance);
+            m_damage.push_back(bounds(instance));
+            m_stats.inserted++;
+            m_slotFrames[slot] = m_frame;
+            m_order.push_back(slot);
+            return;
+        }
+        slot = it->second;
+    }
+
+    if (m_slotFrames[slot] == m_frame) return; // Ключи уникальны в пределах кадра; повтор рисуем один раз
+    if (m_previousPosition[slot] != UINT32_MAX) m_cursor = m_previousPosition[slot] + 1;
+    if (m_slots[slot] != instance) {
+        m_damage.push_back(bounds(m_slots[slot]));
+        m_damage.push_back(bounds(instance));
+        write(slot, instance);
+        m_stats.changed++;
+    } else {
+        m_stats.unchanged++;
+    }
+    m_slotFrames[slot] = m_frame;
+    m_order.push_back(slot);
+}
+
+const InstanceUpdateStats& InstanceCache::end() {
+    // Слоты, не использованные в этом кадре, освобождаются
+    for (uint32_t slot = 0; slot < m_slots.size(); ++slot) {
+        if (m_slotFrames[slot] != 0 && m_slotFrames[slot] != m_frame) {
+            m_entries.erase(m_slotKeys[slot]);
+            m_damage.push_back(bounds(m_slots[slot]));
+            m_slotFrames[slot] = 0;
+            m_freeSlots.push_back(slot);
+            m_stats.removed++;
+        }
+    }
+    if (m_slots.size() >= MIN_COMPACT_SLOTS && m_freeSlots.size() > MAX_HOLE_RATIO * m_slots.size()) compact();
+
+    toRanges(m_touched, m_dirtySlots);
+
+    // Список отрисовки сравниваем поэлементно с прошлым кадром
+    buildDraws();
+    std::vector<uint32_t> changedDraws;
+    for (size_t i = 0; i < m_draws.size(); ++i) {
+        if (i >= m_previousDraws.size() || m_draws[i] != m_previousDraws[i]) changedDraws.push_back(static_cast<uint32_t>(i));
+    }
+    toRanges(changedDraws, m_dirtyDraws);
+
+    for (const InstanceRange& range : m_dirtySlots) m_stats.instanceBytes += range.count * sizeof(GpuInstance);
+    for (const InstanceRange& range : m_dirtyDraws) m_stats.orderBytes += range.count * sizeof(DrawEntry);
+    m_stats.fullUploadBytes = m_entries.size() * sizeof(GpuInstance) + m_draws.size() * sizeof(DrawEntry);
+    return m_stats;
+}
+
+const InstanceUpdateStats& InstanceCache::update(const DisplayList& list, const std::vector<GlyphQuad>& glyphs) {
+    begin();
+    for (const auto& command : list.rects) add({command.key, 0}, makeInstance(command.rect, command.color));
+    for (const auto& glyph : glyphs) add({glyph.key, glyph.glyph + 1}, makeInstance(glyph));
+    return end();
+}
+
+void InstanceCache::buildDraws() {
+    // Непрозрачные — спереди назад, чтобы тест глубины отбрасывал закрытые фрагменты до шейдера;
+    // полупрозрачные и глифы — сзади вперёд поверх них, как того требует смешивание
+    m_draws.clear();
+    m_draws.reserve(m_order.size());
+    for (size_t i = m_order.size(); i-- > 0;) {
+        if (isOpaque(m_slots[m_order[i]])) m_draws.push_back({m_order[i], static_cast<uint32_t>(i)});
+    }
+    m_opaqueCount = m_draws.size();
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        if (!isOpaque(m_slots[m_order[i]])) m_draws.push_back({m_order[i], static_cast<uint32_t>(i)});
+    }
+}
+
+uint32_t InstanceCache::allocate() {
+    if (!m_freeSlots.empty()) {
+        uint32_t slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        return slot;
+    }
+    m_slots.emplace_back();
+    m_slotKeys.emplace_back();
+    m_slotFrames.push_back(0);
+    return static_cast<uint32_t>(m_slots.size() - 1);
+}
+
+void InstanceCache::write(uint32_t slot, const GpuInstance& instance) {
+    m_slots[slot] = instance;
+    m_touched.push_back(slot);
+}
+
+void InstanceCache::compact() {
+    // Переносим живые экземпляры с конца буфера в самые ранние дыры, пока дыры не кончатся
+    std::sort(m_freeSlots.begin(), m_freeSlots.end());
+    std::vector<uint32_t> remap(m_slots.size());
+    for (size_t i = 0; i < remap.size(); ++i) remap[i] = static_cast<uint32_t>(i);
+
+    size_t end = m_slots.size();
+    size_t hole = 0;
+    while (true) {
+        while (end > 0 && m_slotFrames[end - 1] == 0) end--;
+        if (hole >= m_freeSlots.size() || m_freeSlots[hole] >= end) break;
+        uint32_t from = static_cast<uint32_t>(end - 1);
+        uint32_t to = m_freeSlots[hole++];
+        m_slotKeys[to] = m_slotKeys[from];
+        m_slotFrames[to] = m_slotFrames[from];
+        m_slotFrames[from] = 0;
+        m_entries[m_slotKeys[to]] = to;
+        write(to, m_slots[from]);
+        remap[from] = to;
+        m_stats.moved++;
+    }
+    m_slots.resize(end);
+    m_slotKeys.resize(end);
+    m_slotFrames.resize(end);
+    m_freeSlots.clear();
+
+    for (uint32_t& slot : m_order) slot = remap[slot];
+    m_touched.erase(std::remove_if(m_touched.begin(), m_touched.end(), [&](uint32_t slot) { return slot >= end; }),
+                    m_touched.end());
+    m_stats.compacted = true;
+}
+
+void InstanceCache::toRanges(std::vector<uint32_t>& indices, std::vector<InstanceRange>& ranges) {
+    ranges.clear();
+    std::sort(indices.begin(), indices.end());
+    for (size_t i = 0; i < indices.size();) {
+        uint32_t first = indices[i];
+        uint32_t last = first;
+        while (++i < indices.size() && indices[i] <= last + 1) last = indices[i];
+        ranges.push_back({first, last - first + 1});
+    }
+}
@@ -0,0 +1,315 @@
+#include "render/LayerTree.hpp"
+#include "layout/DisplayListOptimizer.hpp"
+#include "utils/MemoryTracker.hpp"
+#include "utils/Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+bool intersects(const Rect& a, const Rect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+bool contains(const Rect& outer, const Rect& inner) {
+    return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width &&
+           inner.y + inner.height <= outer.y + outer.height;
+}
+
+bool empty(const Rect& rect) {
+    return rect.width <= 0.0f || rect.height <= 0.0f;
+}
+
+bool sameRect(const Rect& a, const Rect& b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+Rect intersection(const Rect& a, const Rect& b) {
+    float x0 = std::max(a.x, b.x), y0 = std::max(a.y, b.y);
+    float x1 = std::min(a.x + a.width, b.x + b.width), y1 = std::min(a.y + a.height, b.y + b.height);
+    return x1 > x0 && y1 > y0 ? Rect{x0, y0, x1 - x0, y1 - y0} : Rect{};
+}
+
+void grow(Rect& bounds, const Rect& rect) {
+    if (empty(rect)) return;
+    if (empty(bounds)) {
+        bounds = rect;
+        return;
+    }
+    float x1 = std::max(bounds.x + bounds.width, rect.x + rect.width);
+    float y1 = std::max(bounds.y + bounds.height, rect.y + rect.height);
+    bounds.x = std::min(bounds.x, rect.x);
+    bounds.y = std::min(bounds.y, rect.y);
+    bounds.width = x1 - bounds.x;
+    bounds.height = y1 - bounds.y;
+}
+
+// Окно растра в пределах [lo, hi) длиной не больше MAX_RASTER_SIZE, по возможности с центром в center
+void limitSpan(float& from, float& size, float lo, float hi, float center) {
+    if (size <= LayerTree::MAX_RASTER_SIZE) return;
+    size = LayerTree::MAX_RASTER_SIZE;
+    from = std::clamp(center - size / 2.0f, lo, std::max(lo, hi - size));
+}
+
+// Свой слой получают элементы с подсказкой will-change, сдвигом или прозрачностью
+bool hasLayerHint(const StyledNode& node) {
+    const PropertyMap& values = node.specifiedValues;
+    auto willChange = values.find("will-change");
+    if (willChange != values.end() && willChange->second != "auto") return true;
+    auto transform = values.find("transform");
+    if (transform != values.end() && transform->second != "none") return true;
+    return values.find("opacity") != values.end();
+}
+
+} // namespace
+
+LayerProperties LayerTree::readProperties(const StyledNode* node) {
+    LayerProperties properties;
+    if (!node) return properties;
+
+    auto opacity = node->specifiedValues.find("opacity");
+    if (opacity != node->specifiedValues.end()) {
+        properties.opacity = std::clamp(std::strtof(opacity->second.c_str(), nullptr), 0.0f, 1.0f);
+    }
+
+    // Поддерживаются только сдвиги: translate(x[, y]), translateX(x), translateY(y)
+    auto transform = node->specifiedValues.find("transform");
+    if (transform != node->specifiedValues.end()) {
+        const std::string& value = transform->second;
+        size_t open = value.find('('), close = value.rfind(')');
+        if (open != std::string::npos && close != std::string::npos && close > open) {
+            std::string function = value.substr(0, open);
+            function.erase(function.find_last_not_of(" \t") + 1);
+            std::string arguments = value.substr(open + 1, close - open - 1);
+            size_t comma = arguments.find(',');
+            float first = parse_px(arguments.substr(0, comma), 0.0f);
+            float second = comma != std::string::npos ? parse_px(arguments.substr(comma + 1), 0.0f) : 0.0f;
+            if (function == "translate") {
+                properties.translateX = first;
+                properties.translateY = second;
+            } else if (function == "translateX") {
+                properties.translateX = first;
+            } else if (function == "translateY") {
+                properties.translateY = first;
+            }
+        }
+    }
+    return properties;
+}
+
+void LayerTree::update(const LayoutTree& tree, const Rect& viewport) {
+    std::vector<Layer> previous = std::move(m_layers);
+    m_layers.clear();
+    m_nodeLayers.clear();
+
+    // Прежнее состояние слоя (растр и содержимое) находится по владельцу
+    auto addLayer = [&](const StyledNode* owner, BoxIndex box, const Rect& bounds, uint32_t parent) {
+        Layer layer;
+        for (Layer& old : previous) {
+            if (old.owner == owner) {
+                layer = std::move(old);
+                break;
+            }
+        }
+        layer.owner = owner;
+        layer.box = box;
+        layer.parent = parent;
+        layer.bounds = bounds;
+        layer.properties = readProperties(owner);
+        m_layers.push_back(std::move(layer));
+    };
+
+    // Корневой слой — весь документ, но не меньше экрана
+    Rect documentBounds = {0.0f, 0.0f, viewport.width, viewport.height};
+    if (tree.size() > 0) {
+        const Rect& root = tree.geometry[0];
+        documentBounds.width = std::max(documentBounds.width, root.x + root.width);
+        documentBounds.height = std::max(documentBounds.height, root.y + root.height + tree.boxModels[0].marginBottom);
+    }
+    addLayer(nullptr, 0, documentBounds, 0);
+
+    // Один проход в предварительном порядке: абсолютные координаты и слой берутся у ближайшего предка.
+    // Оценочные поддеревья не рисуются, поэтому и в слои не попадают до своей компоновки
+    struct Origin { BoxIndex end; float x, y; uint32_t layer; };
+    std::vector<Origin> ancestors;
+    for (size_t i = 0; i < tree.size();) {
+        while (!ancestors.empty() && ancestors.back().end <= i) ancestors.pop_back();
+        Rect rect = tree.geometry[i];
+        uint32_t layer = 0;
+        if (!ancestors.empty()) {
+            rect.x += ancestors.back().x;
+            rect.y += ancestors.back().y;
+            layer = ancestors.back().layer;
+        }
+        if (tree.flags[i] & LAYOUT_ESTIMATED) {
+            i = tree.subtreeEnd[i];
+            continue;
+        }
+        const StyledNode* node = tree.styledNodes[i];
+        if (tree.isElement(static_cast<BoxIndex>(i)) && m_layers.size() < MAX_LAYERS && hasLayerHint(*node)) {
+            uint32_t parent = layer;
+            layer = static_cast<uint32_t>(m_layers.size());
+            addLayer(node, static_cast<BoxIndex>(i), Rect{}, parent);
+        }
+        if (layer != 0) {
+            m_nodeLayers[node] = layer;
+            grow(m_layers[layer].bounds, rect);
+        }
+        if (tree.subtreeEnd[i] > i + 1) ancestors.push_back({tree.subtreeEnd[i], rect.x, rect.y, layer});
+        ++i;
+    }
+    composeProperties();
+}
+
+void LayerTree::updateProperties() {
+    for (Layer& layer : m_layers) layer.properties = readProperties(layer.owner);
+    composeProperties();
+}
+
+void LayerTree::composeProperties() {
+    // Родительский слой всегда раньше вложенного: один проход по порядку
+    for (size_t i = 0; i < m_layers.size(); ++i) {
+        Layer& layer = m_layers[i];
+        layer.composed = layer.properties;
+        if (i == 0) continue;
+        const LayerProperties& parent = m_layers[layer.parent].composed;
+        layer.composed.translateX += parent.translateX;
+        layer.composed.translateY += parent.translateY;
+        layer.composed.opacity *= parent.opacity;
+    }
+}
+
+void LayerTree::setLayers(const std::vector<Layer>& layers) {
+    m_layers = layers;
+    m_nodeLayers.clear();
+}
+
+size_t LayerTree::layerOf(const StyledNode* node) const {
+    auto it = m_nodeLayers.find(node);
+    return it != m_nodeLayers.end() ? it->second : 0;
+}
+
+void LayerTree::screenOffset(const Layer& layer, const Rect& viewport, float& dx, float& dy) {
+    // Сдвиг округляется до целых пикселей, чтобы текселы изображения совпадали с пикселями экрана
+    dx = std::round(layer.composed.translateX - viewport.x);
+    dy = std::round(layer.composed.translateY - viewport.y);
+}
+
+bool LayerTree::ownsLayer(const StyledNode* node) const {
+    size_t layer = layerOf(node);
+    return layer != 0 && m_layers[layer].owner == node;
+}
+
+Rect LayerTree::visiblePart(const Layer& layer, const Rect& viewport) {
+    Rect local = {viewport.x - layer.composed.translateX, viewport.y - layer.composed.translateY, viewport.width,
+                  viewport.height};
+    return intersection(layer.bounds, local);
+}
+
+Rect LayerTree::targetRaster(const Layer& layer, const Rect& viewport) const {
+    // Растр покрывает видимую часть и по экрану вокруг неё; слой, умещающийся в изображение, растрируется целиком
+    Rect local = {viewport.x - layer.composed.translateX, viewport.y - layer.composed.translateY, viewport.width,
+                  viewport.height};
+    Rect interest = {local.x - local.width, local.y - local.height, local.width * 3.0f, local.height * 3.0f};
+    if (!intersects(layer.bounds, interest)) return {};
+    bool fits = layer.bounds.width <= MAX_RASTER_SIZE && layer.bounds.height <= MAX_RASTER_SIZE;
+    Rect target = fits ? layer.bounds : intersection(layer.bounds, interest);
+    limitSpan(target.x, target.width, layer.bounds.x, layer.bounds.x + layer.bounds.width, local.x + local.width / 2.0f);
+    limitSpan(target.y, target.height, layer.bounds.y, layer.bounds.y + layer.bounds.height, local.y + local.height / 2.0f);
+
+    // Целые пиксели документа: при целочисленном сдвиге изображение ложится на экран один к одному
+    float x0 = std::floor(target.x), y0 = std::floor(target.y);
+    float x1 = std::min(std::ceil(target.x + target.width), x0 + MAX_RASTER_SIZE);
+    float y1 = std::min(std::ceil(target.y + target.height), y0 + MAX_RASTER_SIZE);
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+bool LayerTree::needsRaster(const Rect& viewport) const {
+    for (const Layer& layer : m_layers) {
+        Rect visible = visiblePart(layer, viewport);
+        if (!empty(visible) && !contains(layer.raster, visible)) return true;
+    }
+    return false;
+}
+
+const LayerPaintStats& LayerTree::paint(const LayoutTree& tree, const Rect& viewport, bool contentChanged) {
+    TRACE_ZONE("paint layers");
+    MemoryTracker::Scope memory(MemoryStage::LAYERS);
+    m_stats = LayerPaintStats{};
+    m_stats.layers = m_layers.size();
+    for (size_t i = 0; i < m_layers.size(); ++i) {
+        Layer& layer = m_layers[i];
+        layer.repainted = false;
+        layer.rasterMoved = false;
+
+        // Растр переезжает, когда видимая часть вышла за него; целиком растрируемый слой
+        // к тому же следует за изменившимися границами
+        Rect visible = visiblePart(layer, viewport);
+        bool stale = !empty(visible) && !contains(layer.raster, visible);
+        Rect target = stale || contentChanged ? targetRaster(layer, viewport) : layer.raster;
+        bool whole = !empty(target) && contains(target, layer.bounds);
+        bool move = !empty(target) && !sameRect(target, layer.raster) && (stale || whole || empty(layer.raster));
+        if (!move && !contentChanged) continue;
+
+        layer.repainted = true;
+        layer.rasterMoved = move;
+        if (move) {
+            layer.raster = target;
+            m_stats.rasterMoves++;
+        }
+        m_stats.repainted++;
+        if (empty(layer.raster)) {
+            layer.content = std::make_shared<const DisplayList>();
+            continue;
+        }
+
+        DisplayList list = buildDisplayList(tree, layer.raster);
+        // Команды вложенных слоёв рисуются в их собственные изображения
+        if (!m_nodeLayers.empty()) {
+            auto foreign = [&](const auto& command) { return layerOf(command.key.node) != i; };
+            list.rects.erase(std::remove_if(list.rects.begin(), list.rects.end(), foreign), list.rects.end());
+            list.texts.erase(std::remove_if(list.texts.begin(), list.texts.end(), foreign), list.texts.end());
+        }
+        OverdrawStats overdraw = optimizeDisplayList(list, layer.raster);
+        m_stats.commandsBefore += overdraw.commandsBefore;
+        m_stats.commandsAfter += overdraw.commandsAfter;
+        layer.content = std::make_shared<const DisplayList>(std::move(list));
+    }
+    return m_stats;
+}
+
+void LayerTree::composite(const Rect& viewport, std::vector<CompositeQuad>& quads, std::vector<Rect>& damage) {
+    quads.clear();
+    damage.clear();
+    const Rect screen = {0.0f, 0.0f, viewport.width, viewport.height};
+
+    std::vector<Placement> placed;
+    for (size_t i = 0; i < m_layers.size(); ++i) {
+        const Layer& layer = m_layers[i];
+        if (empty(layer.raster) || layer.composed.opacity <= 0.0f) continue;
+        float dx, dy;
+        screenOffset(layer, viewport, dx, dy);
+        Rect rect = {layer.raster.x + dx, layer.raster.y + dy, layer.raster.width, layer.raster.height};
+        if (!intersects(rect, screen)) continue;
+        quads.push_back({i, rect, layer.composed.opacity});
+        placed.push_back({layer.owner, rect, layer.composed.opacity});
+    }
+
+    // Повреждения — старое и новое место каждого изменившегося квада
+    for (const Placement& now : placed) {
+        auto old = std::find_if(m_placed.begin(), m_placed.end(), [&](const Placement& p) { return p.owner == now.owner; });
+        if (old == m_placed.end()) {
+            damage.push_back(now.screen);
+        } else if (!sameRect(old->screen, now.screen) || old->opacity != now.opacity) {
+            damage.push_back(old->screen);
+            damage.push_back(now.screen);
+        }
+    }
+    for (const Placement& old : m_placed) {
+        auto now = std::find_if(placed.begin(), placed.end(), [&](const Placement& p) { return p.owner == old.owner; });
+        if (now == placed.end()) damage.push_back(old.screen);
+    }
+    m_placed = std::move(placed);
+}
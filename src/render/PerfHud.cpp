@@ -0,0 +1,131 @@
+#include "render/PerfHud.hpp"
+#include "text/BuiltinFont.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+const float ORIGIN = 8.0f;  // Top-left corner of the panel on screen
+const float PADDING = 6.0f;
+const float BAR_WIDTH = 2.0f;
+const float GRAPH_HEIGHT = 60.0f;
+const float GRAPH_MS = 100.0f / 3.0f; // Top of the graph: two frames at 60 Hz
+const float BUDGET_MS = 50.0f / 3.0f; // One frame at 60 Hz
+const int TEXT_LINES = 7;
+
+constexpr uint32_t rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+const uint32_t PANEL = rgba(0, 0, 0, 190);
+const uint32_t TEXT = rgba(230, 230, 230, 255);
+const uint32_t BUDGET = rgba(255, 255, 255, 90);
+const uint32_t FAST = rgba(80, 200, 80, 255);
+const uint32_t SLOW = rgba(230, 190, 40, 255);
+const uint32_t JANK = rgba(230, 60, 50, 255);
+
+float graphWidth() {
+    return PerfHud::HISTORY * BAR_WIDTH;
+}
+
+float textHeight() {
+    return TEXT_LINES * builtin_font::LINE_HEIGHT;
+}
+
+} // namespace
+
+PerfHud::PerfHud() : m_history(HISTORY, 0.0f) {
+    m_sum.gpuMs = 0.0f;
+}
+
+Rect PerfHud::bounds() const {
+    return {ORIGIN, ORIGIN, graphWidth() + 2 * PADDING, textHeight() + GRAPH_HEIGHT + 3 * PADDING};
+}
+
+void PerfHud::addFrame(const HudFrame& frame) {
+    m_history[m_next] = frame.frameMs;
+    m_next = (m_next + 1) % HISTORY;
+    m_count = std::min(m_count + 1, HISTORY);
+
+    m_sum.frameMs += frame.frameMs;
+    m_sum.applyMs += frame.applyMs;
+    m_sum.waitMs += frame.waitMs;
+    m_sum.recordMs += frame.recordMs;
+    m_sum.submitMs += frame.submitMs;
+    // Кадр без результата таймстемпов в среднее не входит
+    m_sum.gpuMs += std::max(frame.gpuMs, 0.0f);
+    if (frame.gpuMs >= 0.0f) m_gpuSamples++;
+    m_maxMs = std::max(m_maxMs, frame.frameMs);
+    m_last = frame;
+    if (++m_summed >= TEXT_INTERVAL || m_text.empty()) buildText();
+}
+
+const std::vector<HudRect>& PerfHud::build() {
+    m_rects.clear();
+    Rect panel = bounds();
+    m_rects.push_back({{panel.x, panel.y, panel.width, panel.height}, PANEL});
+
+    // Полосы от старых кадров к новым, слева направо; бюджет кадра — линия поперёк
+    float left = panel.x + PADDING, bottom = panel.y + panel.height - PADDING;
+    m_rects.push_back({{left, bottom - GRAPH_HEIGHT * BUDGET_MS / GRAPH_MS, graphWidth(), 1.0f}, BUDGET});
+    for (size_t i = 0; i < m_count; ++i) {
+        float ms = m_history[(m_next + HISTORY - m_count + i) % HISTORY];
+        float height = std::max(1.0f, GRAPH_HEIGHT * std::min(ms, GRAPH_MS) / GRAPH_MS);
+        uint32_t color = ms <= BUDGET_MS * 1.05f ? FAST : ms <= 2.0f * BUDGET_MS * 1.05f ? SLOW : JANK;
+        m_rects.push_back({{left + (HISTORY - m_count + i) * BAR_WIDTH, bottom - height, BAR_WIDTH - 0.5f, height}, color});
+    }
+    m_rects.insert(m_rects.end(), m_text.begin(), m_text.end());
+    return m_rects;
+}
+
+void PerfHud::buildText() {
+    float n = static_cast<float>(std::max<size_t>(m_summed, 1));
+    float frameMs = m_sum.frameMs / n;
+    char lines[TEXT_LINES][64];
+    std::snprintf(lines[0], sizeof(lines[0]), "%5.1f fps %6.2f ms  max %6.2f", frameMs > 0.0f ? 1000.0f / frameMs : 0.0f, frameMs, m_maxMs);
+    if (m_gpuSamples > 0) {
+        std::snprintf(lines[1], sizeof(lines[1]), "gpu %6.2f ms", m_sum.gpuMs / m_gpuSamples);
+    } else {
+        std::snprintf(lines[1], sizeof(lines[1]), "gpu      - ms");
+    }
+    std::snprintf(lines[2], sizeof(lines[2]), "apply %5.2f  wait %5.2f", m_sum.applyMs / n, m_sum.waitMs / n);
+    std::snprintf(lines[3], sizeof(lines[3]), "record %5.2f  submit %5.2f", m_sum.recordMs / n, m_sum.submitMs / n);
+    if (m_last.styleMs >= 0.0f) {
+        std::snprintf(lines[4], sizeof(lines[4]), "style %5.2f layout %5.2f paint %5.2f", m_last.styleMs, m_last.layoutMs, m_last.paintMs);
+    } else {
+        std::snprintf(lines[4], sizeof(lines[4]), "document idle");
+    }
+    std::snprintf(lines[5], sizeof(lines[5]), "draws %u  instances %u", m_last.drawCalls, m_last.instances);
+    std::snprintf(lines[6], sizeof(lines[6]), "gpu memory %.1f MB", m_last.gpuMemoryBytes / (1024.0 * 1024.0));
+
+    m_text.clear();
+    Rect panel = bounds();
+    for (int i = 0; i < TEXT_LINES; ++i) {
+        appendText(panel.x + PADDING, panel.y + PADDING + i * builtin_font::LINE_HEIGHT, lines[i], TEXT);
+    }
+    m_sum = HudFrame{};
+    m_sum.gpuMs = 0.0f;
+    m_summed = m_gpuSamples = 0;
+    m_maxMs = 0.0f;
+}
+
+// Столбец глифа — вертикальные отрезки из подряд идущих пикселей: квадов в разы меньше, чем пикселей
+void PerfHud::appendText(float x, float y, const char* text, uint32_t color) {
+    for (const char* c = text; *c; ++c, x += builtin_font::ADVANCE) {
+        if (*c < builtin_font::FIRST_CHAR || *c > builtin_font::LAST_CHAR) continue;
+        const uint8_t* columns = builtin_font::GLYPHS[*c - builtin_font::FIRST_CHAR];
+        for (int column = 0; column < builtin_font::GLYPH_COLUMNS; ++column) {
+            int row = 0;
+            while (row < builtin_font::GLYPH_ROWS) {
+                if (!(columns[column] & (1 << row))) {
+                    ++row;
+                    continue;
+                }
+                int start = row;
+                while (row < builtin_font::GLYPH_ROWS && (columns[column] & (1 << row))) ++row;
+                m_text.push_back({{x + column, y + start, 1.0f, static_cast<float>(row - start)}, color});
+            }
+        }
+    }
+}
@@ -0,0 +1,220 @@
+#include "render/SoftwareRasterizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VKUI_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+static uint32_t pack(const Color& color) {
+    return color.r | (color.g << 8) | (color.b << 16) | (static_cast<uint32_t>(color.a) << 24);
+}
+
+// Деление на 255 с округлением для t = s * a + d * (255 - a) + 128
+static inline uint32_t div255(uint32_t t) {
+    return (t + (t >> 8)) >> 8;
+}
+
+// Канал альфы смешивается как цвет 255: покрытие над покрытием
+static inline uint32_t blendPixel(uint32_t dst, uint32_t color, uint32_t alpha) {
+    uint32_t inverse = 255 - alpha;
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t source = shift == 24 ? 255 : (color >> shift) & 0xFF;
+        uint32_t target = (dst >> shift) & 0xFF;
+        result |= div255(source * alpha + target * inverse + 128) << shift;
+    }
+    return result;
+}
+
+static void fillSpanScalar(uint32_t* dst, size_t count, uint32_t color) {
+    std::fill_n(dst, count, color);
+}
+
+static void blendSpanScalar(uint32_t* dst, size_t count, uint32_t color) {
+    uint32_t alpha = color >> 24;
+    for (size_t i = 0; i < count; ++i) dst[i] = blendPixel(dst[i], color, alpha);
+}
+
+#ifdef VKUI_X86_SIMD
+// Предумноженный цвет источника плюс 128 для округления, по 16 бит на канал, два пикселя
+static __m128i sourceTerm(uint32_t color) {
+    short alpha = static_cast<short>(color >> 24);
+    short r = static_cast<short>((color & 0xFF) * alpha + 128);
+    short g = static_cast<short>(((color >> 8) & 0xFF) * alpha + 128);
+    short b = static_cast<short>(((color >> 16) & 0xFF) * alpha + 128);
+    short a = static_cast<short>(255 * alpha + 128);
+    return _mm_set_epi16(a, b, g, r, a, b, g, r);
+}
+
+static void fillSpanSse2(uint32_t* dst, size_t count, uint32_t color) {
+    __m128i value = _mm_set1_epi32(static_cast<int>(color));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), value);
+    for (; i < count; ++i) dst[i] = color;
+}
+
+static void blendSpanSse2(uint32_t* dst, size_t count, uint32_t color) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i inverse = _mm_set1_epi16(static_cast<short>(255 - (color >> 24)));
+    const __m128i source = sourceTerm(color);
+    auto blend = [&](__m128i channels) {
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(channels, inverse), source);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    };
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i low = blend(_mm_unpacklo_epi8(pixels, zero));
+        __m128i high = blend(_mm_unpackhi_epi8(pixels, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(low, high));
+    }
+    blendSpanScalar(dst + i, count - i, color);
+}
+
+__attribute__((target("avx2"))) static void fillSpanAvx2(uint32_t* dst, size_t count, uint32_t color) {
+    __m256i value = _mm256_set1_epi32(static_cast<int>(color));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), value);
+    for (; i < count; ++i) dst[i] = color;
+}
+
+__attribute__((target("avx2"))) static void blendSpanAvx2(uint32_t* dst, size_t count, uint32_t color) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i inverse = _mm256_set1_epi16(static_cast<short>(255 - (color >> 24)));
+    const __m256i source = _mm256_broadcastsi128_si256(sourceTerm(color));
+    size_t i = 0;
+    // Распаковка и упаковка работают в пределах 128-битных половин, поэтому порядок пикселей сохраняется
+    for (; i + 8 <= count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i low = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(pixels, zero), inverse), source);
+        __m256i high = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(pixels, zero), inverse), source);
+        low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+        high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(low, high));
+    }
+    blendSpanSse2(dst + i, count - i, color);
+}
+#endif
+
+SimdLevel detectSimdLevel() {
+#ifdef VKUI_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+bool writePpm(const Framebuffer& framebuffer, const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    std::fprintf(file, "P6\n%u %u\n255\n", framebuffer.width, framebuffer.height);
+    std::vector<uint8_t> rgb(framebuffer.pixels.size() * 3);
+    for (size_t i = 0; i < framebuffer.pixels.size(); ++i) {
+        uint32_t pixel = framebuffer.pixels[i];
+        rgb[3 * i] = pixel & 0xFF;
+        rgb[3 * i + 1] = (pixel >> 8) & 0xFF;
+        rgb[3 * i + 2] = (pixel >> 16) & 0xFF;
+    }
+    bool ok = std::fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+SoftwareRasterizer::SoftwareRasterizer(SimdLevel level) : m_level(level), m_fill(fillSpanScalar), m_blend(blendSpanScalar) {
+#ifdef VKUI_X86_SIMD
+    if (level == SimdLevel::AVX2 && __builtin_cpu_supports("avx2")) {
+        m_fill = fillSpanAvx2;
+        m_blend = blendSpanAvx2;
+        return;
+    }
+    if (level != SimdLevel::SCALAR) {
+        m_level = SimdLevel::SSE2;
+        m_fill = fillSpanSse2;
+        m_blend = blendSpanSse2;
+        return;
+    }
+#endif
+    m_level = SimdLevel::SCALAR;
+}
+
+void SoftwareRasterizer::clear(Framebuffer& target, const Color& color) const {
+    m_fill(target.pixels.data(), target.pixels.size(), pack(color));
+}
+
+// Пиксели, чей центр лежит в [from, to), обрезанные границей изображения
+static bool pixelRange(float from, float to, uint32_t limit, int& first, int& last) {
+    first = std::max(0, static_cast<int>(std::ceil(from - 0.5f)));
+    last = std::min(static_cast<int>(limit), static_cast<int>(std::ceil(to - 0.5f)));
+    return first < last;
+}
+
+void SoftwareRasterizer::fillRect(Framebuffer& target, const Rect& rect, const Color& color, RasterStats& stats) const {
+    int x0, x1, y0, y1;
+    if (color.a == 0 || !pixelRange(rect.x, rect.x + rect.width, target.width, x0, x1) ||
+        !pixelRange(rect.y, rect.y + rect.height, target.height, y0, y1)) {
+        return;
+    }
+    uint32_t value = pack(color);
+    size_t count = static_cast<size_t>(x1 - x0);
+    FillSpan span = color.a == 255 ? m_fill : m_blend;
+    for (int y = y0; y < y1; ++y) span(target.row(y) + x0, count, value);
+    (color.a == 255 ? stats.pixelsFilled : stats.pixelsBlended) += count * (y1 - y0);
+    stats.rects++;
+}
+
+void SoftwareRasterizer::drawGlyph(Framebuffer& target, const GlyphQuad& quad, const GlyphAtlas& atlas, float originX,
+                                   float originY, RasterStats& stats) const {
+    Rect rect = {quad.rect.x - originX, quad.rect.y - originY, quad.rect.width, quad.rect.height};
+    int x0, x1, y0, y1;
+    if (quad.color.a == 0 || rect.width <= 0.0f || rect.height <= 0.0f ||
+        !pixelRange(rect.x, rect.x + rect.width, target.width, x0, x1) ||
+        !pixelRange(rect.y, rect.y + rect.height, target.height, y0, y1)) {
+        return;
+    }
+    // Ближайший тексель под центром пикселя; при масштабе 1:1 — ровно тексель глифа
+    const float size = static_cast<float>(GlyphAtlas::SIZE);
+    const int u0 = static_cast<int>(std::lround(quad.u0 * size)), u1 = static_cast<int>(std::lround(quad.u1 * size));
+    const int v0 = static_cast<int>(std::lround(quad.v0 * size)), v1 = static_cast<int>(std::lround(quad.v1 * size));
+    const float du = (u1 - u0) / rect.width, dv = (v1 - v0) / rect.height;
+    const uint8_t* texels = atlas.pixels().data();
+    const uint32_t color = pack(quad.color);
+
+    for (int y = y0; y < y1; ++y) {
+        int v = std::clamp(v0 + static_cast<int>((y + 0.5f - rect.y) * dv), v0, v1 - 1);
+        const uint8_t* texelRow = texels + static_cast<size_t>(v) * GlyphAtlas::SIZE;
+        uint32_t* dst = target.row(y);
+        for (int x = x0; x < x1; ++x) {
+            int u = std::clamp(u0 + static_cast<int>((x + 0.5f - rect.x) * du), u0, u1 - 1);
+            uint32_t alpha = div255(texelRow[u] * quad.color.a + 128);
+            if (alpha == 255) {
+                dst[x] = color;
+            } else if (alpha != 0) {
+                dst[x] = blendPixel(dst[x], color, alpha);
+            }
+        }
+    }
+    stats.pixelsBlended += static_cast<size_t>(x1 - x0) * (y1 - y0);
+    stats.glyphs++;
+}
+
+RasterStats SoftwareRasterizer::draw(Framebuffer& target, const DisplayList& list, const std::vector<GlyphQuad>& glyphs,
+                                     const GlyphAtlas& atlas, float originX, float originY) const {
+    RasterStats stats;
+    for (const SolidRectCommand& command : list.rects) {
+        Rect rect = {command.rect.x - originX, command.rect.y - originY, command.rect.width, command.rect.height};
+        fillRect(target, rect, command.color, stats);
+    }
+    for (const GlyphQuad& glyph : glyphs) drawGlyph(target, glyph, atlas, originX, originY, stats);
+    return stats;
+}
@@ -0,0 +1,181 @@
+#include "render/TileRasterizer.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// 64-битное перемешивание (как в splitmix64) для хеша содержимого тайла
+struct Hasher {
+    uint64_t value = 0x9E3779B97F4A7C15ull;
+
+    void add(uint64_t x) {
+        value ^= x + 0x9E3779B97F4A7C15ull + (value << 6) + (value >> 2);
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    }
+    void add(float x) {
+        uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        add(static_cast<uint64_t>(bits));
+    }
+    void add(const Rect& rect) {
+        add(rect.x);
+        add(rect.y);
+        add(rect.width);
+        add(rect.height);
+    }
+    void add(const Color& color) {
+        add(static_cast<uint64_t>(color.r | (color.g << 8) | (color.b << 16) | (static_cast<uint32_t>(color.a) << 24)));
+    }
+};
+
+// Пиксели, чей центр лежит в [from, to) — то же правило, что у растеризатора
+void pixelSpan(float from, float to, int& first, int& last) {
+    first = static_cast<int>(std::ceil(from - 0.5f));
+    last = static_cast<int>(std::ceil(to - 0.5f));
+}
+
+int tileOf(int pixel) {
+    return pixel >= 0 ? pixel / TileRasterizer::TILE_SIZE : -((-pixel - 1) / TileRasterizer::TILE_SIZE) - 1;
+}
+
+} // namespace
+
+Rect TileRasterizer::tileBounds(const Rect& viewport) {
+    const float size = static_cast<float>(TILE_SIZE);
+    float x0 = std::floor(std::round(viewport.x) / size) * size;
+    float y0 = std::floor(std::round(viewport.y) / size) * size;
+    float x1 = std::ceil((std::round(viewport.x) + viewport.width) / size) * size;
+    float y1 = std::ceil((std::round(viewport.y) + viewport.height) / size) * size;
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+const TileStats& TileRasterizer::draw(Framebuffer& target, const Rect& viewport, const DisplayList& list,
+                                      const std::vector<GlyphQuad>& glyphs, const GlyphAtlas& atlas, const Color& clearColor) {
+    m_frame++;
+    m_stats = TileStats{};
+
+    // Тайлы привязаны к целым пикселям документа, поэтому и окно сдвигается на целые пиксели
+    const int originX = static_cast<int>(std::lround(viewport.x));
+    const int originY = static_cast<int>(std::lround(viewport.y));
+    const int c0 = tileOf(originX), r0 = tileOf(originY);
+    const int c1 = tileOf(originX + static_cast<int>(target.width) - 1);
+    const int r1 = tileOf(originY + static_cast<int>(target.height) - 1);
+    const int columns = c1 - c0 + 1;
+
+    m_visible.clear();
+    for (int row = r0; row <= r1; ++row) {
+        for (int column = c0; column <= c1; ++column) {
+            Tile& tile = m_tiles[key(column, row)];
+            tile.column = column;
+            tile.row = row;
+            tile.lastFrame = m_frame;
+            tile.rects.clear();
+            tile.glyphs.clear();
+            m_visible.push_back(&tile);
+        }
+    }
+
+    // Раскладываем команды по тайлам, которых касаются их пиксели
+    auto bin = [&](const Rect& rect, bool glyph, uint32_t index) {
+        int x0, x1, y0, y1;
+        pixelSpan(rect.x, rect.x + rect.width, x0, x1);
+        pixelSpan(rect.y, rect.y + rect.height, y0, y1);
+        if (x0 >= x1 || y0 >= y1) return;
+        int tc0 = std::max(c0, tileOf(x0)), tc1 = std::min(c1, tileOf(x1 - 1));
+        int tr0 = std::max(r0, tileOf(y0)), tr1 = std::min(r1, tileOf(y1 - 1));
+        for (int row = tr0; row <= tr1; ++row) {
+            for (int column = tc0; column <= tc1; ++column) {
+                Tile& tile = *m_visible[static_cast<size_t>(row - r0) * columns + (column - c0)];
+                (glyph ? tile.glyphs : tile.rects).push_back(index);
+            }
+        }
+    };
+    for (uint32_t i = 0; i < list.rects.size(); ++i) {
+        if (list.rects[i].color.a != 0) bin(list.rects[i].rect, false, i);
+    }
+    for (uint32_t i = 0; i < glyphs.size(); ++i) {
+        if (glyphs[i].color.a != 0) bin(glyphs[i].rect, true, i);
+    }
+
+    // Хеш содержимого: всё, от чего зависят пиксели тайла. Прямоугольники берутся в пределах
+    // тайла — большой фон, обрезанный по-разному в соседних кадрах, не сбрасывает кэш
+    std::vector<Tile*> dirty;
+    for (size_t i = 0; i < m_visible.size(); ++i) {
+        Tile& tile = *m_visible[i];
+        const float tileX = static_cast<float>(tile.column * TILE_SIZE), tileY = static_cast<float>(tile.row * TILE_SIZE);
+        Hasher hasher;
+        hasher.add(clearColor);
+        for (uint32_t index : tile.rects) {
+            const Rect& rect = list.rects[index].rect;
+            float x0 = std::max(rect.x, tileX), y0 = std::max(rect.y, tileY);
+            float x1 = std::min(rect.x + rect.width, tileX + TILE_SIZE), y1 = std::min(rect.y + rect.height, tileY + TILE_SIZE);
+            hasher.add(Rect{x0, y0, x1 - x0, y1 - y0});
+            hasher.add(list.rects[index].color);
+        }
+        if (!tile.glyphs.empty()) hasher.add(atlas.generation());
+        for (uint32_t index : tile.glyphs) {
+            const GlyphQuad& quad = glyphs[index];
+            hasher.add(quad.rect);
+            hasher.add(quad.color);
+            hasher.add(quad.u0);
+            hasher.add(quad.v0);
+            hasher.add(quad.u1);
+            hasher.add(quad.v1);
+        }
+        if (tile.valid && tile.hash == hasher.value) {
+            m_stats.reused++;
+        } else {
+            tile.hash = hasher.value;
+            dirty.push_back(&tile);
+        }
+    }
+    m_stats.visible = m_visible.size();
+    m_stats.rendered = dirty.size();
+
+    auto render = [&](size_t i) {
+        Tile& tile = *dirty[i];
+        if (tile.pixels.width != TILE_SIZE) tile.pixels.resize(TILE_SIZE, TILE_SIZE);
+        const float x = static_cast<float>(tile.column * TILE_SIZE), y = static_cast<float>(tile.row * TILE_SIZE);
+        RasterStats stats;
+        m_rasterizer.clear(tile.pixels, clearColor);
+        for (uint32_t index : tile.rects) {
+            const SolidRectCommand& command = list.rects[index];
+            m_rasterizer.fillRect(tile.pixels, {command.rect.x - x, command.rect.y - y, command.rect.width, command.rect.height},
+                                  command.color, stats);
+        }
+        for (uint32_t index : tile.glyphs) m_rasterizer.drawGlyph(tile.pixels, glyphs[index], atlas, x, y, stats);
+        tile.valid = true;
+    };
+    // Каждый тайл копируется в свою область кадра — потоки не пересекаются
+    auto compose = [&](size_t i) {
+        Tile& tile = *m_visible[i];
+        int x0 = std::max(tile.column * TILE_SIZE, originX);
+        int x1 = std::min((tile.column + 1) * TILE_SIZE, originX + static_cast<int>(target.width));
+        int y0 = std::max(tile.row * TILE_SIZE, originY);
+        int y1 = std::min((tile.row + 1) * TILE_SIZE, originY + static_cast<int>(target.height));
+        for (int y = y0; y < y1; ++y) {
+            const uint32_t* src = tile.pixels.row(static_cast<uint32_t>(y - tile.row * TILE_SIZE)) + (x0 - tile.column * TILE_SIZE);
+            std::memcpy(target.row(static_cast<uint32_t>(y - originY)) + (x0 - originX), src, (x1 - x0) * sizeof(uint32_t));
+        }
+    };
+    if (m_pool && dirty.size() > 1) {
+        m_pool->parallelFor(dirty.size(), render);
+    } else {
+        for (size_t i = 0; i < dirty.size(); ++i) render(i);
+    }
+    if (m_pool) {
+        m_pool->parallelFor(m_visible.size(), compose);
+    } else {
+        for (size_t i = 0; i < m_visible.size(); ++i) compose(i);
+    }
+
+    for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+        it = m_frame - it->second.lastFrame > MAX_IDLE_FRAMES ? m_tiles.erase(it) : std::next(it);
+    }
+    m_stats.cached = m_tiles.size();
+    return m_stats;
+}
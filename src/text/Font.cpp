@@ -0,0 +1,58 @@
+#include "text/Font.hpp"
+#include "text/BuiltinFont.hpp"
+
+#include <cmath>
+
+static constexpr int SUPERSAMPLES = 4;
+
+static float unitsToPixels(float units, float fontSize) {
+    return units * fontSize / builtin_font::GLYPH_ROWS;
+}
+
+float Font::advance(float fontSize) { return unitsToPixels(builtin_font::ADVANCE, fontSize); }
+float Font::ascent(float fontSize) { return unitsToPixels(builtin_font::ASCENT, fontSize); }
+float Font::lineHeight(float fontSize) { return unitsToPixels(builtin_font::LINE_HEIGHT, fontSize); }
+float Font::cellHeight(float fontSize) { return unitsToPixels(builtin_font::GLYPH_ROWS, fontSize); }
+
+float Font::cellTop(float fontSize) {
+    return unitsToPixels((builtin_font::LINE_HEIGHT - builtin_font::GLYPH_ROWS) * 0.5f, fontSize);
+}
+
+char32_t Font::resolve(char32_t codepoint) {
+    if (codepoint < builtin_font::FIRST_CHAR || codepoint > builtin_font::LAST_CHAR) return U'?';
+    return codepoint;
+}
+
+bool Font::isBlank(char32_t codepoint) {
+    return codepoint == U' ' || codepoint == U'\t' || codepoint == U'\n' || codepoint == U'\r';
+}
+
+GlyphBitmap Font::rasterize(char32_t codepoint, int pixelSize) {
+    const uint8_t* columns = builtin_font::GLYPHS[resolve(codepoint) - builtin_font::FIRST_CHAR];
+    float scale = static_cast<float>(pixelSize) / builtin_font::GLYPH_ROWS;
+
+    GlyphBitmap bitmap;
+    bitmap.width = static_cast<int>(std::ceil(builtin_font::GLYPH_COLUMNS * scale));
+    bitmap.height = pixelSize;
+    bitmap.coverage.assign(static_cast<size_t>(bitmap.width) * bitmap.height, 0);
+
+    // Покрытие пикселя — доля подвыборок, попавших в зажжённые точки исходной сетки
+    for (int py = 0; py < bitmap.height; ++py) {
+        for (int px = 0; px < bitmap.width; ++px) {
+            int hits = 0;
+            for (int sy = 0; sy < SUPERSAMPLES; ++sy) {
+                int row = static_cast<int>((py + (sy + 0.5f) / SUPERSAMPLES) / scale);
+                for (int sx = 0; sx < SUPERSAMPLES; ++sx) {
+                    int column = static_cast<int>((px + (sx + 0.5f) / SUPERSAMPLES) / scale);
+                    if (column < builtin_font::GLYPH_COLUMNS && row < builtin_font::GLYPH_ROWS &&
+                        (columns[column] >> row) & 1) {
+                        hits++;
+                    }
+                }
+            }
+            bitmap.coverage[static_cast<size_t>(py) * bitmap.width + px] =
+                static_cast<uint8_t>(hits * 255 / (SUPERSAMPLES * SUPERSAMPLES));
+        }
+    }
+    return bitmap;
+}
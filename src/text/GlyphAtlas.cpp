@@ -0,0 +1,77 @@
+#include "text/GlyphAtlas.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr int SLOTS_PER_ROW = GlyphAtlas::SIZE / GlyphAtlas::SLOT;
+
+GlyphAtlas::GlyphAtlas() : m_pixels(static_cast<size_t>(SIZE) * SIZE, 0) {
+    // Слоты раздаются с конца, чтобы первые глифы легли в верхние строки атласа
+    for (uint32_t slot = SLOTS_PER_ROW * SLOTS_PER_ROW; slot-- > 0;) m_freeSlots.push_back(slot);
+}
+
+const AtlasGlyph* GlyphAtlas::lookup(FontId font, char32_t codepoint, int pixelSize) {
+    pixelSize = std::clamp(pixelSize, 1, MAX_PIXEL_SIZE);
+    uint64_t key = (static_cast<uint64_t>(font) << 48) | (static_cast<uint64_t>(pixelSize) << 32) | codepoint;
+
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_stats.hits++;
+        it->second->lastFrame = m_frame;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return &it->second->glyph;
+    }
+    m_stats.misses++;
+
+    AtlasGlyph glyph;
+    if (!m_freeSlots.empty()) {
+        uint32_t slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        glyph.x = static_cast<uint16_t>((slot % SLOTS_PER_ROW) * SLOT);
+        glyph.y = static_cast<uint16_t>((slot / SLOTS_PER_ROW) * SLOT);
+    } else {
+        // Вытесняем давно не использованный глиф, но не тот, что уже нужен текущему кадру
+        Entry& victim = m_lru.back();
+        if (victim.lastFrame == m_frame) {
+            m_stats.overflows++;
+            return nullptr;
+        }
+        glyph.x = victim.glyph.x;
+        glyph.y = victim.glyph.y;
+        m_entries.erase(victim.key);
+        m_lru.pop_back();
+        m_stats.evictions++;
+        m_generation++;
+    }
+    glyph.pixelSize = pixelSize;
+    upload(Font::rasterize(codepoint, pixelSize), glyph);
+
+    m_lru.push_front({key, glyph, m_frame});
+    m_entries[key] = m_lru.begin();
+    return &m_lru.front().glyph;
+}
+
+void GlyphAtlas::upload(const GlyphBitmap& bitmap, AtlasGlyph& glyph) {
+    glyph.width = static_cast<uint16_t>(std::min(bitmap.width, MAX_PIXEL_SIZE));
+    glyph.height = static_cast<uint16_t>(std::min(bitmap.height, MAX_PIXEL_SIZE));
+    // Слот очищается целиком: от прежнего глифа не должно остаться следов
+    for (int row = 0; row < SLOT; ++row) {
+        uint8_t* dst = &m_pixels[static_cast<size_t>(glyph.y + row) * SIZE + glyph.x];
+        std::memset(dst, 0, SLOT);
+        if (row < glyph.height) std::memcpy(dst, &bitmap.coverage[static_cast<size_t>(row) * bitmap.width], glyph.width);
+    }
+    m_dirtyTop = std::min(m_dirtyTop, static_cast<int>(glyph.y));
+    m_dirtyBottom = std::max(m_dirtyBottom, glyph.y + SLOT);
+}
+
+bool GlyphAtlas::dirtyRows(uint32_t& first, uint32_t& count) const {
+    if (m_dirtyTop >= m_dirtyBottom) return false;
+    first = static_cast<uint32_t>(m_dirtyTop);
+    count = static_cast<uint32_t>(m_dirtyBottom - m_dirtyTop);
+    return true;
+}
+
+void GlyphAtlas::clearDirty() {
+    m_dirtyTop = SIZE;
+    m_dirtyBottom = 0;
+}
@@ -0,0 +1,34 @@
+#include "text/TextMetrics.hpp"
+#include "text/Font.hpp"
+#include "text/TextShaper.hpp"
+
+void TextMetrics::measure(const std::string& text, float size) {
+    words.clear();
+    fontSize = size;
+    float advance = Font::advance(size);
+    spaceWidth = advance;
+
+    // Возможности переноса — только пробельные символы
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t next = pos;
+        char32_t codepoint = decodeUtf8(text, next);
+        if (Font::isBlank(codepoint)) {
+            pos = next;
+            continue;
+        }
+        TextWord word{static_cast<uint32_t>(pos), 0, 0.0f};
+        size_t glyphs = 0;
+        while (pos < text.size()) {
+            next = pos;
+            if (Font::isBlank(decodeUtf8(text, next))) break;
+            pos = next;
+            glyphs++;
+        }
+        word.end = static_cast<uint32_t>(pos);
+        word.width = glyphs * advance;
+        words.push_back(word);
+    }
+    leadingSpace = !text.empty() && (words.empty() || words.front().begin > 0);
+    trailingSpace = !text.empty() && (words.empty() || words.back().end < text.size());
+}
@@ -0,0 +1,45 @@
+#include "text/TextPainter.hpp"
+#include "utils/Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void TextPainter::paint(const std::vector<TextCommand>& commands, std::vector<GlyphQuad>& quads) {
+    TRACE_ZONE("text paint");
+    m_atlas.beginFrame();
+    constexpr float texel = 1.0f / GlyphAtlas::SIZE;
+
+    for (const auto& command : commands) {
+        const ShapedRun& run = m_shaper.shape(command.text, BUILTIN_FONT, command.fontSize);
+        // Растеризуем в ближайшем целом размере; большие кегли растягиваются из предельного
+        int pixelSize = std::clamp(static_cast<int>(std::lround(Font::cellHeight(command.fontSize))), 1, GlyphAtlas::MAX_PIXEL_SIZE);
+        float scale = Font::cellHeight(command.fontSize) / pixelSize;
+        // Привязка к пиксельной сетке сохраняет чёткость растра
+        float originX = std::round(command.rect.x);
+        float originY = std::round(command.rect.y + Font::cellTop(command.fontSize));
+
+        for (size_t n = 0; n < run.glyphs.size(); ++n) {
+            const ShapedGlyph& shaped = run.glyphs[n];
+            float x = originX + std::round(shaped.x);
+            if (x >= command.rect.x + command.rect.width) break;
+            const AtlasGlyph* glyph = m_atlas.lookup(BUILTIN_FONT, shaped.codepoint, pixelSize);
+            if (!glyph) continue;
+
+            GlyphQuad quad;
+            quad.rect = {x, originY, glyph->width * scale, glyph->height * scale};
+            quad.u0 = glyph->x * texel;
+            quad.v0 = glyph->y * texel;
+            quad.u1 = (glyph->x + glyph->width) * texel;
+            quad.v1 = (glyph->y + glyph->height) * texel;
+            quad.color = command.color;
+            quad.key = command.key;
+            quad.glyph = static_cast<uint32_t>(n);
+            quads.push_back(quad);
+        }
+    }
+}
+
+void TextPainter::resetStats() {
+    m_atlas.resetStats();
+    m_shaper.resetStats();
+}
@@ -0,0 +1,51 @@
+#include "text/TextShaper.hpp"
+
+#include <functional>
+
+char32_t decodeUtf8(const std::string& text, size_t& pos) {
+    auto byte = [&](size_t i) { return static_cast<uint8_t>(text[i]); };
+    uint8_t lead = byte(pos);
+    int length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+    if (length == 0 || pos + length > text.size()) {
+        pos++;
+        return U'?';
+    }
+    char32_t codepoint = length == 1 ? lead : lead & (0xFF >> (length + 1));
+    for (int k = 1; k < length; ++k) codepoint = (codepoint << 6) | (byte(pos + k) & 0x3F);
+    pos += length;
+    return codepoint;
+}
+
+const ShapedRun& TextShaper::shape(const std::string& text, FontId font, float fontSize) {
+    uint64_t hash = std::hash<std::string>{}(text);
+    hash ^= (static_cast<uint64_t>(font) << 32 | std::hash<float>{}(fontSize)) + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+
+    auto it = m_entries.find(hash);
+    if (it != m_entries.end()) {
+        Entry& entry = *it->second;
+        if (entry.fontSize == fontSize && entry.font == font && entry.text == text) {
+            m_stats.hits++;
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            return entry.run;
+        }
+        // Коллизия хэшей: старую запись просто вытесняем
+        m_lru.erase(it->second);
+        m_entries.erase(it);
+    }
+    m_stats.misses++;
+
+    ShapedRun run;
+    float advance = Font::advance(fontSize);
+    forEachCollapsed(text, [&](char32_t codepoint) {
+        if (!Font::isBlank(codepoint)) run.glyphs.push_back({Font::resolve(codepoint), run.width});
+        run.width += advance;
+    });
+
+    if (m_lru.size() >= m_capacity) {
+        m_entries.erase(m_lru.back().hash);
+        m_lru.pop_back();
+    }
+    m_lru.push_front({hash, text, font, fontSize, std::move(run)});
+    m_entries[hash] = m_lru.begin();
+    return m_lru.front().run;
+}
@@ -0,0 +1,29 @@
+#include "utils/LatencyProbe.hpp"
+
+#include <algorithm>
+
+void LatencyProbe::input(Clock::time_point time) {
+    if (m_pending) return;
+    m_pending = true;
+    m_firstInput = time;
+}
+
+void LatencyProbe::presented(Clock::time_point time) {
+    if (!m_pending) return;
+    m_pending = false;
+    m_samplesMs.push_back(std::chrono::duration<double, std::milli>(time - m_firstInput).count());
+}
+
+LatencyProbe::Summary LatencyProbe::summary() const {
+    Summary summary;
+    summary.samples = m_samplesMs.size();
+    if (m_samplesMs.empty()) return summary;
+    std::vector<double> sorted = m_samplesMs;
+    std::sort(sorted.begin(), sorted.end());
+    for (double ms : sorted) summary.meanMs += ms;
+    summary.meanMs /= sorted.size();
+    summary.p50Ms = sorted[sorted.size() / 2];
+    summary.p99Ms = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+    summary.maxMs = sorted.back();
+    return summary;
+}
@@ -0,0 +1,249 @@
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int64_t REPEAT_WINDOW_NS = 1000000000;
+
+struct Record {
+    int64_t ns;
+    uint32_t tid;
+    uint32_t length;
+    LogLevel level;
+    char text[Log::MAX_MESSAGE];
+};
+
+// Сообщения одного потока. Пишет только он сам; читает тот, кто держит мьютекс вывода
+struct ThreadRing {
+    static const size_t CAPACITY = 512;
+    static const size_t REPEAT_SLOTS = 64;
+
+    struct Repeat {
+        uint64_t hash = 0;
+        int64_t windowStart = 0;
+        unsigned count = 0, suppressed = 0;
+    };
+
+    uint32_t tid = 0;
+    std::unique_ptr<Record[]> records{new Record[CAPACITY]};
+    std::atomic<uint64_t> head{0}, tail{0};
+    Repeat repeats[REPEAT_SLOTS];
+};
+
+// После разрушения состояния (статические деструкторы на выходе) сообщения пишутся напрямую
+std::atomic<bool> g_shutdown{false};
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO:  return "INFO";
+        case LogLevel::WARN:  return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+    }
+    return "";
+}
+
+const char* levelColor(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "\033[36m"; // Cyan
+        case LogLevel::INFO:  return "\033[32m"; // Green
+        case LogLevel::WARN:  return "\033[33m"; // Yellow
+        case LogLevel::ERROR: return "\033[31m"; // Red
+    }
+    return "";
+}
+
+uint64_t hashText(const char* text, size_t length) {
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < length; ++i) hash = (hash ^ static_cast<unsigned char>(text[i])) * 1099511628211ull;
+    return hash;
+}
+
+class LogState {
+public:
+    static LogState& instance() {
+        static LogState state;
+        return state;
+    }
+
+    ~LogState() {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+        drain();
+        g_shutdown.store(true, std::memory_order_release);
+    }
+
+    int64_t now() const { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_origin).count(); }
+
+    ThreadRing& threadRing() {
+        thread_local ThreadRing* t_ring = nullptr;
+        if (!t_ring) {
+            std::lock_guard<std::mutex> lock(m_registryMutex);
+            m_registry.push_back(std::make_unique<ThreadRing>());
+            t_ring = m_registry.back().get();
+            t_ring->tid = static_cast<uint32_t>(m_registry.size());
+        }
+        return *t_ring;
+    }
+
+    void push(ThreadRing& ring, LogLevel level, int64_t ns, const char* text, size_t length) {
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        // Кольцо полно — ждём вывода, а не теряем сообщения: память ограничена, порядок сохранён
+        while (head - ring.tail.load(std::memory_order_acquire) >= ThreadRing::CAPACITY) {
+            wake();
+            std::this_thread::yield();
+        }
+        Record& record = ring.records[head % ThreadRing::CAPACITY];
+        record.ns = ns;
+        record.tid = ring.tid;
+        record.level = level;
+        record.length = static_cast<uint32_t>(std::min(length, Log::MAX_MESSAGE));
+        std::memcpy(record.text, text, record.length);
+        if (length > Log::MAX_MESSAGE) std::memcpy(record.text + Log::MAX_MESSAGE - 3, "...", 3);
+        ring.head.store(head + 1, std::memory_order_release);
+        if (level >= LogLevel::WARN || head + 1 - ring.tail.load(std::memory_order_relaxed) >= ThreadRing::CAPACITY / 2) wake();
+    }
+
+    void wake() {
+        m_wakeRequested.store(true, std::memory_order_relaxed);
+        m_wake.notify_one();
+    }
+
+    // Все кольца — на stdout, по времени сообщений
+    void drain() {
+        std::lock_guard<std::mutex> lock(m_drainMutex);
+        {
+            std::lock_guard<std::mutex> registryLock(m_registryMutex);
+            m_rings.clear();
+            for (const auto& ring : m_registry) m_rings.push_back(ring.get());
+        }
+        m_batch.clear();
+        m_heads.clear();
+        for (ThreadRing* ring : m_rings) {
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            for (uint64_t i = tail; i < head; ++i) m_batch.push_back(&ring->records[i % ThreadRing::CAPACITY]);
+            m_heads.push_back(head);
+        }
+        if (m_batch.empty()) return;
+        std::stable_sort(m_batch.begin(), m_batch.end(), [](const Record* a, const Record* b) { return a->ns < b->ns; });
+        for (const Record* record : m_batch) {
+            std::fprintf(stdout, "%s[%s] %.6f T%u: %.*s\033[0m\n", levelColor(record->level), levelName(record->level), record->ns / 1e9,
+                         record->tid, static_cast<int>(record->length), record->text);
+        }
+        std::fflush(stdout);
+        for (size_t i = 0; i < m_rings.size(); ++i) m_rings[i]->tail.store(m_heads[i], std::memory_order_release);
+    }
+
+private:
+    LogState() : m_origin(Clock::now()) {
+        m_rings.reserve(64);
+        m_batch.reserve(ThreadRing::CAPACITY * 4);
+        m_thread = std::thread([this] { run(); });
+    }
+
+    void run() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_wakeMutex);
+                // Без срочных сообщений вывод идёт пачками не реже раза в 10 мс
+                m_wake.wait_for(lock, std::chrono::milliseconds(10), [&] { return m_stopping || m_wakeRequested.load(std::memory_order_relaxed); });
+                m_wakeRequested.store(false, std::memory_order_relaxed);
+                if (m_stopping) return;
+            }
+            drain();
+        }
+    }
+
+    const Clock::time_point m_origin;
+    std::mutex m_registryMutex;
+    std::vector<std::unique_ptr<ThreadRing>> m_registry;
+
+    std::mutex m_drainMutex; // Held by whoever reads the rings
+    std::vector<ThreadRing*> m_rings;
+    std::vector<const Record*> m_batch;
+    std::vector<uint64_t> m_heads;
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<bool> m_wakeRequested{false};
+    bool m_stopping = false;
+    std::thread m_thread;
+};
+
+} // namespace
+
+// Повтор узнаётся по месту вызова у *f-вариантов и по тексту у остальных. Отброшенный повтор
+// у *f-вариантов не стоит даже форматирования
+static bool admit(LogState& state, ThreadRing& ring, LogLevel level, uint64_t hash, int64_t now) {
+    ThreadRing::Repeat& repeat = ring.repeats[(hash ^ (hash >> 29)) % ThreadRing::REPEAT_SLOTS];
+    if (repeat.hash == hash && now - repeat.windowStart < REPEAT_WINDOW_NS) {
+        if (repeat.count >= Log::REPEAT_LIMIT) {
+            repeat.suppressed++;
+            return false;
+        }
+        repeat.count++;
+        return true;
+    }
+    if (repeat.suppressed > 0) {
+        char note[64];
+        int length = std::snprintf(note, sizeof(note), "(%u similar messages suppressed)", repeat.suppressed);
+        state.push(ring, level, now, note, static_cast<size_t>(length));
+    }
+    repeat = {hash, now, 1, 0};
+    return true;
+}
+
+void Log::vformat(LogLevel level, const char* format, va_list args) {
+    char buffer[MAX_MESSAGE + 1];
+    if (g_shutdown.load(std::memory_order_acquire)) {
+        std::vsnprintf(buffer, sizeof(buffer), format, args);
+        write(level, buffer, std::strlen(buffer));
+        return;
+    }
+    LogState& state = LogState::instance();
+    ThreadRing& ring = state.threadRing();
+    int64_t now = state.now();
+    if (!admit(state, ring, level, reinterpret_cast<uintptr_t>(format), now)) return;
+    int length = std::vsnprintf(buffer, sizeof(buffer), format, args);
+    if (length < 0) return;
+    // Отрезанный хвост помечается многоточием
+    if (static_cast<size_t>(length) > MAX_MESSAGE) std::memcpy(buffer + MAX_MESSAGE - 3, "...", 3);
+    state.push(ring, level, now, buffer, std::min(static_cast<size_t>(length), MAX_MESSAGE));
+    // Ошибка может оказаться последним, что успеет сделать процесс
+    if (level == LogLevel::ERROR) state.drain();
+}
+
+void Log::write(LogLevel level, const char* text, size_t length) {
+    if (g_shutdown.load(std::memory_order_acquire)) {
+        std::fprintf(stdout, "%s[%s] %.*s\033[0m\n", levelColor(level), levelName(level), static_cast<int>(length), text);
+        return;
+    }
+    LogState& state = LogState::instance();
+    ThreadRing& ring = state.threadRing();
+    int64_t now = state.now();
+    if (!admit(state, ring, level, hashText(text, length), now)) return;
+    state.push(ring, level, now, text, length);
+    if (level == LogLevel::ERROR) state.drain();
+}
+
+void Log::flush() {
+    if (g_shutdown.load(std::memory_order_acquire)) return;
+    LogState::instance().drain();
+}
@@ -0,0 +1,152 @@
+#include "utils/MemoryTracker.hpp"
+#include "utils/Logger.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+
+// Нулевая инициализация статическая: счётчики готовы до первого operator new
+struct Counters {
+    std::atomic<uint64_t> allocations{0}, frees{0};
+    std::atomic<uint64_t> allocatedBytes{0};
+    std::atomic<uint64_t> liveBytes{0}, peakBytes{0};
+};
+
+Counters g_stages[static_cast<size_t>(MemoryStage::COUNT)];
+Counters g_total;
+Counters g_gpu[static_cast<size_t>(GpuMemoryKind::COUNT)];
+Counters g_gpuTotal;
+
+const double MB = 1024.0 * 1024.0;
+
+void raisePeak(std::atomic<uint64_t>& peak, uint64_t value) {
+    uint64_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void add(Counters& counters, uint64_t size) {
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    raisePeak(counters.peakBytes, counters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+}
+
+void remove(Counters& counters, uint64_t size) {
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+MemoryStats snapshot(const Counters& counters) {
+    MemoryStats stats;
+    stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+    stats.frees = counters.frees.load(std::memory_order_relaxed);
+    stats.allocatedBytes = counters.allocatedBytes.load(std::memory_order_relaxed);
+    stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+GpuMemoryStats gpuSnapshot(const Counters& counters) {
+    GpuMemoryStats stats;
+    stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+    stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace
+
+void MemoryTracker::allocated(MemoryStage stage, size_t size) {
+    // Первая же аллокация через хуки означает, что учёт кучи собран в программу
+    if (!s_enabled.load(std::memory_order_relaxed)) s_enabled.store(true, std::memory_order_relaxed);
+    add(g_stages[static_cast<size_t>(stage)], size);
+    add(g_total, size);
+}
+
+void MemoryTracker::freed(MemoryStage stage, size_t size) {
+    remove(g_stages[static_cast<size_t>(stage)], size);
+    remove(g_total, size);
+}
+
+void MemoryTracker::gpuAllocated(GpuMemoryKind kind, uint64_t size) {
+    add(g_gpu[static_cast<size_t>(kind)], size);
+    add(g_gpuTotal, size);
+}
+
+void MemoryTracker::gpuFreed(GpuMemoryKind kind, uint64_t size) {
+    remove(g_gpu[static_cast<size_t>(kind)], size);
+    remove(g_gpuTotal, size);
+}
+
+MemoryStats MemoryTracker::stats(MemoryStage stage) {
+    return snapshot(g_stages[static_cast<size_t>(stage)]);
+}
+
+MemoryStats MemoryTracker::total() {
+    return snapshot(g_total);
+}
+
+GpuMemoryStats MemoryTracker::gpuStats(GpuMemoryKind kind) {
+    return gpuSnapshot(g_gpu[static_cast<size_t>(kind)]);
+}
+
+GpuMemoryStats MemoryTracker::gpuTotal() {
+    return gpuSnapshot(g_gpuTotal);
+}
+
+const char* MemoryTracker::name(MemoryStage stage) {
+    switch (stage) {
+        case MemoryStage::OTHER:        return "other";
+        case MemoryStage::TOKENS:       return "tokens";
+        case MemoryStage::DOM:          return "dom";
+        case MemoryStage::STYLESHEET:   return "stylesheet";
+        case MemoryStage::STYLE:        return "styled tree";
+        case MemoryStage::LAYOUT:       return "layout tree";
+        case MemoryStage::DISPLAY_LIST: return "display list";
+        case MemoryStage::LAYERS:       return "layers";
+        case MemoryStage::COUNT:        break;
+    }
+    return "";
+}
+
+const char* MemoryTracker::name(GpuMemoryKind kind) {
+    switch (kind) {
+        case GpuMemoryKind::BUFFER:        return "buffers";
+        case GpuMemoryKind::TEXTURE:       return "textures";
+        case GpuMemoryKind::LAYER_SURFACE: return "layer surfaces";
+        case GpuMemoryKind::COUNT:         break;
+    }
+    return "";
+}
+
+// Строки таблицы логируются текстом: все они из одного места вызова, и *f-варианты
+// посчитали бы их повторами
+static void logRow(const char* format, ...) {
+    char line[128];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    Log::info(line);
+}
+
+void MemoryTracker::logSummary() {
+    if (enabled()) {
+        Log::info("Heap by stage (allocations, allocated MB, live MB, peak MB):");
+        for (size_t i = 0; i <= static_cast<size_t>(MemoryStage::COUNT); ++i) {
+            bool isTotal = i == static_cast<size_t>(MemoryStage::COUNT);
+            MemoryStats s = isTotal ? total() : stats(static_cast<MemoryStage>(i));
+            logRow("  %-14s %10llu %10.2f %10.2f %10.2f", isTotal ? "total" : name(static_cast<MemoryStage>(i)),
+                   static_cast<unsigned long long>(s.allocations), s.allocatedBytes / MB, s.liveBytes / MB, s.peakBytes / MB);
+        }
+    }
+    if (gpuTotal().allocations == 0) return;
+    Log::info("GPU memory (allocations, live MB, peak MB):");
+    for (size_t i = 0; i <= static_cast<size_t>(GpuMemoryKind::COUNT); ++i) {
+        bool isTotal = i == static_cast<size_t>(GpuMemoryKind::COUNT);
+        GpuMemoryStats s = isTotal ? gpuTotal() : gpuStats(static_cast<GpuMemoryKind>(i));
+        logRow("  %-14s %10llu %10.2f %10.2f", isTotal ? "total" : name(static_cast<GpuMemoryKind>(i)),
+               static_cast<unsigned long long>(s.allocations), s.liveBytes / MB, s.peakBytes / MB);
+    }
+}
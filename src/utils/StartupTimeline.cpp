@@ -0,0 +1,46 @@
+#include "utils/StartupTimeline.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+StartupTimeline& StartupTimeline::instance() {
+    static StartupTimeline timeline;
+    return timeline;
+}
+
+double StartupTimeline::offsetMs(Clock::time_point time) const {
+    return std::chrono::duration<double, std::milli>(time - m_origin).count();
+}
+
+double StartupTimeline::elapsedMs() const {
+    return offsetMs(Clock::now());
+}
+
+void StartupTimeline::record(const char* track, const char* name, Clock::time_point start, Clock::time_point end) {
+    if (m_finished.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.push_back({track, name, offsetMs(start), offsetMs(end) - offsetMs(start)});
+}
+
+void StartupTimeline::finish() {
+    if (m_finished.exchange(true)) return;
+    double firstFrame = elapsedMs();
+    std::vector<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entries.swap(m_entries);
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.startMs < b.startMs; });
+
+    Log::info("--- Startup timeline ---");
+    for (const Entry& entry : entries) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "%8.2f ms  +%7.2f ms  %-9s %s", entry.startMs, entry.durationMs, entry.track, entry.name);
+        Log::info(line);
+    }
+    char line[64];
+    std::snprintf(line, sizeof(line), "Time to first frame: %.2f ms.", firstFrame);
+    Log::info(line);
+}
@@ -0,0 +1,87 @@
+#include "utils/ThreadPool.hpp"
+#include "utils/Trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace {
+thread_local const ThreadPool* t_pool = nullptr;
+thread_local size_t t_threadIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) threadCount = 1;
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_workers.emplace_back([this, i] {
+            t_pool = this;
+            t_threadIndex = i + 1;
+            workerLoop();
+        });
+    }
+}
+
+size_t ThreadPool::threadIndex() const {
+    return t_pool == this ? t_threadIndex : 0;
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    for (auto& worker : m_workers) worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    TRACE_THREAD("pool worker");
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_stopping && m_tasks.empty()) return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+
+    // Индексы раздаются через атомарный счётчик; вызывающий поток тоже работает
+    struct Job {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        explicit Job(size_t n) : remaining(n) {}
+    };
+    auto job = std::make_shared<Job>(count);
+    auto run = [job, count, &fn] {
+        for (size_t i = job->next++; i < count; i = job->next++) {
+            fn(i);
+            if (--job->remaining == 0) {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                job->done.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(count - 1, m_workers.size());
+    for (size_t i = 0; i < helpers; ++i) submit(run);
+    run();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done.wait(lock, [&] { return job->remaining == 0; });
+}
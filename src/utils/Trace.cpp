@@ -0,0 +1,109 @@
+#include "utils/Trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Буферы живут до конца процесса: завершившийся поток оставляет свои зоны в трассе
+std::mutex g_registryMutex;
+std::string g_outputPath;
+std::vector<std::unique_ptr<Trace::ThreadBuffer>>& registry() {
+    static std::vector<std::unique_ptr<Trace::ThreadBuffer>> buffers;
+    return buffers;
+}
+
+// Отсчёт для перевода тиков во время: скорость тиков меряется по steady_clock от него до записи
+struct Origin {
+    uint64_t ticks = Trace::now();
+    std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+};
+const Origin g_origin;
+
+} // namespace
+
+Trace::ThreadBuffer& Trace::registerThread() {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    auto& buffers = registry();
+    buffers.push_back(std::make_unique<ThreadBuffer>());
+    t_buffer = buffers.back().get();
+    t_buffer->tid = static_cast<uint32_t>(buffers.size());
+    t_buffer->name = "thread " + std::to_string(t_buffer->tid);
+    return *t_buffer;
+}
+
+void Trace::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    buffer.name = name;
+}
+
+void Trace::setOutputPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    g_outputPath = path;
+}
+
+bool Trace::flush() {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        path = g_outputPath;
+    }
+    return !path.empty() && write(path);
+}
+
+uint64_t Trace::recordedZones() {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    uint64_t total = 0;
+    for (const auto& buffer : registry()) total += buffer->head.load(std::memory_order_acquire);
+    return total;
+}
+
+bool Trace::write(const std::string& path) {
+    struct Row {
+        uint32_t tid;
+        ThreadBuffer::Event event;
+    };
+    std::vector<Row> rows;
+    std::vector<std::pair<uint32_t, std::string>> threads;
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        for (const auto& buffer : registry()) {
+            threads.emplace_back(buffer->tid, buffer->name);
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t first = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+            size_t begin = rows.size();
+            for (uint64_t i = first; i < head; ++i) rows.push_back({buffer->tid, buffer->events[i % RING_CAPACITY]});
+            // Поток писал, пока мы копировали: зоны, которые он успел затереть, отбрасываем
+            uint64_t after = buffer->head.load(std::memory_order_acquire);
+            uint64_t overwritten = after > RING_CAPACITY ? after - RING_CAPACITY : 0;
+            if (overwritten > first) rows.erase(rows.begin() + begin, rows.begin() + begin + std::min(overwritten, head) - first);
+        }
+    }
+
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    uint64_t ticks = now() - g_origin.ticks;
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - g_origin.time).count();
+    double nsPerTick = ticks > 0 ? elapsedNs / ticks : 1.0;
+    uint64_t origin = rows.empty() ? 0 : std::min_element(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+                                              return a.event.start < b.event.start;
+                                          })->event.start;
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (const auto& thread : threads) {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n",
+                     thread.first, thread.second.c_str());
+        first = false;
+    }
+    for (const Row& row : rows) {
+        std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n", row.event.name,
+                     row.tid, (row.event.start - origin) * nsPerTick / 1000.0, row.event.duration * nsPerTick / 1000.0);
+        first = false;
+    }
+    std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return std::fclose(file) == 0;
+}